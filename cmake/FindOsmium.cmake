@@ -33,6 +33,10 @@
 #      geos       - include if you want to use any of the GEOS functions
 #      gdal       - include if you want to use any of the OGR functions
 #      lz4        - include support for LZ4 compression of PBF files
+#      zstd       - include support for zstd compression of PBF files
+#      lzma       - include support for reading lzma compressed PBF files
+#      io_uring   - use io_uring for reading and writing uncompressed files
+#                   (Linux only, needs kernel headers from Linux 5.6 or newer)
 #
 #    You can check for success with something like this:
 #
@@ -108,6 +112,18 @@ if(Osmium_USE_OGR)
     set(Osmium_USE_GDAL TRUE)
 endif()
 
+#----------------------------------------------------------------------
+# Component 'io_uring'
+if(Osmium_USE_IO_URING)
+    include(CheckCXXSymbolExists)
+    check_cxx_symbol_exists(IORING_FEAT_RW_CUR_POS "linux/io_uring.h" OSMIUM_HAVE_IO_URING)
+    if(OSMIUM_HAVE_IO_URING)
+        add_definitions(-DOSMIUM_WITH_IO_URING)
+    else()
+        message(WARNING "Osmium: Can not find io_uring kernel headers (Linux 5.6 or newer), io_uring will not be used.")
+    endif()
+endif()
+
 #----------------------------------------------------------------------
 # Component 'pbf'
 if(Osmium_USE_PBF)
@@ -120,16 +136,30 @@ if(Osmium_USE_PBF)
         add_definitions(-DOSMIUM_WITH_LZ4)
     endif()
 
+    if(Osmium_USE_ZSTD)
+        find_package(ZSTD REQUIRED)
+        add_definitions(-DOSMIUM_WITH_ZSTD)
+    endif()
+
+    if(Osmium_USE_LZMA)
+        find_package(LibLZMA REQUIRED)
+        add_definitions(-DOSMIUM_WITH_LZMA)
+    endif()
+
     list(APPEND OSMIUM_EXTRA_FIND_VARS ZLIB_FOUND Threads_FOUND PROTOZERO_INCLUDE_DIR)
     if(ZLIB_FOUND AND Threads_FOUND AND PROTOZERO_FOUND)
         list(APPEND OSMIUM_PBF_LIBRARIES
             ${ZLIB_LIBRARIES}
             ${LZ4_LIBRARIES}
+            ${ZSTD_LIBRARIES}
+            ${LIBLZMA_LIBRARIES}
             ${CMAKE_THREAD_LIBS_INIT}
         )
         list(APPEND OSMIUM_INCLUDE_DIRS
             ${ZLIB_INCLUDE_DIR}
             ${LZ4_INCLUDE_DIRS}
+            ${ZSTD_INCLUDE_DIRS}
+            ${LIBLZMA_INCLUDE_DIRS}
             ${PROTOZERO_INCLUDE_DIR}
         )
     else()
@@ -35,18 +35,25 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/area/assembler_config.hpp>
 #include <osmium/area/detail/basic_assembler_with_tags.hpp>
+#include <osmium/area/detail/node_ref_segment.hpp>
 #include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/detail/vector.hpp>
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -60,6 +67,96 @@ namespace osmium {
          */
         class Assembler : public detail::BasicAssemblerWithTags {
 
+            // Closed ways with up to this many nodes are checked whether
+            // they can be turned into an area without the full assembly.
+            enum : std::size_t {
+                max_simple_way_nodes = 64
+            };
+
+            /**
+             * Fast path for the common case of a closed way which is a
+             * valid ring already: All locations valid and different
+             * (except for the first and last node which are the same),
+             * and no segments intersecting each other. The area is built
+             * directly from the nodes of the way. The result (and the
+             * statistics) are the same as from the full assembly: The
+             * ring starts at the node with the smallest location and is
+             * oriented counter-clockwise.
+             *
+             * @returns false if this is not such a simple case, nothing
+             *          is done then.
+             */
+            bool create_simple_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way) {
+                const auto& nodes = way.nodes();
+                const std::size_t num_segments = nodes.size() - 1;
+                if (num_segments < 3 || num_segments >= max_simple_way_nodes ||
+                    nodes.front().location() != nodes.back().location()) {
+                    return false;
+                }
+
+                std::array<osmium::Location, max_simple_way_nodes> locations;
+                std::size_t min_node = 0;
+                int64_t sum = 0;
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    const auto location = nodes[i].location();
+                    if (!location.valid()) {
+                        return false;
+                    }
+                    locations[i] = location;
+                    if (location < nodes[min_node].location()) {
+                        min_node = i;
+                    }
+                    sum += detail::vec{location} * detail::vec{nodes[i + 1].location()};
+                }
+
+                if (sum == 0) {
+                    return false;
+                }
+
+                std::sort(locations.begin(), locations.begin() + num_segments);
+                if (std::adjacent_find(locations.begin(), locations.begin() + num_segments) != locations.begin() + num_segments) {
+                    return false;
+                }
+
+                std::array<detail::NodeRefSegment, max_simple_way_nodes> segments;
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    segments[i] = detail::NodeRefSegment{nodes[i], nodes[i + 1], detail::role_type::outer, &way};
+                }
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    for (std::size_t j = i + 1; j < num_segments; ++j) {
+                        if (!detail::outside_x_range(segments[j], segments[i]) &&
+                            !detail::outside_x_range(segments[i], segments[j]) &&
+                            detail::y_range_overlap(segments[i], segments[j]) &&
+                            detail::calculate_intersection(segments[i], segments[j])) {
+                            return false;
+                        }
+                    }
+                }
+
+                ++stats().area_simple_case;
+                stats().nodes += num_segments;
+                stats().outer_rings = 1;
+
+                {
+                    osmium::builder::AreaBuilder builder{out_buffer};
+                    builder.initialize_from_object(way);
+                    builder.add_item(way.tags());
+
+                    osmium::builder::OuterRingBuilder ring_builder{builder};
+                    // The way goes counter-clockwise if the sum is positive.
+                    const std::size_t step = sum > 0 ? 1 : num_segments - 1;
+                    std::size_t n = min_node;
+                    do {
+                        ring_builder.add_node_ref(nodes[n]);
+                        n = (n + step) % num_segments;
+                    } while (n != min_node);
+                    ring_builder.add_node_ref(nodes[min_node]);
+                }
+
+                out_buffer.commit();
+                return true;
+            }
+
             bool create_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way) {
                 osmium::builder::AreaBuilder builder{out_buffer};
                 builder.initialize_from_object(way);
@@ -142,6 +239,10 @@ namespace osmium {
                 }
 
                 ++stats().from_ways;
+                if (way.ends_have_same_id() && config().debug_level == 0 && create_simple_area(out_buffer, way)) {
+                    return true;
+                }
+
                 stats().invalid_locations = segment_list().extract_segments_from_way(config().problem_reporter,
                                                                                      stats().duplicate_nodes,
                                                                                      way);
@@ -55,8 +55,6 @@ DEALINGS IN THE SOFTWARE.
 #include <iostream>
 #include <iterator>
 #include <list>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -159,12 +157,19 @@ namespace osmium {
                 // The rings we are building from the segments
                 std::list<ProtoRing> m_rings;
 
+                // Rings no longer in use. They are kept (with the memory
+                // for their segments) to be reused for new rings.
+                std::list<ProtoRing> m_spare_rings;
+
                 // All node locations
                 std::vector<slocation> m_locations;
 
                 // All locations where more than two segments start/end
                 std::vector<Location> m_split_locations;
 
+                // Used in check_inner_outer_roles()
+                std::vector<std::pair<const osmium::Way*, const ProtoRing*>> m_way_rings;
+
                 // Statistics
                 area_stats m_stats;
 
@@ -185,8 +190,7 @@ namespace osmium {
                         std::cerr << "    Checking inner/outer roles\n";
                     }
 
-                    std::unordered_map<const osmium::Way*, const ProtoRing*> way_rings;
-                    std::unordered_set<const osmium::Way*> ways_in_multiple_rings;
+                    m_way_rings.clear();
 
                     for (const ProtoRing& ring : m_rings) {
                         for (const auto& segment : ring.segments()) {
@@ -207,24 +211,27 @@ namespace osmium {
                                 }
                             }
 
-                            auto& r = way_rings[segment->way()];
-                            if (!r) {
-                                r = &ring;
-                            } else if (r != &ring) {
-                                ways_in_multiple_rings.insert(segment->way());
-                            }
-
+                            m_way_rings.emplace_back(segment->way(), &ring);
                         }
                     }
 
-                    for (const osmium::Way* way : ways_in_multiple_rings) { // NOLINT(bugprone-nondeterministic-pointer-iteration-order)
-                        ++m_stats.ways_in_multiple_rings;
-                        if (debug()) {
-                            std::cerr << "      Way " << way->id() << " is in multiple rings\n";
-                        }
-                        if (m_config.problem_reporter) {
-                            m_config.problem_reporter->report_way_in_multiple_rings(*way);
+                    // Find ways with segments in more than one ring.
+                    std::sort(m_way_rings.begin(), m_way_rings.end());
+                    for (auto it = m_way_rings.cbegin(); it != m_way_rings.cend();) {
+                        const osmium::Way* way = it->first;
+                        const auto end = std::find_if(it, m_way_rings.cend(), [way](const std::pair<const osmium::Way*, const ProtoRing*>& way_ring) {
+                            return way_ring.first != way;
+                        });
+                        if (it->second != std::prev(end)->second) {
+                            ++m_stats.ways_in_multiple_rings;
+                            if (debug()) {
+                                std::cerr << "      Way " << way->id() << " is in multiple rings\n";
+                            }
+                            if (m_config.problem_reporter) {
+                                m_config.problem_reporter->report_way_in_multiple_rings(*way);
+                            }
                         }
+                        it = end;
                     }
 
                 }
@@ -280,6 +287,10 @@ namespace osmium {
 
                 using rings_stack = std::vector<rings_stack_element>;
 
+                // Used in find_enclosing_ring(), kept as member to reuse
+                // the memory.
+                rings_stack m_outer_rings;
+
                 static void remove_duplicates(rings_stack& outer_rings) {
                     while (true) {
                         const auto it = std::adjacent_find(outer_rings.begin(), outer_rings.end());
@@ -307,7 +318,8 @@ namespace osmium {
 
                     int nesting = 0;
 
-                    rings_stack outer_rings;
+                    rings_stack& outer_rings = m_outer_rings;
+                    outer_rings.clear();
                     while (segment >= &m_segment_list.front()) {
                         if (!segment->is_direction_done()) {
                             --segment;
@@ -408,6 +420,16 @@ namespace osmium {
                     return std::find(m_split_locations.cbegin(), m_split_locations.cend(), location) != m_split_locations.cend();
                 }
 
+                ProtoRing* create_ring(NodeRefSegment* segment) {
+                    if (m_spare_rings.empty()) {
+                        m_rings.emplace_back(segment);
+                    } else {
+                        m_rings.splice(m_rings.end(), m_spare_rings, m_spare_rings.begin());
+                        m_rings.back().reset(segment);
+                    }
+                    return &m_rings.back();
+                }
+
                 uint32_t add_new_ring(const slocation& node) {
                     NodeRefSegment* segment = &m_segment_list[node.item];
                     assert(!segment->is_done());
@@ -427,8 +449,7 @@ namespace osmium {
                     }
                     segment->mark_direction_done();
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = create_ring(segment);
                     if (outer_ring) {
                         if (debug()) {
                             std::cerr << "    This is an inner ring. Outer ring is " << *outer_ring << "\n";
@@ -478,8 +499,7 @@ namespace osmium {
                         segment->reverse();
                     }
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = create_ring(segment);
 
                     const osmium::Location& first_location = node.location(m_segment_list);
                     osmium::Location last_location = segment->stop().location();
@@ -522,8 +542,15 @@ namespace osmium {
                         m_locations.emplace_back(n, true);
                     }
 
-                    std::stable_sort(m_locations.begin(), m_locations.end(), [this](const slocation& lhs, const slocation& rhs) {
-                        return lhs.location(m_segment_list) < rhs.location(m_segment_list);
+                    // Same order as a stable sort by location, but std::sort
+                    // doesn't need a temporary buffer.
+                    std::sort(m_locations.begin(), m_locations.end(), [this](const slocation& lhs, const slocation& rhs) {
+                        const auto lhs_location = lhs.location(m_segment_list);
+                        const auto rhs_location = rhs.location(m_segment_list);
+                        if (lhs_location != rhs_location) {
+                            return lhs_location < rhs_location;
+                        }
+                        return std::make_pair(lhs.item, lhs.reverse) < std::make_pair(rhs.item, rhs.reverse);
                     });
                 }
 
@@ -655,7 +682,7 @@ namespace osmium {
                     }
 
                     open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r2));
-                    m_rings.erase(r2);
+                    m_spare_rings.splice(m_spare_rings.end(), m_rings, r2);
 
                     if (r1->closed()) {
                         open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r1));
@@ -1005,6 +1032,21 @@ namespace osmium {
                     return m_segment_list;
                 }
 
+                /**
+                 * Clear all state from assembling an area, so that the
+                 * assembler can be used for the next one. Memory that was
+                 * allocated for segments, rings, and so on is kept and
+                 * reused.
+                 */
+                void reset() noexcept {
+                    m_segment_list.clear();
+                    m_spare_rings.splice(m_spare_rings.end(), m_rings);
+                    m_locations.clear();
+                    m_split_locations.clear();
+                    m_stats = area_stats{};
+                    m_num_members = 0;
+                }
+
                 /**
                  * Append each outer ring together with its inner rings to the
                  * area in the buffer.
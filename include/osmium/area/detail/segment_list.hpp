@@ -44,11 +44,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <iterator>
 #include <numeric>
+#include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -89,6 +92,19 @@ namespace osmium {
 
                 bool m_debug;
 
+                // Lists with at least this many segments are checked for
+                // intersections using a grid, smaller lists are checked
+                // with a simple sweep.
+                enum : std::size_t {
+                    min_segments_for_grid = 1000
+                };
+
+                struct intersection_type {
+                    uint32_t first;
+                    uint32_t second;
+                    osmium::Location location;
+                };
+
                 static role_type parse_role(const char* role) noexcept {
                     if (role[0] == '\0') {
                         return role_type::empty;
@@ -142,6 +158,172 @@ namespace osmium {
                     return invalid_locations;
                 }
 
+                void report_intersection(ProblemReporter* problem_reporter, const NodeRefSegment& s1, const NodeRefSegment& s2, const osmium::Location intersection) const {
+                    if (m_debug) {
+                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                    }
+                    if (problem_reporter) {
+                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
+                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                    }
+                }
+
+                /**
+                 * Find intersections by sweeping over the sorted segments
+                 * from west to east and checking each segment against all
+                 * following segments overlapping it in the x direction.
+                 * This is fast as long as only few segments overlap in the
+                 * x direction. Intersections are reported in the order of
+                 * the segments.
+                 */
+                uint32_t find_intersections_sweep(ProblemReporter* problem_reporter) const {
+                    uint32_t found_intersections = 0;
+
+                    for (auto it1 = m_segments.cbegin(); it1 != m_segments.cend() - 1; ++it1) {
+                        const NodeRefSegment& s1 = *it1;
+                        for (auto it2 = it1 + 1; it2 != m_segments.end(); ++it2) {
+                            const NodeRefSegment& s2 = *it2;
+
+                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+
+                            if (outside_x_range(s2, s1)) {
+                                break;
+                            }
+
+                            if (y_range_overlap(s1, s2)) {
+                                const osmium::Location intersection{calculate_intersection(s1, s2)};
+                                if (intersection) {
+                                    ++found_intersections;
+                                    report_intersection(problem_reporter, s1, s2, intersection);
+                                }
+                            }
+                        }
+                    }
+
+                    return found_intersections;
+                }
+
+                /**
+                 * Find intersections using a uniform grid over the bounding
+                 * box of all segments. The sweep degrades to quadratic
+                 * runtime on large areas where many segments overlap in
+                 * the x direction, the grid doesn't.
+                 *
+                 * Each segment is added to all grid cells its bounding box
+                 * overlaps. A pair of segments is only checked in the cell
+                 * containing the lower left corner of the intersection of
+                 * their bounding boxes, so no pair is checked twice. The
+                 * intersections found are reported in the same order as
+                 * find_intersections_sweep() would report them.
+                 */
+                uint32_t find_intersections_grid(ProblemReporter* problem_reporter) const {
+                    int64_t min_x = m_segments.front().first().location().x();
+                    int64_t max_x = min_x;
+                    int64_t min_y = m_segments.front().first().location().y();
+                    int64_t max_y = min_y;
+                    for (const auto& segment : m_segments) {
+                        const std::pair<int32_t, int32_t> y = std::minmax(segment.first().location().y(), segment.second().location().y());
+                        min_x = std::min<int64_t>(min_x, segment.first().location().x());
+                        max_x = std::max<int64_t>(max_x, segment.second().location().x());
+                        min_y = std::min<int64_t>(min_y, y.first);
+                        max_y = std::max<int64_t>(max_y, y.second);
+                    }
+
+                    // Choose the cell size so that there are about as many
+                    // cells as segments, but never more than that many cells
+                    // in one direction.
+                    const auto num_segments = static_cast<double>(m_segments.size());
+                    const auto width = static_cast<double>(max_x - min_x + 1);
+                    const auto height = static_cast<double>(max_y - min_y + 1);
+                    const double cell_size = std::max({1.0, std::sqrt(width * height / num_segments), width / num_segments, height / num_segments});
+                    const auto cell = static_cast<int64_t>(std::ceil(cell_size));
+                    const auto cols = static_cast<std::size_t>((max_x - min_x) / cell + 1);
+                    const auto rows = static_cast<std::size_t>((max_y - min_y) / cell + 1);
+
+                    const auto col_of = [&](int64_t x) {
+                        return static_cast<std::size_t>((x - min_x) / cell);
+                    };
+                    const auto row_of = [&](int64_t y) {
+                        return static_cast<std::size_t>((y - min_y) / cell);
+                    };
+
+                    // Calls func(cell_index) for all cells the bounding box
+                    // of the segment overlaps.
+                    const auto for_each_cell = [&](const NodeRefSegment& segment, auto&& func) {
+                        const std::pair<int32_t, int32_t> y = std::minmax(segment.first().location().y(), segment.second().location().y());
+                        const auto col_end = col_of(segment.second().location().x()) + 1;
+                        const auto row_end = row_of(y.second) + 1;
+                        for (auto row = row_of(y.first); row < row_end; ++row) {
+                            for (auto col = col_of(segment.first().location().x()); col < col_end; ++col) {
+                                func(row * cols + col);
+                            }
+                        }
+                    };
+
+                    // Segment indexes in each cell in ascending order,
+                    // stored in one vector with offsets for each cell.
+                    std::vector<std::size_t> offsets(rows * cols + 1, 0);
+                    for (const auto& segment : m_segments) {
+                        for_each_cell(segment, [&](std::size_t n) {
+                            ++offsets[n + 1];
+                        });
+                    }
+                    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                    std::vector<uint32_t> cell_segments(offsets.back());
+                    {
+                        std::vector<std::size_t> fill{offsets.begin(), offsets.end() - 1};
+                        uint32_t i = 0;
+                        for (const auto& segment : m_segments) {
+                            for_each_cell(segment, [&](std::size_t n) {
+                                cell_segments[fill[n]++] = i;
+                            });
+                            ++i;
+                        }
+                    }
+
+                    std::vector<intersection_type> intersections;
+                    for (std::size_t n = 0; n < rows * cols; ++n) {
+                        const auto begin = cell_segments.cbegin() + static_cast<std::ptrdiff_t>(offsets[n]);
+                        const auto end = cell_segments.cbegin() + static_cast<std::ptrdiff_t>(offsets[n + 1]);
+                        for (auto it1 = begin; it1 != end; ++it1) {
+                            const NodeRefSegment& s1 = m_segments[*it1];
+                            for (auto it2 = std::next(it1); it2 != end; ++it2) {
+                                const NodeRefSegment& s2 = m_segments[*it2];
+
+                                assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+
+                                // s1 comes before s2 in the sorted list, so
+                                // s2 doesn't start west of s1.
+                                if (outside_x_range(s2, s1) || !y_range_overlap(s1, s2)) {
+                                    continue;
+                                }
+
+                                const auto y1 = std::min(s1.first().location().y(), s1.second().location().y());
+                                const auto y2 = std::min(s2.first().location().y(), s2.second().location().y());
+                                if (row_of(std::max(y1, y2)) * cols + col_of(s2.first().location().x()) != n) {
+                                    continue;
+                                }
+
+                                const osmium::Location intersection{calculate_intersection(s1, s2)};
+                                if (intersection) {
+                                    intersections.push_back(intersection_type{*it1, *it2, intersection});
+                                }
+                            }
+                        }
+                    }
+
+                    std::sort(intersections.begin(), intersections.end(), [](const intersection_type& a, const intersection_type& b) {
+                        return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+                    });
+
+                    for (const auto& intersection : intersections) {
+                        report_intersection(problem_reporter, m_segments[intersection.first], m_segments[intersection.second], intersection.location);
+                    }
+
+                    return static_cast<uint32_t>(intersections.size());
+                }
+
             public:
 
                 explicit SegmentList(bool debug) noexcept :
@@ -211,6 +393,11 @@ namespace osmium {
                     m_debug = debug;
                 }
 
+                /// Remove all segments from the list. The memory is kept.
+                void clear() noexcept {
+                    m_segments.clear();
+                }
+
                 /// Sort the list of segments.
                 void sort() {
                     std::sort(m_segments.begin(), m_segments.end());
@@ -309,47 +496,24 @@ namespace osmium {
                 }
 
                 /**
-                 * Find intersection between segments.
+                 * Find intersection between segments. The segments must be
+                 * sorted. Large lists of segments are checked using a grid,
+                 * small lists with a simple sweep. The result is the same.
                  *
                  * @param problem_reporter Any intersections found are
                  *                         reported to this object.
-                 * @returns true if there are intersections.
+                 * @returns The number of intersections found.
                  */
                 uint32_t find_intersections(ProblemReporter* problem_reporter) const {
                     if (m_segments.empty()) {
                         return 0;
                     }
 
-                    uint32_t found_intersections = 0;
-
-                    for (auto it1 = m_segments.cbegin(); it1 != m_segments.cend() - 1; ++it1) {
-                        const NodeRefSegment& s1 = *it1;
-                        for (auto it2 = it1 + 1; it2 != m_segments.end(); ++it2) {
-                            const NodeRefSegment& s2 = *it2;
-
-                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
-
-                            if (outside_x_range(s2, s1)) {
-                                break;
-                            }
-
-                            if (y_range_overlap(s1, s2)) {
-                                const osmium::Location intersection{calculate_intersection(s1, s2)};
-                                if (intersection) {
-                                    ++found_intersections;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
-                                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
-                                }
-                            }
-                        }
+                    if (m_segments.size() >= min_segments_for_grid) {
+                        return find_intersections_grid(problem_reporter);
                     }
 
-                    return found_intersections;
+                    return find_intersections_sweep(problem_reporter);
                 }
 
             }; // class SegmentList
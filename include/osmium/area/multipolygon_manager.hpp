@@ -34,7 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/area/stats.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
@@ -45,12 +47,19 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -60,6 +69,71 @@ namespace osmium {
      */
     namespace area {
 
+        namespace detail {
+
+            /**
+             * Assemblers with a public reset() function can be used to
+             * assemble many areas one after the other.
+             */
+            template <typename TAssembler, typename = void>
+            struct is_reusable_assembler : std::false_type {
+            };
+
+            template <typename TAssembler>
+            struct is_reusable_assembler<TAssembler, decltype(std::declval<TAssembler&>().reset(), void())> : std::true_type {
+            };
+
+            /**
+             * Hands out an assembler for each area. Reusable assemblers
+             * are kept and reused, others are created anew each time.
+             * The config is not stored here but given to every call, so
+             * the owner of the config can be moved.
+             */
+            template <typename TAssembler, bool reusable = is_reusable_assembler<TAssembler>::value>
+            class assembler_source {
+
+            public:
+
+                template <typename... TArgs>
+                void assemble(const typename TAssembler::config_type& config, area_stats& stats, TArgs&&... args) {
+                    TAssembler assembler{config};
+                    assembler(std::forward<TArgs>(args)...);
+                    stats += assembler.stats();
+                }
+
+            }; // class assembler_source
+
+            template <typename TAssembler>
+            class assembler_source<TAssembler, true> {
+
+                // Created on first use. Held through a pointer, because
+                // reusable assemblers are usually not movable.
+                std::unique_ptr<TAssembler> m_assembler;
+
+                // The config the assembler was created with. The assembler
+                // keeps a reference to it, so it is created anew if the
+                // config is a different object, for instance because the
+                // owner of the config was moved. Only used for comparison.
+                const typename TAssembler::config_type* m_config = nullptr;
+
+            public:
+
+                template <typename... TArgs>
+                void assemble(const typename TAssembler::config_type& config, area_stats& stats, TArgs&&... args) {
+                    if (m_assembler && m_config == &config) {
+                        m_assembler->reset();
+                    } else {
+                        m_assembler.reset(new TAssembler{config});
+                        m_config = &config;
+                    }
+                    (*m_assembler)(std::forward<TArgs>(args)...);
+                    stats += m_assembler->stats();
+                }
+
+            }; // class assembler_source
+
+        } // namespace detail
+
         /**
          * This class collects all data needed for creating areas from
          * relations tagged with type=multipolygon or type=boundary.
@@ -67,7 +141,14 @@ namespace osmium {
          * osmium::relations::RelationsManager.
          *
          * The actual assembling of the areas is done by the assembler
-         * class given as template argument.
+         * class given as template argument. Usually this happens right
+         * when a relation is complete or a closed way is seen. If
+         * enable_parallel_assembly() was called, the areas are assembled
+         * on a thread pool instead. The output is the same in both cases.
+         *
+         * Assemblers with a public reset() function (such as the
+         * ReusableAssembler) are created once and reused for all areas
+         * (or, with parallel assembly, for all areas in a batch).
          *
          * @tparam TAssembler Multipolygon Assembler class.
          * @pre The Ids of all objects must be unique in the input data.
@@ -78,10 +159,121 @@ namespace osmium {
             using assembler_config_type = typename TAssembler::config_type;
             assembler_config_type m_assembler_config;
 
+            detail::assembler_source<TAssembler> m_assembler_source;
+
             area_stats m_stats;
 
             osmium::TagsFilter m_filter;
 
+            // The rest is only used for parallel assembly.
+
+            enum : std::size_t {
+                max_jobs_per_batch = 1000,
+                batch_buffer_size = 1024UL * 1024UL
+            };
+
+            struct assembly_result {
+                osmium::memory::Buffer buffer;
+                area_stats stats;
+            };
+
+            osmium::thread::Pool* m_pool = nullptr;
+
+            // Copies of the relations (each followed by its member ways)
+            // and closed ways to be assembled in the next task.
+            osmium::memory::Buffer m_batch;
+            std::size_t m_batch_jobs = 0;
+
+            std::deque<std::future<assembly_result>> m_pending;
+            std::size_t m_max_pending = 0;
+
+            static void assemble_relation(detail::assembler_source<TAssembler>& source, const assembler_config_type& config, const osmium::Relation& relation, const std::vector<const osmium::Way*>& ways, osmium::memory::Buffer& buffer, area_stats& stats) {
+                try {
+                    source.assemble(config, stats, relation, ways, buffer);
+                } catch (const osmium::invalid_location&) {
+                    // XXX ignore
+                }
+            }
+
+            static void assemble_way(detail::assembler_source<TAssembler>& source, const assembler_config_type& config, const osmium::Way& way, osmium::memory::Buffer& buffer, area_stats& stats) {
+                try {
+                    source.assemble(config, stats, way, buffer);
+                } catch (const osmium::invalid_location&) {
+                    // XXX ignore
+                }
+            }
+
+            // This runs in the thread pool.
+            static assembly_result assemble_batch(const assembler_config_type& config, const osmium::memory::Buffer& batch) {
+                assembly_result result{osmium::memory::Buffer{batch_buffer_size, osmium::memory::Buffer::auto_grow::yes}, area_stats{}};
+                detail::assembler_source<TAssembler> source;
+                std::vector<const osmium::Way*> ways;
+
+                for (auto it = batch.cbegin(); it != batch.cend();) {
+                    if (it->type() == osmium::item_type::relation) {
+                        const auto& relation = static_cast<const osmium::Relation&>(*it);
+                        ++it;
+                        ways.clear();
+                        for (const auto& member : relation.members()) {
+                            if (member.ref() != 0) {
+                                assert(it != batch.cend() && it->type() == osmium::item_type::way);
+                                ways.push_back(static_cast<const osmium::Way*>(&*it));
+                                ++it;
+                            }
+                        }
+                        assemble_relation(source, config, relation, ways, result.buffer, result.stats);
+                    } else {
+                        assemble_way(source, config, static_cast<const osmium::Way&>(*it), result.buffer, result.stats);
+                        ++it;
+                    }
+                }
+
+                return result;
+            }
+
+            void add_result(assembly_result&& result) {
+                m_stats += result.stats;
+                if (result.buffer.committed() > 0) {
+                    this->buffer().add_buffer(result.buffer);
+                    this->buffer().commit();
+                    this->possibly_flush();
+                }
+            }
+
+            void submit_batch() {
+                if (m_batch_jobs == 0) {
+                    return;
+                }
+
+                const auto batch = std::make_shared<osmium::memory::Buffer>(std::move(m_batch));
+                m_batch = osmium::memory::Buffer{batch_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                m_batch_jobs = 0;
+
+                m_pending.push_back(m_pool->submit([config = m_assembler_config, batch] {
+                    return assemble_batch(config, *batch);
+                }));
+
+                while (m_pending.size() > m_max_pending) {
+                    add_result(m_pending.front().get());
+                    m_pending.pop_front();
+                }
+            }
+
+            // Copy the objects for one area into the batch. They must be
+            // copied, because the originals might be gone when the task
+            // runs.
+            void add_job_to_batch(const osmium::OSMObject& object, const std::vector<const osmium::Way*>& ways) {
+                m_batch.add_item(object);
+                for (const auto* way : ways) {
+                    m_batch.add_item(*way);
+                }
+                m_batch.commit();
+
+                if (++m_batch_jobs >= max_jobs_per_batch || m_batch.committed() >= batch_buffer_size) {
+                    submit_batch();
+                }
+            }
+
         public:
 
             /**
@@ -98,9 +290,63 @@ namespace osmium {
                 m_filter(std::move(filter)) {
             }
 
+            /**
+             * Assemble areas on the thread pool. Completed relations and
+             * closed ways are collected into batches which are assembled
+             * by tasks in the pool, each into its own buffer. The results
+             * are added to the output buffer and the statistics in the
+             * order in which the relations and ways were completed, so the
+             * output is the same as without this setting. The output is
+             * only complete after flush_output() or read() was called.
+             * (The handler calls flush_output() at the end.)
+             *
+             * Call this before the second pass through the data. The
+             * pool must stay alive as long as the manager is used.
+             *
+             * @param pool The thread pool to use.
+             * @throws std::invalid_argument If the assembler config has
+             *         a problem reporter set, because those can not be
+             *         used from several threads.
+             */
+            void enable_parallel_assembly(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                if (m_assembler_config.problem_reporter) {
+                    throw std::invalid_argument{"parallel area assembly does not work with a problem reporter"};
+                }
+                m_pool = &pool;
+                m_max_pending = 2 * static_cast<std::size_t>(pool.num_threads()) + 1;
+                if (!m_batch) {
+                    m_batch = osmium::memory::Buffer{batch_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                }
+            }
+
+            /**
+             * Is parallel assembly enabled?
+             */
+            bool parallel_assembly() const noexcept {
+                return m_pool != nullptr;
+            }
+
+            /**
+             * Add the areas from all batches which are still being
+             * assembled to the output buffer. This is called from
+             * flush_output() and read(), there is usually no need to call
+             * it yourself.
+             */
+            void complete_pending() {
+                if (!m_pool) {
+                    return;
+                }
+                submit_batch();
+                while (!m_pending.empty()) {
+                    add_result(m_pending.front().get());
+                    m_pending.pop_front();
+                }
+            }
+
             /**
              * Access the aggregated statistics generated by the assemblers
-             * called from the manager.
+             * called from the manager. If parallel assembly is enabled,
+             * these are only complete after flush_output() or read().
              */
             const area_stats& stats() const noexcept {
                 return m_stats;
@@ -142,13 +388,12 @@ namespace osmium {
                     }
                 }
 
-                try {
-                    TAssembler assembler{m_assembler_config};
-                    assembler(relation, ways, this->buffer());
-                    m_stats += assembler.stats();
-                } catch (const osmium::invalid_location&) {
-                    // XXX ignore
+                if (m_pool) {
+                    add_job_to_batch(relation, ways);
+                    return;
                 }
+
+                assemble_relation(m_assembler_source, m_assembler_config, relation, ways, this->buffer(), m_stats);
             }
 
             void after_way(const osmium::Way& way) {
@@ -170,9 +415,12 @@ namespace osmium {
                             return;
                         }
 
-                        TAssembler assembler{m_assembler_config};
-                        assembler(way, this->buffer());
-                        m_stats += assembler.stats();
+                        if (m_pool) {
+                            add_job_to_batch(way, {});
+                            return;
+                        }
+
+                        m_assembler_source.assemble(m_assembler_config, m_stats, way, this->buffer());
                         this->possibly_flush();
                     }
                 } catch (const osmium::invalid_location&) {
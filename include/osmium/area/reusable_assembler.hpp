@@ -0,0 +1,105 @@
+#ifndef OSMIUM_AREA_REUSABLE_ASSEMBLER_HPP
+#define OSMIUM_AREA_REUSABLE_ASSEMBLER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Assembles area objects from closed ways or multipolygon relations
+         * and their members, just like the Assembler. But unlike the
+         * Assembler, which should be used for one area only, this can be
+         * used for any number of areas one after the other. The memory
+         * allocated for segments, rings, and other intermediate data is
+         * kept and reused for the next area. This saves a lot of memory
+         * allocations if many small areas are assembled.
+         *
+         * The stats() are those of the last area assembled.
+         *
+         * The MultipolygonManager keeps and reuses assemblers of this
+         * type instead of creating a new assembler for each area.
+         */
+        class ReusableAssembler : public Assembler {
+
+        public:
+
+            explicit ReusableAssembler(const config_type& config) :
+                Assembler(config) {
+            }
+
+            /**
+             * Clear all state from the last area assembled. This is done
+             * automatically when a new area is assembled.
+             */
+            using Assembler::reset;
+
+            /**
+             * Assemble an area from the given way.
+             * The resulting area is put into the out_buffer.
+             *
+             * @returns false if there was some kind of error building the
+             *          area, true otherwise.
+             */
+            bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+                reset();
+                return Assembler::operator()(way, out_buffer);
+            }
+
+            /**
+             * Assemble an area from the given relation and its members.
+             * The resulting area is put into the out_buffer.
+             *
+             * @returns false if there was some kind of error building the
+             *          area(s), true otherwise.
+             */
+            bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+                reset();
+                return Assembler::operator()(relation, members, out_buffer);
+            }
+
+        }; // class ReusableAssembler
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_REUSABLE_ASSEMBLER_HPP
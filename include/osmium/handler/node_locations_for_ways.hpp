@@ -37,14 +37,19 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
 #include <osmium/index/node_locations_map.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
 
+#include <cstddef>
+#include <future>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 namespace osmium {
 
@@ -88,6 +93,14 @@ namespace osmium {
 
             bool m_must_sort = false;
 
+            enum : std::size_t {
+                // Number of node refs looked up ahead of the current one.
+                prefetch_distance = 16,
+
+                // Minimum number of node refs handled in one pool task.
+                min_node_refs_per_task = 64UL * 1024UL
+            };
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -95,6 +108,59 @@ namespace osmium {
                 return instance;
             }
 
+            void prefetch_node_location(const osmium::object_id_type id) const noexcept {
+                if (id >= 0) {
+                    m_storage_pos.prefetch(static_cast<osmium::unsigned_object_id_type>(id));
+                } else {
+                    m_storage_neg.prefetch(static_cast<osmium::unsigned_object_id_type>(-id));
+                }
+            }
+
+            // Sort the storage if the nodes were not ordered by id. With a
+            // pool the storage can use several threads for this.
+            void sort_if_needed(osmium::thread::Pool* pool = nullptr) {
+                if (m_must_sort) {
+                    if (pool) {
+                        m_storage_pos.sort_parallel(*pool);
+                        m_storage_neg.sort_parallel(*pool);
+                    } else {
+                        m_storage_pos.sort();
+                        m_storage_neg.sort();
+                    }
+                    m_must_sort = false;
+                    m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
+                }
+            }
+
+            // Set locations of all nodes in the way. The locations of the
+            // next few nodes are prefetched while the current one is looked
+            // up. Returns false if any location was not found.
+            bool set_locations(osmium::Way& way) const noexcept {
+                auto& nodes = way.nodes();
+                const auto size = nodes.size();
+                auto* const node_refs = nodes.begin();
+
+                for (std::size_t i = 0; i < size && i < prefetch_distance; ++i) {
+                    prefetch_node_location(node_refs[i].ref());
+                }
+
+                bool okay = true;
+                for (std::size_t i = 0; i < size; ++i) {
+                    if (i + prefetch_distance < size) {
+                        prefetch_node_location(node_refs[i + prefetch_distance].ref());
+                    }
+                    node_refs[i].set_location(get_node_location(node_refs[i].ref()));
+                    if (!node_refs[i].location()) {
+                        okay = false;
+                    }
+                }
+                return okay;
+            }
+
+            [[noreturn]] static void throw_not_found() {
+                throw osmium::not_found{"location for one or more nodes not found in node location index"};
+            }
+
         public:
 
             explicit NodeLocationsForWays(TStoragePosIDs& storage_pos,
@@ -155,21 +221,70 @@ namespace osmium {
              * them to the way object.
              */
             void way(osmium::Way& way) {
-                if (m_must_sort) {
-                    m_storage_pos.sort();
-                    m_storage_neg.sort();
-                    m_must_sort = false;
-                    m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
+                sort_if_needed();
+                if (!set_locations(way) && !m_ignore_errors) {
+                    throw_not_found();
                 }
-                bool error = false;
-                for (auto& node_ref : way.nodes()) {
-                    node_ref.set_location(get_node_location(node_ref.ref()));
-                    if (!node_ref.location()) {
-                        error = true;
+            }
+
+            /**
+             * Retrieve locations of all nodes in all ways in the buffer from
+             * storage and add them to the way objects. The work is split up
+             * into several tasks which run on the thread pool. Call this
+             * only after all nodes have been added to the storage. Objects
+             * in the buffer that are not ways are ignored.
+             *
+             * The storage must allow concurrent calls to get_noexcept(),
+             * all index maps in libosmium do. If the nodes were not
+             * ordered by id, the storage is sorted first, using the pool
+             * if the storage supports that.
+             *
+             * @param buffer Buffer with ways.
+             * @param pool Thread pool to use.
+             * @throws osmium::not_found if a location could not be found
+             *         and ignore_errors() was not called. All ways in the
+             *         buffer are still handled in that case.
+             */
+            void add_locations_to_ways(osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                sort_if_needed(&pool);
+
+                std::vector<std::future<bool>> results;
+                std::vector<osmium::Way*> ways;
+                std::size_t num_node_refs = 0;
+
+                const auto submit = [&]() {
+                    results.push_back(pool.submit([this, task_ways = std::move(ways)]() {
+                        bool okay = true;
+                        for (osmium::Way* way : task_ways) {
+                            if (!set_locations(*way)) {
+                                okay = false;
+                            }
+                        }
+                        return okay;
+                    }));
+                    ways.clear();
+                    num_node_refs = 0;
+                };
+
+                for (auto& way : buffer.select<osmium::Way>()) {
+                    ways.push_back(&way);
+                    num_node_refs += way.nodes().size();
+                    if (num_node_refs >= min_node_refs_per_task) {
+                        submit();
+                    }
+                }
+                if (!ways.empty()) {
+                    submit();
+                }
+
+                bool okay = true;
+                for (auto& result : results) {
+                    if (!result.get()) {
+                        okay = false;
                     }
                 }
-                if (!m_ignore_errors && error) {
-                    throw osmium::not_found{"location for one or more nodes not found in node location index"};
+                if (!okay && !m_ignore_errors) {
+                    throw_not_found();
                 }
             }
 
@@ -0,0 +1,666 @@
+#ifndef OSMIUM_INDEX_AREA_INDEX_HPP
+#define OSMIUM_INDEX_AREA_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * An entry in the AreaIndex. On the lowest level of the tree
+             * this is the bounding box of an area and its offset in the
+             * buffer. On the other levels it is the bounding box of a
+             * node of the level below, the offset is unused.
+             */
+            struct area_index_entry {
+                int32_t min_x;
+                int32_t min_y;
+                int32_t max_x;
+                int32_t max_y;
+                uint64_t offset;
+
+                bool intersects(const area_index_entry& other) const noexcept {
+                    return min_x <= other.max_x && other.min_x <= max_x &&
+                           min_y <= other.max_y && other.min_y <= max_y;
+                }
+
+                bool contains(const osmium::Location location) const noexcept {
+                    return min_x <= location.x() && location.x() <= max_x &&
+                           min_y <= location.y() && location.y() <= max_y;
+                }
+
+                void extend(const area_index_entry& other) noexcept {
+                    min_x = std::min(min_x, other.min_x);
+                    min_y = std::min(min_y, other.min_y);
+                    max_x = std::max(max_x, other.max_x);
+                    max_y = std::max(max_y, other.max_y);
+                }
+
+                int64_t center_x() const noexcept {
+                    return (static_cast<int64_t>(min_x) + max_x) / 2;
+                }
+
+                int64_t center_y() const noexcept {
+                    return (static_cast<int64_t>(min_y) + max_y) / 2;
+                }
+
+            }; // struct area_index_entry
+
+            static_assert(sizeof(area_index_entry) == 24, "area_index_entry must be 24 bytes");
+
+            inline area_index_entry make_area_index_entry(const osmium::Box& box, uint64_t offset = 0) noexcept {
+                return area_index_entry{box.bottom_left().x(), box.bottom_left().y(),
+                                        box.top_right().x(), box.top_right().y(), offset};
+            }
+
+            // Sign of the cross product (b - a) x (c - a).
+            inline int orientation(const osmium::Location a, const osmium::Location b, const osmium::Location c) noexcept {
+                const int64_t value = (static_cast<int64_t>(b.x()) - a.x()) * (static_cast<int64_t>(c.y()) - a.y()) -
+                                      (static_cast<int64_t>(b.y()) - a.y()) * (static_cast<int64_t>(c.x()) - a.x());
+                return (value > 0) - (value < 0);
+            }
+
+            // Is c inside the bounding box of the segment a-b?
+            inline bool in_segment_box(const osmium::Location a, const osmium::Location b, const osmium::Location c) noexcept {
+                return std::min(a.x(), b.x()) <= c.x() && c.x() <= std::max(a.x(), b.x()) &&
+                       std::min(a.y(), b.y()) <= c.y() && c.y() <= std::max(a.y(), b.y());
+            }
+
+            /// Do the segments p1-p2 and q1-q2 have at least one point in common?
+            inline bool segments_intersect(const osmium::Location p1, const osmium::Location p2, const osmium::Location q1, const osmium::Location q2) noexcept {
+                const int o1 = orientation(p1, p2, q1);
+                const int o2 = orientation(p1, p2, q2);
+                const int o3 = orientation(q1, q2, p1);
+                const int o4 = orientation(q1, q2, p2);
+
+                if (o1 != o2 && o3 != o4) {
+                    return true;
+                }
+
+                return (o1 == 0 && in_segment_box(p1, p2, q1)) ||
+                       (o2 == 0 && in_segment_box(p1, p2, q2)) ||
+                       (o3 == 0 && in_segment_box(q1, q2, p1)) ||
+                       (o4 == 0 && in_segment_box(q1, q2, p2));
+            }
+
+            /// Does the segment a-b have at least one point in common with the box?
+            inline bool segment_intersects_box(const osmium::Location a, const osmium::Location b, const osmium::Box& box) noexcept {
+                if (box.contains(a) || box.contains(b)) {
+                    return true;
+                }
+
+                const osmium::Location bl = box.bottom_left();
+                const osmium::Location tr = box.top_right();
+                const osmium::Location br{tr.x(), bl.y()};
+                const osmium::Location tl{bl.x(), tr.y()};
+
+                return segments_intersect(a, b, bl, br) ||
+                       segments_intersect(a, b, br, tr) ||
+                       segments_intersect(a, b, tr, tl) ||
+                       segments_intersect(a, b, tl, bl);
+            }
+
+            /**
+             * Is the location inside the ring? Uses the crossing number
+             * algorithm. Locations on the boundary of the ring may or may
+             * not be considered inside.
+             */
+            template <typename TRing>
+            inline bool ring_contains(const TRing& ring, const osmium::Location location) noexcept {
+                bool inside = false;
+                const int64_t px = location.x();
+                const int64_t py = location.y();
+
+                auto it = ring.cbegin();
+                if (it == ring.cend()) {
+                    return false;
+                }
+                for (auto prev = it++; it != ring.cend(); prev = it++) {
+                    const int64_t ax = prev->x();
+                    const int64_t ay = prev->y();
+                    const int64_t bx = it->x();
+                    const int64_t by = it->y();
+                    if ((ay > py) != (by > py)) {
+                        // Is the crossing of the segment with the horizontal
+                        // line through the location to the right of it?
+                        const int64_t lhs = (px - ax) * (by - ay);
+                        const int64_t rhs = (bx - ax) * (py - ay);
+                        if (by > ay ? lhs < rhs : lhs > rhs) {
+                            inside = !inside;
+                        }
+                    }
+                }
+
+                return inside;
+            }
+
+        } // namespace detail
+
+        /**
+         * Is the location inside the area? This is the case if it is
+         * inside one of the outer rings but not inside any of the inner
+         * rings of that outer ring. Locations on the boundary of the area
+         * may or may not be considered inside.
+         *
+         * Like the area assembler this uses integer arithmetic and will
+         * not work correctly with rings having segments longer than about
+         * half the planet.
+         */
+        inline bool area_contains(const osmium::Area& area, const osmium::Location location) noexcept {
+            for (const auto& outer : area.outer_rings()) {
+                if (detail::ring_contains(outer, location)) {
+                    const auto inner_rings = area.inner_rings(outer);
+                    if (std::none_of(inner_rings.cbegin(), inner_rings.cend(), [location](const osmium::InnerRing& inner) {
+                        return detail::ring_contains(inner, location);
+                    })) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Does the area have at least one point in common with the box?
+         * This is the case if any of the rings intersects the box or if
+         * the box is completely inside the area.
+         */
+        inline bool area_intersects(const osmium::Area& area, const osmium::Box& box) noexcept {
+            if (!box.valid()) {
+                return false;
+            }
+
+            for (const auto& item : area) {
+                if (item.type() == osmium::item_type::outer_ring || item.type() == osmium::item_type::inner_ring) {
+                    const auto& ring = static_cast<const osmium::NodeRefList&>(item);
+                    auto it = ring.cbegin();
+                    if (it == ring.cend()) {
+                        continue;
+                    }
+                    for (auto prev = it++; it != ring.cend(); prev = it++) {
+                        if (detail::segment_intersects_box(prev->location(), it->location(), box)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+
+            return area_contains(area, box.bottom_left());
+        }
+
+        /**
+         * A spatial index for areas in a buffer. It allows finding all
+         * areas containing a location or intersecting a box quickly.
+         *
+         * This is a static, packed R-tree built with the
+         * Sort-Tile-Recursive (STR) algorithm from the bounding boxes of
+         * the areas. Once built it can not be changed. Each node of the
+         * tree has up to node_size entries. All entries of all levels of
+         * the tree are stored in one array, the leaves first, so the
+         * index can be written to disk with dump() and used directly from
+         * a memory mapping with map() later.
+         *
+         * The index only stores the offsets of the areas in the buffer,
+         * so the buffer the index was built from must be given to all
+         * queries that need the area objects. If the index is written to
+         * disk, the buffer must be kept, too.
+         */
+        class AreaIndex {
+
+        public:
+
+            using entry_type = detail::area_index_entry;
+
+            enum : std::size_t {
+                node_size = 16
+            };
+
+        private:
+
+            static constexpr const char* magic() noexcept {
+                return "OSMAREAI";
+            }
+
+            enum : std::uint32_t {
+                magic_size = 8,
+                format_version = 1
+            };
+
+            struct file_header {
+                std::array<char, magic_size> magic;
+                std::uint32_t version;
+                std::uint32_t node_size;
+                std::uint64_t size;
+                std::uint64_t num_entries;
+            }; // struct file_header
+
+            static_assert(sizeof(file_header) % alignof(entry_type) == 0, "entries in file must be aligned");
+
+            // Used if the index was built or loaded.
+            std::vector<entry_type> m_entries;
+
+            // Used if the index was mapped from a file.
+            std::unique_ptr<osmium::util::MemoryMapping> m_mapping;
+
+            // All entries, either in m_entries or in m_mapping.
+            const entry_type* m_data = nullptr;
+
+            std::size_t m_num_entries = 0;
+
+            // Start of each level of the tree in m_data, the leaves are
+            // level 0. The last element is the number of entries.
+            std::vector<std::size_t> m_levels;
+
+            static std::size_t num_entries_for(std::size_t size) noexcept {
+                std::size_t sum = size;
+                while (size > 1) {
+                    size = (size + node_size - 1) / node_size;
+                    sum += size;
+                }
+                return sum;
+            }
+
+            void init_levels(std::size_t size) {
+                m_levels.clear();
+                m_levels.push_back(0);
+                if (size == 0) {
+                    return;
+                }
+                std::size_t start = 0;
+                while (true) {
+                    m_levels.push_back(start + size);
+                    if (size == 1) {
+                        return;
+                    }
+                    start += size;
+                    size = (size + node_size - 1) / node_size;
+                }
+            }
+
+            void set_data(const entry_type* data, std::size_t num_entries) noexcept {
+                m_data = data;
+                m_num_entries = num_entries;
+            }
+
+            // Sort the leaves into tiles: vertical slices ordered by x,
+            // each slice ordered by y.
+            static void sort_tile_recursive(std::vector<entry_type>& leaves) {
+                const std::size_t num_nodes = (leaves.size() + node_size - 1) / node_size;
+                const auto num_slices = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(num_nodes))));
+                const std::size_t slice_size = num_slices * node_size;
+
+                std::sort(leaves.begin(), leaves.end(), [](const entry_type& lhs, const entry_type& rhs) {
+                    return lhs.center_x() < rhs.center_x();
+                });
+
+                for (std::size_t start = 0; start < leaves.size(); start += slice_size) {
+                    const auto end = std::min(start + slice_size, leaves.size());
+                    std::sort(leaves.begin() + static_cast<std::ptrdiff_t>(start), leaves.begin() + static_cast<std::ptrdiff_t>(end), [](const entry_type& lhs, const entry_type& rhs) {
+                        return lhs.center_y() < rhs.center_y();
+                    });
+                }
+            }
+
+            template <typename TFunc>
+            void query_node(const entry_type& box, std::size_t level, std::size_t n, TFunc& func) const {
+                const std::size_t first = m_levels[level] + n * node_size;
+                const std::size_t last = std::min(first + node_size, m_levels[level + 1]);
+                for (std::size_t i = first; i < last; ++i) {
+                    if (m_data[i].intersects(box)) {
+                        if (level == 0) {
+                            func(m_data[i].offset);
+                        } else {
+                            query_node(box, level - 1, i - m_levels[level], func);
+                        }
+                    }
+                }
+            }
+
+            template <typename TFunc>
+            void query_entry(const entry_type& box, TFunc&& func) const {
+                if (empty()) {
+                    return;
+                }
+                const std::size_t root_level = m_levels.size() - 2;
+                if (m_data[m_levels[root_level]].intersects(box)) {
+                    if (root_level == 0) {
+                        func(m_data[0].offset);
+                    } else {
+                        query_node(box, root_level - 1, 0, func);
+                    }
+                }
+            }
+
+            void check_header(const file_header& header) const {
+                if (std::memcmp(header.magic.data(), magic(), magic_size) != 0) {
+                    throw std::runtime_error{"not an area index file"};
+                }
+                if (header.version != format_version || header.node_size != node_size) {
+                    throw std::runtime_error{"unsupported area index format version"};
+                }
+                if (header.num_entries != num_entries_for(header.size)) {
+                    throw std::runtime_error{"invalid area index file"};
+                }
+            }
+
+        public:
+
+            /// Create an empty index.
+            AreaIndex() {
+                init_levels(0);
+            }
+
+            /**
+             * Build the index from all areas in the buffer. Areas without
+             * a valid bounding box are ignored.
+             */
+            explicit AreaIndex(const osmium::memory::Buffer& buffer) {
+                std::vector<entry_type> leaves;
+                for (auto it = buffer.cbegin<osmium::Area>(); it != buffer.cend<osmium::Area>(); ++it) {
+                    const osmium::Box box = it->envelope();
+                    if (box.valid()) {
+                        leaves.push_back(detail::make_area_index_entry(box, static_cast<uint64_t>(it.data() - buffer.data())));
+                    }
+                }
+
+                sort_tile_recursive(leaves);
+
+                const std::size_t size = leaves.size();
+                init_levels(size);
+                m_entries = std::move(leaves);
+                m_entries.reserve(num_entries_for(size));
+
+                // Each entry on the next level up is the bounding box of
+                // a node on this level.
+                for (std::size_t level = 0; level + 2 < m_levels.size(); ++level) {
+                    for (std::size_t i = m_levels[level]; i < m_levels[level + 1]; i += node_size) {
+                        entry_type entry = m_entries[i];
+                        entry.offset = 0;
+                        const auto last = std::min(i + node_size, m_levels[level + 1]);
+                        for (auto j = i + 1; j < last; ++j) {
+                            entry.extend(m_entries[j]);
+                        }
+                        m_entries.push_back(entry);
+                    }
+                }
+
+                set_data(m_entries.data(), m_entries.size());
+            }
+
+            AreaIndex(const AreaIndex&) = delete;
+            AreaIndex& operator=(const AreaIndex&) = delete;
+
+            AreaIndex(AreaIndex&&) noexcept = default;
+            AreaIndex& operator=(AreaIndex&&) noexcept = default;
+
+            ~AreaIndex() noexcept = default;
+
+            /// The number of areas in the index.
+            std::size_t size() const noexcept {
+                return m_levels.size() > 1 ? m_levels[1] : 0;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /// The number of levels of the tree.
+            std::size_t levels() const noexcept {
+                return m_levels.size() - 1;
+            }
+
+            /**
+             * The bounding box of all areas in the index. Invalid if the
+             * index is empty.
+             */
+            osmium::Box bbox() const noexcept {
+                if (empty()) {
+                    return osmium::Box{};
+                }
+                const auto& root = m_data[m_num_entries - 1];
+                return osmium::Box{osmium::Location{root.min_x, root.min_y}, osmium::Location{root.max_x, root.max_y}};
+            }
+
+            /**
+             * Call func(offset) with the offset in the buffer of all areas
+             * whose bounding box intersects the given box. This doesn't
+             * look at the areas themselves, so it doesn't need the buffer.
+             */
+            template <typename TFunc>
+            void query(const osmium::Box& box, TFunc&& func) const {
+                if (!box.valid()) {
+                    return;
+                }
+                const auto entry = detail::make_area_index_entry(box);
+                query_entry(entry, func);
+            }
+
+            /**
+             * Call func(area) for all areas containing the location.
+             *
+             * @param buffer The buffer this index was built from.
+             * @param location The location to look for.
+             * @param func The function to call with each area found.
+             */
+            template <typename TFunc>
+            void find_containing(const osmium::memory::Buffer& buffer, const osmium::Location location, TFunc&& func) const {
+                if (!location.valid()) {
+                    return;
+                }
+                const entry_type entry{location.x(), location.y(), location.x(), location.y(), 0};
+                query_entry(entry, [&](uint64_t offset) {
+                    const auto& area = buffer.get<osmium::Area>(static_cast<std::size_t>(offset));
+                    if (area_contains(area, location)) {
+                        func(area);
+                    }
+                });
+            }
+
+            /**
+             * Call func(area) for all areas which have at least one point
+             * in common with the box.
+             *
+             * @param buffer The buffer this index was built from.
+             * @param box The box to look for.
+             * @param func The function to call with each area found.
+             */
+            template <typename TFunc>
+            void find_intersecting(const osmium::memory::Buffer& buffer, const osmium::Box& box, TFunc&& func) const {
+                query(box, [&](uint64_t offset) {
+                    const auto& area = buffer.get<osmium::Area>(static_cast<std::size_t>(offset));
+                    if (area_intersects(area, box)) {
+                        func(area);
+                    }
+                });
+            }
+
+            /**
+             * Call func(n, area) for each location locations[n] and each
+             * area containing it. The locations are looked up sorted by
+             * position, which makes better use of the CPU caches than
+             * looking them up in the order given, so the function is not
+             * called in order of n.
+             */
+            template <typename TFunc>
+            void find_containing(const osmium::memory::Buffer& buffer, const std::vector<osmium::Location>& locations, TFunc&& func) const {
+                std::vector<std::size_t> order(locations.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [&locations](std::size_t lhs, std::size_t rhs) {
+                    return locations[lhs] < locations[rhs];
+                });
+
+                for (const auto n : order) {
+                    find_containing(buffer, locations[n], [&](const osmium::Area& area) {
+                        func(n, area);
+                    });
+                }
+            }
+
+            /**
+             * Call func(n, area) for each box boxes[n] and each area
+             * intersecting it. The boxes are looked up sorted by
+             * position, so the function is not called in order of n.
+             */
+            template <typename TFunc>
+            void find_intersecting(const osmium::memory::Buffer& buffer, const std::vector<osmium::Box>& boxes, TFunc&& func) const {
+                std::vector<std::size_t> order(boxes.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [&boxes](std::size_t lhs, std::size_t rhs) {
+                    return boxes[lhs].bottom_left() < boxes[rhs].bottom_left();
+                });
+
+                for (const auto n : order) {
+                    find_intersecting(buffer, boxes[n], [&](const osmium::Area& area) {
+                        func(n, area);
+                    });
+                }
+            }
+
+            /**
+             * Write the index to a file descriptor. The data is written in
+             * the byte order of the machine and can only be read on a
+             * machine with the same byte order.
+             *
+             * @throws std::system_error If the data could not be written.
+             */
+            void dump(int fd) const {
+                file_header header{};
+                std::memcpy(header.magic.data(), magic(), magic_size);
+                header.version = format_version;
+                header.node_size = node_size;
+                header.size = size();
+                header.num_entries = m_num_entries;
+
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                if (m_num_entries > 0) {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_data), sizeof(entry_type) * m_num_entries);
+                }
+            }
+
+            /**
+             * Read an index written with dump() from a file descriptor
+             * into memory.
+             *
+             * @throws std::runtime_error If the data is not an area index.
+             * @throws std::system_error If the data could not be read.
+             */
+            void load(int fd) {
+                file_header header{};
+                if (!osmium::io::detail::read_exactly(fd, reinterpret_cast<char*>(&header), sizeof(header))) {
+                    throw std::runtime_error{"not an area index file"};
+                }
+                check_header(header);
+
+                std::vector<entry_type> entries(header.num_entries);
+                auto* data = reinterpret_cast<char*>(entries.data());
+                std::size_t bytes = sizeof(entry_type) * entries.size();
+                while (bytes > 0) {
+                    const auto chunk = static_cast<unsigned int>(std::min<std::size_t>(bytes, 1024UL * 1024UL * 1024UL));
+                    if (!osmium::io::detail::read_exactly(fd, data, chunk)) {
+                        throw std::runtime_error{"truncated area index file"};
+                    }
+                    data += chunk;
+                    bytes -= chunk;
+                }
+
+                m_mapping.reset();
+                m_entries = std::move(entries);
+                init_levels(header.size);
+                set_data(m_entries.data(), m_entries.size());
+            }
+
+            /**
+             * Memory map an index written with dump(). The file must
+             * contain the index only, starting at the beginning of the
+             * file. The data is not copied, so this is very fast, and the
+             * memory is shared with other processes mapping the same file.
+             *
+             * @throws std::runtime_error If the file is not an area index.
+             * @throws std::system_error If the file could not be mapped.
+             */
+            void map(int fd) {
+                const std::size_t file_size = osmium::util::file_size(fd);
+                if (file_size < sizeof(file_header)) {
+                    throw std::runtime_error{"not an area index file"};
+                }
+
+                std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd}};
+                const auto* addr = mapping->get_addr<const char>();
+
+                file_header header{};
+                std::memcpy(&header, addr, sizeof(header));
+                check_header(header);
+                if (file_size < sizeof(file_header) + sizeof(entry_type) * header.num_entries) {
+                    throw std::runtime_error{"truncated area index file"};
+                }
+
+                m_entries.clear();
+                m_entries.shrink_to_fit();
+                m_mapping = std::move(mapping);
+                init_levels(header.size);
+                set_data(reinterpret_cast<const entry_type*>(addr + sizeof(file_header)), header.num_entries);
+            }
+
+        }; // class AreaIndex
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_AREA_INDEX_HPP
@@ -54,6 +54,10 @@ namespace osmium {
                 mmap_vector_base<T>() {
             }
 
+            explicit mmap_vector_anon(const osmium::memory_mapping_options& options) :
+                mmap_vector_base<T>(options) {
+            }
+
         }; // class mmap_vector_anon
 
     } // namespace detail
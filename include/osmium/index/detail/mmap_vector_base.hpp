@@ -78,6 +78,12 @@ namespace osmium {
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
+            explicit mmap_vector_base(const osmium::memory_mapping_options& options, const std::size_t capacity = mmap_vector_size_increment) :
+                m_mapping(capacity, options) {
+                // Mappings with huge pages can be larger than requested.
+                std::fill_n(data(), this->capacity(), osmium::index::empty_value<T>());
+            }
+
             using value_type      = T;
             using pointer         = value_type*;
             using const_pointer   = const value_type*;
@@ -146,7 +152,7 @@ namespace osmium {
                 if (new_capacity > capacity()) {
                     const std::size_t old_capacity = capacity();
                     m_mapping.resize(new_capacity);
-                    std::fill(data() + old_capacity, data() + new_capacity, osmium::index::empty_value<value_type>());
+                    std::fill(data() + old_capacity, data() + capacity(), osmium::index::empty_value<value_type>());
                 }
             }
 
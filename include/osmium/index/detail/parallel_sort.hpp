@@ -0,0 +1,232 @@
+#ifndef OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
+#define OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum : std::size_t {
+                // Ranges smaller than this are sorted in the calling thread.
+                min_parallel_sort_size = 1024UL * 1024UL
+            };
+
+            inline void wait_for_all(std::vector<std::future<void>>& futures) {
+                // Wait for all tasks before calling get(), which might
+                // throw, because the tasks are working on our data.
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                for (auto& future : futures) {
+                    future.get();
+                }
+                futures.clear();
+            }
+
+            template <typename TIterator>
+            struct merge_job {
+                TIterator first;
+                TIterator middle;
+                TIterator last;
+            };
+
+            /**
+             * Split the merge of [first, middle) and [middle, last) into
+             * two independent merges. The middle element of the longer
+             * range is used as pivot, the elements of both ranges between
+             * the cut points are swapped with std::rotate(). This is one
+             * step of the usual merge without buffer.
+             */
+            template <typename TIterator, typename TCompare>
+            std::pair<merge_job<TIterator>, merge_job<TIterator>> split_merge_job(const merge_job<TIterator>& job, TCompare compare) {
+                TIterator cut1;
+                TIterator cut2;
+                if (job.middle - job.first >= job.last - job.middle) {
+                    cut1 = job.first + (job.middle - job.first) / 2;
+                    cut2 = std::lower_bound(job.middle, job.last, *cut1, compare);
+                } else {
+                    cut2 = job.middle + (job.last - job.middle) / 2;
+                    cut1 = std::upper_bound(job.first, job.middle, *cut2, compare);
+                }
+                const auto new_middle = std::rotate(cut1, job.middle, cut2);
+                return {{job.first, cut1, new_middle}, {new_middle, cut2, job.last}};
+            }
+
+            /**
+             * Run the merge jobs on the pool. Jobs are split until there
+             * are enough of them to keep all threads busy. Splitting is
+             * done in rounds from the calling thread, so no task ever
+             * waits for another task.
+             */
+            template <typename TIterator, typename TCompare>
+            void parallel_merge(osmium::thread::Pool& pool, std::vector<merge_job<TIterator>> jobs, TCompare compare) {
+                using job_pair = std::pair<merge_job<TIterator>, merge_job<TIterator>>;
+
+                const auto num_threads = static_cast<std::size_t>(pool.num_threads());
+                while (jobs.size() < num_threads) {
+                    std::vector<merge_job<TIterator>> to_split;
+                    std::vector<merge_job<TIterator>> new_jobs;
+                    for (const auto& job : jobs) {
+                        if (job.last - job.first >= static_cast<std::ptrdiff_t>(min_parallel_sort_size / num_threads)) {
+                            to_split.push_back(job);
+                        } else {
+                            new_jobs.push_back(job);
+                        }
+                    }
+                    if (to_split.empty()) {
+                        break;
+                    }
+
+                    std::vector<std::future<job_pair>> futures;
+                    futures.reserve(to_split.size());
+                    for (const auto& job : to_split) {
+                        futures.push_back(pool.submit([job, compare]() {
+                            return split_merge_job(job, compare);
+                        }));
+                    }
+                    for (auto& future : futures) {
+                        future.wait();
+                    }
+                    for (auto& future : futures) {
+                        const auto parts = future.get();
+                        for (const auto& part : {parts.first, parts.second}) {
+                            // Nothing to do if one of the ranges is empty.
+                            if (part.first != part.middle && part.middle != part.last) {
+                                new_jobs.push_back(part);
+                            }
+                        }
+                    }
+                    jobs.swap(new_jobs);
+                }
+
+                std::vector<std::future<void>> futures;
+                futures.reserve(jobs.size());
+                for (const auto& job : jobs) {
+                    futures.push_back(pool.submit([job, compare]() {
+                        std::inplace_merge(job.first, job.middle, job.last, compare);
+                    }));
+                }
+                wait_for_all(futures);
+            }
+
+            /**
+             * Sort a range using several threads from the pool. The range
+             * is split into parts which are sorted in parallel with
+             * std::sort(). The sorted parts are then merged pairwise with
+             * std::inplace_merge(), again in parallel, until one sorted
+             * range is left. Merges are split into smaller independent
+             * merges if there are fewer of them than threads, so the last
+             * merges also use all threads.
+             *
+             * Small ranges are sorted directly in the calling thread. This
+             * is also done when this is called from a task running in the
+             * same pool, because waiting for other tasks of the pool there
+             * could deadlock.
+             *
+             * The merges need temporary memory: std::inplace_merge()
+             * allocates a buffer of up to half the size of the range it is
+             * merging. Over all threads this is up to half the size of the
+             * whole range. If that memory can't be allocated, the standard
+             * library falls back to a slower merge without buffer.
+             *
+             * The sort is not stable.
+             *
+             * @param pool Thread pool to use.
+             * @param first Iterator to beginning of the range.
+             * @param last Iterator to end of the range.
+             * @param compare Comparison function (default: std::less<>).
+             */
+            template <typename TIterator, typename TCompare = std::less<>>
+            inline void parallel_sort(osmium::thread::Pool& pool, TIterator first, TIterator last, TCompare compare = TCompare{}) {
+                const auto size = static_cast<std::size_t>(std::distance(first, last));
+                const auto num_threads = static_cast<std::size_t>(pool.num_threads());
+
+                if (size < min_parallel_sort_size || num_threads < 2 || pool.is_pool_thread()) {
+                    std::sort(first, last, compare);
+                    return;
+                }
+
+                // Use a power of two parts, so merging is simple.
+                std::size_t num_parts = 2;
+                while (num_parts < num_threads) {
+                    num_parts *= 2;
+                }
+
+                std::vector<TIterator> bounds;
+                bounds.reserve(num_parts + 1);
+                for (std::size_t i = 0; i < num_parts; ++i) {
+                    bounds.push_back(first + static_cast<std::ptrdiff_t>(size * i / num_parts));
+                }
+                bounds.push_back(last);
+
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_parts);
+
+                for (std::size_t i = 0; i < num_parts; ++i) {
+                    const auto begin = bounds[i];
+                    const auto end = bounds[i + 1];
+                    futures.push_back(pool.submit([begin, end, compare]() {
+                        std::sort(begin, end, compare);
+                    }));
+                }
+                wait_for_all(futures);
+
+                for (std::size_t step = 1; step < num_parts; step *= 2) {
+                    std::vector<merge_job<TIterator>> jobs;
+                    for (std::size_t i = 0; i + step < num_parts; i += 2 * step) {
+                        jobs.push_back({bounds[i], bounds[i + step], bounds[i + 2 * step]});
+                    }
+                    parallel_merge(pool, std::move(jobs), compare);
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
@@ -33,9 +33,11 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <algorithm>
 #include <cstddef>
@@ -77,6 +79,10 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                explicit VectorBasedDenseMap(const osmium::memory_mapping_options& options) :
+                    m_vector(options) {
+                }
+
                 void reserve(const std::size_t size) final {
                     m_vector.reserve(size);
                 }
@@ -106,6 +112,16 @@ namespace osmium {
                     return m_vector[id];
                 }
 
+                void prefetch(const TId id) const noexcept final {
+#if defined(__GNUC__) || defined(__clang__)
+                    if (id < m_vector.size()) {
+                        __builtin_prefetch(&m_vector[id]);
+                    }
+#else
+                    (void)id;
+#endif
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
@@ -238,6 +254,17 @@ namespace osmium {
                     std::sort(m_vector.begin(), m_vector.end());
                 }
 
+                /**
+                 * Sort the entries in the map using several threads
+                 * from the given pool. This needs temporary memory of up
+                 * to half the size of the map. If called from a task
+                 * running in the same pool, the map is sorted in the
+                 * calling thread.
+                 */
+                void sort_parallel(osmium::thread::Pool& pool) final {
+                    osmium::index::detail::parallel_sort(pool, m_vector.begin(), m_vector.end());
+                }
+
                 void dump_as_array(const int fd) final {
                     constexpr const size_t value_size = sizeof(TValue);
                     constexpr const size_t buffer_size = (10L * 1024L * 1024L) / value_size;
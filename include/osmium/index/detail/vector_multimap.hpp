@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
@@ -130,6 +131,17 @@ namespace osmium {
                     std::sort(m_vector.begin(), m_vector.end());
                 }
 
+                /**
+                 * Sort the entries in the multimap using several threads
+                 * from the given pool. This needs temporary memory of up
+                 * to half the size of the multimap. If called from a task
+                 * running in the same pool, the multimap is sorted in the
+                 * calling thread.
+                 */
+                void sort_parallel(osmium::thread::Pool& pool) final {
+                    osmium::index::detail::parallel_sort(pool, m_vector.begin(), m_vector.end());
+                }
+
                 void remove(const TId id, const TValue value) {
                     const auto r = get_all(id);
                     for (auto it = r.first; it != r.second; ++it) {
@@ -60,6 +60,10 @@ namespace osmium {
 
     }; // struct map_factory_error
 
+    namespace thread {
+        class Pool;
+    } // namespace thread
+
     namespace index {
 
         /**
@@ -146,6 +150,18 @@ namespace osmium {
                  */
                 virtual TValue get_noexcept(const TId id) const noexcept = 0;
 
+                /**
+                 * Tell the map that the value for this id will be needed
+                 * soon. Implementations can use this to prefetch the memory
+                 * where the value is stored. This is only a hint, the
+                 * default implementation does nothing.
+                 *
+                 * @param id The id that will be looked up.
+                 */
+                virtual void prefetch(const TId /*id*/) const noexcept {
+                    // default implementation is empty
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
@@ -177,6 +193,15 @@ namespace osmium {
                     // default implementation is empty
                 }
 
+                /**
+                 * Sort data in map like sort(), but use several threads
+                 * from the given pool if the implementation can do that.
+                 * The default implementation calls sort().
+                 */
+                virtual void sort_parallel(osmium::thread::Pool& /*pool*/) {
+                    sort();
+                }
+
                 // This function can usually be const in derived classes,
                 // but not always. It could, for instance, sort internal data.
                 // This is why it is not declared const here.
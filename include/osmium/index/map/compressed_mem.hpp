@@ -0,0 +1,356 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_MEM_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_MEM_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            namespace detail {
+
+                inline int popcount(uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                    return __builtin_popcountll(value);
+#else
+                    int count = 0;
+                    while (value) {
+                        value &= value - 1;
+                        ++count;
+                    }
+                    return count;
+#endif
+                }
+
+                inline uint64_t zigzag_encode(const int64_t value) noexcept {
+                    return (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(-static_cast<int64_t>(static_cast<uint64_t>(value) >> 63U));
+                }
+
+                inline int64_t zigzag_decode(const uint64_t value) noexcept {
+                    return static_cast<int64_t>((value >> 1U) ^ static_cast<uint64_t>(-static_cast<int64_t>(value & 1U)));
+                }
+
+                inline unsigned char* write_varint(unsigned char* data, uint64_t value) noexcept {
+                    while (value >= 0x80U) {
+                        *data++ = static_cast<unsigned char>((value & 0x7fU) | 0x80U);
+                        value >>= 7U;
+                    }
+                    *data++ = static_cast<unsigned char>(value);
+                    return data;
+                }
+
+                inline uint64_t read_varint(const unsigned char** data) noexcept {
+                    uint64_t value = 0;
+                    unsigned int shift = 0;
+                    while (**data & 0x80U) {
+                        value |= static_cast<uint64_t>(**data & 0x7fU) << shift;
+                        shift += 7;
+                        ++*data;
+                    }
+                    value |= static_cast<uint64_t>(**data) << shift;
+                    ++*data;
+                    return value;
+                }
+
+            } // namespace detail
+
+            /**
+             * Memory efficient index for node locations. Ids are grouped
+             * into blocks of 64 consecutive Ids. For each block a bitmap
+             * marks which Ids are set, the locations are stored as
+             * zigzag-encoded varints of the difference to the previous
+             * location in the block. Because nodes with consecutive Ids
+             * are often close to each other, this needs only a few bytes
+             * per location instead of the 8 bytes a Location needs.
+             *
+             * Looking up a location needs a binary search for the block
+             * and decoding of up to 64 locations. This is slower than the
+             * dense indexes, but much faster than using a dense index on
+             * disk that doesn't fit into memory.
+             *
+             * Locations should be set in order of their Ids (as they are
+             * in a sorted OSM file), otherwise sort() must be called after
+             * all locations are set and before they are read. All data is
+             * held in memory.
+             *
+             * This index can only be used with osmium::Location values.
+             */
+            template <typename TId, typename TValue>
+            class CompressedMem : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value, "CompressedMem index can only store osmium::Location");
+
+                enum : unsigned int {
+                    bits = 6
+                };
+
+                enum : uint64_t {
+                    block_size = 1ULL << bits
+                };
+
+                // Encoded data is stored in chunks of up to this size. A
+                // block never spans chunks.
+                enum : std::size_t {
+                    chunk_bits = 22,
+                    chunk_size = 1ULL << chunk_bits,
+
+                    // Two varints with at most 10 bytes for each location
+                    max_encoded_block_size = block_size * 2 * 10
+                };
+
+                struct block_entry {
+                    uint64_t block;
+                    uint64_t bitmap;
+                    uint64_t offset;
+
+                    bool operator<(const block_entry& other) const noexcept {
+                        return block < other.block;
+                    }
+                };
+
+                // Blocks that have been encoded, ordered by block number if
+                // m_sorted is true.
+                std::vector<block_entry> m_entries;
+
+                std::vector<std::vector<unsigned char>> m_chunks;
+
+                // The block currently being filled is kept unencoded.
+                TValue m_open_values[block_size];
+                uint64_t m_open_bitmap = 0;
+                uint64_t m_open_block = 0;
+
+                bool m_sorted = true;
+
+                static uint64_t block(const uint64_t id) noexcept {
+                    return id >> bits;
+                }
+
+                static uint64_t offset(const uint64_t id) noexcept {
+                    return id & (block_size - 1);
+                }
+
+                // Encode the locations in values for which a bit in bitmap
+                // is set and append a new block entry.
+                void encode_block(const uint64_t block_num, const uint64_t bitmap, const TValue* values) {
+                    unsigned char buffer[max_encoded_block_size];
+                    unsigned char* data = buffer;
+                    int64_t x = 0;
+                    int64_t y = 0;
+                    for (uint64_t i = 0; i < block_size; ++i) {
+                        if (bitmap & (1ULL << i)) {
+                            data = detail::write_varint(data, detail::zigzag_encode(values[i].x() - x));
+                            data = detail::write_varint(data, detail::zigzag_encode(values[i].y() - y));
+                            x = values[i].x();
+                            y = values[i].y();
+                        }
+                    }
+
+                    const auto size = static_cast<std::size_t>(data - buffer);
+                    if (m_chunks.empty() || m_chunks.back().size() + size > chunk_size) {
+                        m_chunks.emplace_back();
+                    }
+                    auto& chunk = m_chunks.back();
+                    const uint64_t data_offset = ((m_chunks.size() - 1) << chunk_bits) + chunk.size();
+                    chunk.insert(chunk.end(), buffer, data);
+
+                    if (!m_entries.empty() && m_entries.back().block >= block_num) {
+                        m_sorted = false;
+                    }
+                    m_entries.push_back(block_entry{block_num, bitmap, data_offset});
+                }
+
+                static const unsigned char* block_data(const std::vector<std::vector<unsigned char>>& chunks, const block_entry& entry) noexcept {
+                    return chunks[entry.offset >> chunk_bits].data() + (entry.offset & (chunk_size - 1));
+                }
+
+                // Decode all locations of this block into values.
+                static void decode_block(const std::vector<std::vector<unsigned char>>& chunks, const block_entry& entry, TValue* values) noexcept {
+                    const unsigned char* data = block_data(chunks, entry);
+                    int64_t x = 0;
+                    int64_t y = 0;
+                    for (uint64_t i = 0; i < block_size; ++i) {
+                        if (entry.bitmap & (1ULL << i)) {
+                            x += detail::zigzag_decode(detail::read_varint(&data));
+                            y += detail::zigzag_decode(detail::read_varint(&data));
+                            values[i] = TValue{x, y};
+                        }
+                    }
+                }
+
+                // Decode the location with the given offset in this block.
+                static TValue decode_one(const unsigned char* data, const uint64_t bitmap, const uint64_t pos) noexcept {
+                    int count = detail::popcount(bitmap & ((1ULL << pos) - 1));
+                    int64_t x = 0;
+                    int64_t y = 0;
+                    do {
+                        x += detail::zigzag_decode(detail::read_varint(&data));
+                        y += detail::zigzag_decode(detail::read_varint(&data));
+                    } while (count-- > 0);
+                    return TValue{x, y};
+                }
+
+                void flush_open_block() {
+                    if (m_open_bitmap != 0) {
+                        encode_block(m_open_block, m_open_bitmap, m_open_values);
+                        m_open_bitmap = 0;
+                    }
+                }
+
+            public:
+
+                CompressedMem() = default;
+
+                std::size_t size() const noexcept final {
+                    std::size_t count = detail::popcount(m_open_bitmap);
+                    for (const auto& entry : m_entries) {
+                        count += detail::popcount(entry.bitmap);
+                    }
+                    return count;
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    std::size_t chunk_memory = 0;
+                    for (const auto& chunk : m_chunks) {
+                        chunk_memory += chunk.capacity();
+                    }
+                    return sizeof(CompressedMem) +
+                           (m_entries.capacity() * sizeof(block_entry)) +
+                           (m_chunks.capacity() * sizeof(std::vector<unsigned char>)) +
+                           chunk_memory;
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const uint64_t block_num = block(id);
+                    if (block_num != m_open_block) {
+                        flush_open_block();
+                        m_open_block = block_num;
+                    }
+                    m_open_bitmap |= 1ULL << offset(id);
+                    m_open_values[offset(id)] = value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const uint64_t block_num = block(id);
+                    const uint64_t pos = offset(id);
+
+                    if (block_num == m_open_block && (m_open_bitmap & (1ULL << pos))) {
+                        return m_open_values[pos];
+                    }
+
+                    const auto it = std::lower_bound(m_entries.begin(),
+                                                     m_entries.end(),
+                                                     block_entry{block_num, 0, 0});
+                    if (it == m_entries.end() || it->block != block_num || !(it->bitmap & (1ULL << pos))) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+
+                    return decode_one(block_data(m_chunks, *it), it->bitmap, pos);
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                void clear() final {
+                    m_entries.clear();
+                    m_entries.shrink_to_fit();
+                    m_chunks.clear();
+                    m_chunks.shrink_to_fit();
+                    m_open_bitmap = 0;
+                    m_open_block = 0;
+                    m_sorted = true;
+                }
+
+                /**
+                 * Encode the block currently being filled and, if locations
+                 * were not set in order of their Ids, sort all blocks and
+                 * merge blocks with the same block number. If the same Id
+                 * was set several times, the last value wins.
+                 */
+                void sort() final {
+                    flush_open_block();
+                    if (m_sorted) {
+                        return;
+                    }
+
+                    std::vector<block_entry> entries;
+                    entries.swap(m_entries);
+                    std::vector<std::vector<unsigned char>> chunks;
+                    chunks.swap(m_chunks);
+                    std::stable_sort(entries.begin(), entries.end());
+
+                    TValue values[block_size];
+                    for (auto it = entries.begin(); it != entries.end();) {
+                        uint64_t bitmap = 0;
+                        const auto block_num = it->block;
+                        for (; it != entries.end() && it->block == block_num; ++it) {
+                            decode_block(chunks, *it, values);
+                            bitmap |= it->bitmap;
+                        }
+                        encode_block(block_num, bitmap, values);
+                    }
+
+                    m_sorted = true;
+                }
+
+            }; // class CompressedMem
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedMem, compressed_mem)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_MEM_HPP
@@ -37,6 +37,12 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/detail/mmap_vector_anon.hpp> // IWYU pragma: keep
 #include <osmium/index/detail/vector_map.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <iterator>
+#include <string>
+#include <vector>
 
 #define OSMIUM_HAS_INDEX_MAP_DENSE_MMAP_ARRAY
 
@@ -49,6 +55,42 @@ namespace osmium {
             template <typename TId, typename TValue>
             using DenseMmapArray = VectorBasedDenseMap<osmium::detail::mmap_vector_anon<TValue>, TId, TValue>;
 
+            /**
+             * Create a DenseMmapArray from the map type config. The map
+             * type name can be followed by these options (separated by
+             * commas):
+             *
+             * * `hugepages`: Use transparent huge pages.
+             * * `hugetlb`: Use explicit huge pages (they must have been
+             *   reserved by the administrator).
+             * * `numa_interleave`: Interleave memory over all NUMA nodes.
+             * * `numa_local`: Allocate memory on the local NUMA node.
+             *
+             * Example: `dense_mmap_array,hugepages,numa_interleave`
+             *
+             * @throws osmium::map_factory_error if an option is unknown.
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, DenseMmapArray> {
+                DenseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    osmium::memory_mapping_options options;
+                    for (auto it = std::next(config.begin()); it != config.end(); ++it) {
+                        if (*it == "hugepages") {
+                            options.pages = osmium::huge_pages::transparent;
+                        } else if (*it == "hugetlb") {
+                            options.pages = osmium::huge_pages::hugetlb;
+                        } else if (*it == "numa_interleave") {
+                            options.numa = osmium::numa_policy::interleave;
+                        } else if (*it == "numa_local") {
+                            options.numa = osmium::numa_policy::local;
+                        } else {
+                            throw osmium::map_factory_error{"Unknown option '" + *it + "' for map type '" + config[0] + "'"};
+                        }
+                    }
+                    return new DenseMmapArray<TId, TValue>{options};
+                }
+            };
+
         } // namespace map
 
     } // namespace index
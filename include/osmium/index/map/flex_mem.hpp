@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 
@@ -232,6 +233,10 @@ namespace osmium {
                     std::sort(m_sparse_entries.begin(), m_sparse_entries.end());
                 }
 
+                void sort_parallel(osmium::thread::Pool& pool) final {
+                    osmium::index::detail::parallel_sort(pool, m_sparse_entries.begin(), m_sparse_entries.end());
+                }
+
                 /**
                  * Switch from using a sparse to a dense index. Usually you
                  * do not need to call this, because the FlexMem class will
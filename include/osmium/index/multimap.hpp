@@ -40,6 +40,10 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace thread {
+        class Pool;
+    } // namespace thread
+
     namespace index {
 
         /**
@@ -112,6 +116,15 @@ namespace osmium {
                     // default implementation is empty
                 }
 
+                /**
+                 * Sort data in multimap like sort(), but use several threads
+                 * from the given pool if the implementation can do that.
+                 * The default implementation calls sort().
+                 */
+                virtual void sort_parallel(osmium::thread::Pool& /*pool*/) {
+                    sort();
+                }
+
                 virtual void dump_as_list(const int /*fd*/) {
                     throw std::runtime_error{"can't dump as list"};
                 }
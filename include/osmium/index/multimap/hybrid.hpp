@@ -192,6 +192,10 @@ namespace osmium {
                     m_main.sort();
                 }
 
+                void sort_parallel(osmium::thread::Pool& pool) final {
+                    m_main.sort_parallel(pool);
+                }
+
             }; // class Hybrid
 
         } // namespace multimap
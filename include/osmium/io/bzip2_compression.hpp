@@ -43,6 +43,8 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/block_compressor.hpp>
+#include <osmium/io/detail/block_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
@@ -51,6 +53,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <bzlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
@@ -100,6 +103,125 @@ namespace osmium {
                 throw osmium::bzip2_error{error, errnum};
             }
 
+            /**
+             * Compress the input into a complete bzip2 stream. Several of
+             * these can be concatenated to form a valid bzip2 file.
+             */
+            inline std::string bzip2_compress_stream(const std::string& input) {
+                assert(input.size() < std::numeric_limits<unsigned int>::max() / 2);
+
+                // The bzip2 documentation says the output can be at most
+                // 1% larger than the input plus 600 bytes.
+                unsigned int size = static_cast<unsigned int>(input.size() + input.size() / 100 + 600);
+                std::string output(size, '\0');
+
+                const int result = ::BZ2_bzBuffToBuffCompress(&*output.begin(), &size,
+                                                              const_cast<char*>(input.data()), static_cast<unsigned int>(input.size()),
+                                                              6, 0, 0);
+                if (result != BZ_OK) {
+                    throw bzip2_error{"bzip2 error: compression failed", result};
+                }
+
+                output.resize(size);
+                return output;
+            }
+
+            /**
+             * Decompresses any number of bzip2 streams in a row. Used by
+             * the BlockDecompressor.
+             */
+            class bzip2_stream_inflater {
+
+                bz_stream m_bzstream;
+                bool m_initialized = false;
+                bool m_at_stream_end = true;
+
+                void end() noexcept {
+                    if (m_initialized) {
+                        BZ2_bzDecompressEnd(&m_bzstream);
+                        m_initialized = false;
+                    }
+                }
+
+            public:
+
+                enum : std::size_t {
+                    header_size = 10
+                };
+
+                // A stream starts with "BZh", the block size and then either
+                // the magic number of a block or of the end of the stream.
+                static bool is_stream_start(const char* data) noexcept {
+                    const auto* d = reinterpret_cast<const unsigned char*>(data);
+                    if (d[0] != 'B' || d[1] != 'Z' || d[2] != 'h' || d[3] < '1' || d[3] > '9') {
+                        return false;
+                    }
+                    return (d[4] == 0x31U && d[5] == 0x41U && d[6] == 0x59U && d[7] == 0x26U && d[8] == 0x53U && d[9] == 0x59U) ||
+                           (d[4] == 0x17U && d[5] == 0x72U && d[6] == 0x45U && d[7] == 0x38U && d[8] == 0x50U && d[9] == 0x90U);
+                }
+
+                [[noreturn]] static void throw_truncated_error() {
+                    throw bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                }
+
+                bzip2_stream_inflater() :
+                    m_bzstream() {
+                }
+
+                bzip2_stream_inflater(const bzip2_stream_inflater&) = delete;
+                bzip2_stream_inflater& operator=(const bzip2_stream_inflater&) = delete;
+
+                bzip2_stream_inflater(bzip2_stream_inflater&&) = delete;
+                bzip2_stream_inflater& operator=(bzip2_stream_inflater&&) = delete;
+
+                ~bzip2_stream_inflater() noexcept {
+                    end();
+                }
+
+                void decompress(const char* data, const std::size_t size, std::string& output) {
+                    assert(size < std::numeric_limits<unsigned int>::max());
+                    m_bzstream.next_in = const_cast<char*>(data);
+                    m_bzstream.avail_in = static_cast<unsigned int>(size);
+
+                    // Output buffer filled up, there might be more output
+                    // even if there is no input left.
+                    bool output_full = false;
+
+                    while (m_bzstream.avail_in > 0 || output_full) {
+                        if (m_at_stream_end) {
+                            end();
+                            const int result = BZ2_bzDecompressInit(&m_bzstream, 0, 0);
+                            if (result != BZ_OK) {
+                                throw bzip2_error{"bzip2 error: decompression init failed", result};
+                            }
+                            m_initialized = true;
+                            m_at_stream_end = false;
+                        }
+
+                        const std::size_t old_size = output.size();
+                        const std::size_t chunk_size = std::max(static_cast<std::size_t>(m_bzstream.avail_in) * 4, static_cast<std::size_t>(64UL * 1024UL));
+                        output.resize(old_size + chunk_size);
+                        m_bzstream.next_out = &output[old_size];
+                        m_bzstream.avail_out = static_cast<unsigned int>(chunk_size);
+
+                        const int result = BZ2_bzDecompress(&m_bzstream);
+                        output_full = result == BZ_OK && m_bzstream.avail_out == 0;
+                        output.resize(old_size + chunk_size - m_bzstream.avail_out);
+
+                        if (result == BZ_STREAM_END) {
+                            m_at_stream_end = true;
+                        } else if (result != BZ_OK) {
+                            throw bzip2_error{"bzip2 error: decompress failed", result};
+                        }
+                    }
+                }
+
+                bool at_stream_end() const noexcept {
+                    return m_at_stream_end;
+                }
+
+            }; // class bzip2_stream_inflater
+
             class file_wrapper {
 
                 FILE* m_file = nullptr;
@@ -442,6 +564,30 @@ namespace osmium {
                 return registered_bzip2_compression;
             }
 
+            const bool registered_bzip2_block_compressor = osmium::io::CompressionFactory::instance().register_block_compressor(osmium::io::file_compression::bzip2,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool, const std::size_t block_size) {
+                    return new osmium::io::detail::BlockCompressor{fd, sync, pool, block_size, [](const std::string& data) {
+                        return bzip2_compress_stream(data);
+                    }};
+                }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_bzip2_block_compressor() noexcept {
+                return registered_bzip2_block_compressor;
+            }
+
+            const bool registered_bzip2_block_decompressor = osmium::io::CompressionFactory::instance().register_block_decompressor(osmium::io::file_compression::bzip2,
+                [](const int fd, osmium::thread::Pool& pool) {
+                    return new osmium::io::detail::BlockDecompressor<bzip2_stream_inflater>{fd, pool};
+                }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_bzip2_block_decompressor() noexcept {
+                return registered_bzip2_block_decompressor;
+            }
+
         } // namespace detail
 
     } // namespace io
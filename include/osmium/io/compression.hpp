@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/detail/io_uring.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
@@ -52,6 +53,10 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace thread {
+        class Pool;
+    } // namespace thread
+
     namespace io {
 
         class Compressor {
@@ -80,6 +85,16 @@ namespace osmium {
 
             virtual void write(const std::string& data) = 0;
 
+            /**
+             * Write data the caller doesn't need any more. Compressors
+             * that have to keep the data around after returning can take
+             * it over instead of copying it. The default implementation
+             * calls write().
+             */
+            virtual void write_owned(std::string data) {
+                write(data);
+            }
+
             virtual void close() = 0;
 
             virtual std::size_t file_size() const {
@@ -152,6 +167,8 @@ namespace osmium {
             using create_compressor_type          = std::function<osmium::io::Compressor*(int, fsync)>;
             using create_decompressor_type_fd     = std::function<osmium::io::Decompressor*(int)>;
             using create_decompressor_type_buffer = std::function<osmium::io::Decompressor*(const char*, std::size_t)>;
+            using create_block_compressor_type    = std::function<osmium::io::Compressor*(int, fsync, osmium::thread::Pool&, std::size_t)>;
+            using create_block_decompressor_type  = std::function<osmium::io::Decompressor*(int, osmium::thread::Pool&)>;
 
         private:
 
@@ -163,6 +180,10 @@ namespace osmium {
 
             compression_map_type m_callbacks;
 
+            std::map<const osmium::io::file_compression, create_block_compressor_type> m_block_compressors;
+
+            std::map<const osmium::io::file_compression, create_block_decompressor_type> m_block_decompressors;
+
             CompressionFactory() = default;
 
             const callbacks_type& find_callbacks(const osmium::io::file_compression compression) const {
@@ -207,8 +228,36 @@ namespace osmium {
                 return m_callbacks.insert(cc).second;
             }
 
+            /**
+             * Register a function creating a compressor which compresses
+             * blocks of the specified size in parallel on a thread pool.
+             * This is optional, if it is not registered for some
+             * compression, the normal compressor will be used instead.
+             */
+            bool register_block_compressor(
+                osmium::io::file_compression compression,
+                const create_block_compressor_type& create_block_compressor) {
+
+                return m_block_compressors.emplace(compression, create_block_compressor).second;
+            }
+
+            /**
+             * Register a function creating a decompressor which
+             * decompresses independent streams in parallel on a thread
+             * pool. This is optional, if it is not registered for some
+             * compression, the normal decompressor will be used instead.
+             */
+            bool register_block_decompressor(
+                osmium::io::file_compression compression,
+                const create_block_decompressor_type& create_block_decompressor) {
+
+                return m_block_decompressors.emplace(compression, create_block_decompressor).second;
+            }
+
             void clear_register() {
                 m_callbacks.clear();
+                m_block_compressors.clear();
+                m_block_decompressors.clear();
             }
 
             template <typename... TArgs>
@@ -217,11 +266,39 @@ namespace osmium {
                 return std::unique_ptr<osmium::io::Compressor>(std::get<0>(callbacks)(std::forward<TArgs>(args)...));
             }
 
+            /**
+             * Create a compressor which compresses blocks of block_size
+             * bytes in parallel on the pool. Falls back to the normal
+             * compressor if there is no block compressor registered for
+             * this compression.
+             */
+            std::unique_ptr<osmium::io::Compressor> create_block_compressor(const osmium::io::file_compression compression, const int fd, const fsync sync, osmium::thread::Pool& pool, const std::size_t block_size) const {
+                const auto it = m_block_compressors.find(compression);
+                if (it == m_block_compressors.end()) {
+                    return create_compressor(compression, fd, sync);
+                }
+                return std::unique_ptr<osmium::io::Compressor>(it->second(fd, sync, pool, block_size));
+            }
+
             std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const int fd) const {
                 const auto callbacks = find_callbacks(compression);
                 return std::unique_ptr<osmium::io::Decompressor>(std::get<1>(callbacks)(fd));
             }
 
+            /**
+             * Create a decompressor which decompresses independent streams
+             * in parallel on the pool. Falls back to the normal
+             * decompressor if there is no block decompressor registered
+             * for this compression.
+             */
+            std::unique_ptr<osmium::io::Decompressor> create_block_decompressor(const osmium::io::file_compression compression, const int fd, osmium::thread::Pool& pool) const {
+                const auto it = m_block_decompressors.find(compression);
+                if (it == m_block_decompressors.end()) {
+                    return create_decompressor(compression, fd);
+                }
+                return std::unique_ptr<osmium::io::Decompressor>(it->second(fd, pool));
+            }
+
             std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const char* buffer, const std::size_t size) const {
                 const auto callbacks = find_callbacks(compression);
                 return std::unique_ptr<osmium::io::Decompressor>(std::get<2>(callbacks)(buffer, size));
@@ -234,11 +311,18 @@ namespace osmium {
             std::size_t m_file_size = 0;
             int m_fd;
 
+#ifdef OSMIUM_WITH_IO_URING
+            std::unique_ptr<osmium::io::detail::UringWriter> m_uring;
+#endif
+
         public:
 
             NoCompressor(const int fd, const fsync sync) :
                 Compressor(sync),
                 m_fd(fd) {
+#ifdef OSMIUM_WITH_IO_URING
+                m_uring = osmium::io::detail::make_uring_io<osmium::io::detail::UringWriter>(fd);
+#endif
             }
 
             NoCompressor(const NoCompressor&) = delete;
@@ -256,12 +340,35 @@ namespace osmium {
             }
 
             void write(const std::string& data) override {
+#ifdef OSMIUM_WITH_IO_URING
+                if (m_uring) {
+                    write_owned(data);
+                    return;
+                }
+#endif
                 osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
                 m_file_size += data.size();
             }
 
+            void write_owned(std::string data) override {
+#ifdef OSMIUM_WITH_IO_URING
+                if (m_uring) {
+                    m_file_size += data.size();
+                    m_uring->write(std::move(data));
+                    return;
+                }
+#endif
+                write(data);
+            }
+
             void close() override {
                 if (m_fd >= 0) {
+#ifdef OSMIUM_WITH_IO_URING
+                    if (m_uring) {
+                        const auto uring = std::move(m_uring);
+                        uring->flush();
+                    }
+#endif
                     const int fd = m_fd;
                     m_fd = -1;
 
@@ -321,6 +428,20 @@ namespace osmium {
             std::size_t m_buffer_size = 0;
             std::size_t m_offset = 0;
 
+#ifdef OSMIUM_WITH_IO_URING
+            std::unique_ptr<osmium::io::detail::UringReader> m_uring;
+            bool m_uring_checked = false;
+#endif
+
+            void read_from_file(std::string& buffer) {
+                buffer.resize(osmium::io::Decompressor::input_buffer_size);
+                if (want_buffered_pages_removed()) {
+                    osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                }
+                const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
+                buffer.resize(static_cast<std::string::size_type>(nread));
+            }
+
         public:
 
             explicit NoDecompressor(const int fd) :
@@ -356,12 +477,25 @@ namespace osmium {
                         buffer.append(m_buffer, size);
                     }
                 } else {
-                    buffer.resize(osmium::io::Decompressor::input_buffer_size);
-                    if (want_buffered_pages_removed()) {
-                        osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+#ifdef OSMIUM_WITH_IO_URING
+                    // This is done here instead of in the constructor,
+                    // because want_buffered_pages_removed() is only set
+                    // after construction. Removing buffered pages doesn't
+                    // work with io_uring reading ahead.
+                    if (!m_uring_checked) {
+                        m_uring_checked = true;
+                        if (!want_buffered_pages_removed()) {
+                            m_uring = osmium::io::detail::make_uring_io<osmium::io::detail::UringReader>(m_fd);
+                        }
+                    }
+                    if (m_uring) {
+                        buffer = m_uring->read();
+                    } else {
+                        read_from_file(buffer);
                     }
-                    const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
-                    buffer.resize(static_cast<std::string::size_type>(nread));
+#else
+                    read_from_file(buffer);
+#endif
                 }
 
                 m_offset += buffer.size();
@@ -372,6 +506,9 @@ namespace osmium {
 
             void close() override {
                 if (m_fd >= 0) {
+#ifdef OSMIUM_WITH_IO_URING
+                    m_uring.reset();
+#endif
                     if (want_buffered_pages_removed()) {
                         osmium::io::detail::remove_buffered_pages(m_fd);
                     }
@@ -0,0 +1,250 @@
+#ifndef OSMIUM_IO_DETAIL_BLOCK_COMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_BLOCK_COMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            enum : std::size_t {
+                default_compression_block_size = 1024UL * 1024UL,
+                min_compression_block_size = 1024UL,
+                max_compression_block_size = 1024UL * 1024UL * 1024UL
+            };
+
+            /**
+             * Get the block size for parallel compression from the
+             * "compression_block_size" option of the file. Returns the
+             * default size if the option is not set.
+             *
+             * @throws std::invalid_argument If the option is not a number
+             *         or out of range.
+             */
+            inline std::size_t get_compression_block_size(const osmium::io::File& file) {
+                const auto value = file.get("compression_block_size");
+                if (value.empty()) {
+                    return default_compression_block_size;
+                }
+
+                char* end_ptr = nullptr;
+                errno = 0;
+                const auto size = std::strtoull(value.c_str(), &end_ptr, 10);
+                if (*end_ptr != '\0' || errno != 0 || value[0] == '-' ||
+                    size < min_compression_block_size || size > max_compression_block_size) {
+                    throw std::invalid_argument{"The 'compression_block_size' option must be an integer between 1024 and 1073741824."};
+                }
+
+                return static_cast<std::size_t>(size);
+            }
+
+            /**
+             * Compressor that splits the data into blocks of a fixed size
+             * and compresses each block independently on the thread pool.
+             * The compressed blocks are written out in order, so the file
+             * is a concatenation of complete compressed streams ("members"
+             * in gzip terminology). This is how pigz and pbzip2 work, the
+             * resulting files can be read with the usual tools.
+             *
+             * The number of blocks in flight is limited to twice the number
+             * of threads in the pool to keep memory use bounded.
+             */
+            class BlockCompressor final : public osmium::io::Compressor {
+
+            public:
+
+                using compress_function_type = std::function<std::string(const std::string&)>;
+
+            private:
+
+                std::size_t m_file_size = 0;
+                std::size_t m_block_size;
+                std::size_t m_max_pending;
+                osmium::thread::Pool* m_pool;
+                compress_function_type m_compress;
+                std::string m_data;
+                std::deque<std::future<std::string>> m_pending;
+                bool m_has_blocks = false;
+                int m_fd;
+
+                void submit_block() {
+                    std::string data;
+                    data.reserve(m_block_size);
+                    using std::swap;
+                    swap(data, m_data);
+
+                    m_pending.push_back(m_pool->submit([compress = m_compress, data = std::move(data)]() {
+                        return compress(data);
+                    }));
+                    m_has_blocks = true;
+                }
+
+                // Write out compressed blocks from the front of the queue.
+                // If wait_for_all is set, all blocks are written, otherwise
+                // only those that are ready and as many as are needed to
+                // get below the limit of pending blocks.
+                void write_blocks(bool wait_for_all) {
+                    while (!m_pending.empty()) {
+                        if (!wait_for_all &&
+                            m_pending.size() < m_max_pending &&
+                            m_pending.front().wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                            return;
+                        }
+                        const std::string compressed{m_pending.front().get()};
+                        m_pending.pop_front();
+                        osmium::io::detail::reliable_write(m_fd, compressed.data(), compressed.size());
+                        m_file_size += compressed.size();
+                    }
+                }
+
+            public:
+
+                /**
+                 * Create a BlockCompressor.
+                 *
+                 * @param fd File descriptor to write to.
+                 * @param sync Should fsync be called on the file before closing it?
+                 * @param pool Thread pool to use for compressing blocks.
+                 * @param block_size Size of uncompressed blocks.
+                 * @param compress Function compressing one block into a complete
+                 *                 compressed stream.
+                 */
+                BlockCompressor(const int fd, const fsync sync, osmium::thread::Pool& pool, const std::size_t block_size, compress_function_type compress) :
+                    Compressor(sync),
+                    m_block_size(block_size),
+                    m_max_pending(2 * static_cast<std::size_t>(pool.num_threads()) + 1),
+                    m_pool(&pool),
+                    m_compress(std::move(compress)),
+                    m_fd(fd) {
+                    m_data.reserve(block_size);
+                }
+
+                BlockCompressor(const BlockCompressor&) = delete;
+                BlockCompressor& operator=(const BlockCompressor&) = delete;
+
+                BlockCompressor(BlockCompressor&&) = delete;
+                BlockCompressor& operator=(BlockCompressor&&) = delete;
+
+                ~BlockCompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                void write(const std::string& data) override {
+                    const char* ptr = data.data();
+                    std::size_t size = data.size();
+                    while (size > 0) {
+                        const auto n = std::min(size, m_block_size - m_data.size());
+                        m_data.append(ptr, n);
+                        ptr += n;
+                        size -= n;
+                        if (m_data.size() == m_block_size) {
+                            submit_block();
+                        }
+                    }
+                    write_blocks(false);
+                }
+
+                void close() override {
+                    if (m_fd >= 0) {
+                        // Always write at least one block, so that the
+                        // output is a valid compressed file even if it
+                        // is empty.
+                        if (!m_data.empty() || !m_has_blocks) {
+                            submit_block();
+                        }
+
+                        const int fd = m_fd;
+                        try {
+                            write_blocks(true);
+                        } catch (...) {
+                            m_fd = -1;
+                            m_pending.clear();
+                            if (fd != 1) {
+                                try {
+                                    osmium::io::detail::reliable_close(fd);
+                                } catch (...) { // NOLINT(bugprone-empty-catch)
+                                    // Ignore, the original exception is more important.
+                                }
+                            }
+                            throw;
+                        }
+                        m_fd = -1;
+
+                        // Do not sync or close stdout
+                        if (fd == 1) {
+                            return;
+                        }
+
+                        if (do_fsync()) {
+                            osmium::io::detail::reliable_fsync(fd);
+                        }
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                }
+
+                std::size_t file_size() const override {
+                    return m_file_size;
+                }
+
+            }; // class BlockCompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BLOCK_COMPRESSOR_HPP
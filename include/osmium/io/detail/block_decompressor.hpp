@@ -0,0 +1,326 @@
+#ifndef OSMIUM_IO_DETAIL_BLOCK_DECOMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_BLOCK_DECOMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decompressor for files made up of several independent
+             * compressed streams ("members" in gzip terminology) like the
+             * ones written by pbzip2 or the BlockCompressor. The input is
+             * cut into jobs at places that look like the start of a stream
+             * and the jobs are decompressed in parallel on the thread pool.
+             * The results are returned in order.
+             *
+             * A place can look like the start of a stream without being one.
+             * This is detected when the decompression of the job before it
+             * doesn't end exactly at the end of a stream. In that case the
+             * job is merged with the next one and decompressed again. The
+             * start of the first job that hasn't been returned yet is always
+             * a real stream boundary, so errors in that job are real errors.
+             *
+             * If no stream boundary can be found in max_job_size bytes, for
+             * instance because the file only contains one huge stream, this
+             * falls back to decompressing the rest of the input serially in
+             * the reading thread.
+             *
+             * @tparam TInflater Class that decompresses one or more streams
+             *         in a row. It must have these members:
+             *         - static constexpr std::size_t header_size: Number of
+             *           bytes needed to recognize the start of a stream.
+             *         - static bool is_stream_start(const char* data): Do
+             *           the header_size bytes at data look like the start
+             *           of a stream?
+             *         - void decompress(const char* data, std::size_t size,
+             *           std::string& output): Decompress all input and append
+             *           the result to output. Throws on errors.
+             *         - bool at_stream_end() const: Did the input so far end
+             *           exactly at the end of a stream?
+             *         - [[noreturn]] static void throw_truncated_error()
+             */
+            template <typename TInflater>
+            class BlockDecompressor final : public osmium::io::Decompressor {
+
+            public:
+
+                enum : std::size_t {
+                    default_min_job_size = 1024UL * 1024UL,
+                    default_max_job_size = 64UL * 1024UL * 1024UL
+                };
+
+            private:
+
+                struct job_result {
+                    std::string output;
+                    bool complete = false;
+                };
+
+                struct job {
+                    std::shared_ptr<const std::string> data;
+                    std::future<job_result> result;
+                };
+
+                osmium::thread::Pool* m_pool;
+
+                // Input not assigned to any job yet. It always starts at
+                // the end of the last job.
+                std::string m_input;
+
+                // Position in m_input up to which we have looked for the
+                // start of a stream.
+                std::size_t m_scan_pos = 0;
+
+                std::size_t m_offset = 0;
+
+                std::deque<job> m_jobs;
+                std::size_t m_max_jobs;
+
+                std::size_t m_min_job_size;
+                std::size_t m_max_job_size;
+
+                std::unique_ptr<TInflater> m_serial_inflater;
+                bool m_serial = false;
+
+                bool m_eof = false;
+
+                int m_fd;
+
+                job submit_job(std::string&& data) {
+                    auto shared_data = std::make_shared<const std::string>(std::move(data));
+                    auto future = m_pool->submit([shared_data]() {
+                        job_result result;
+                        TInflater inflater;
+                        inflater.decompress(shared_data->data(), shared_data->size(), result.output);
+                        result.complete = inflater.at_stream_end();
+                        return result;
+                    });
+                    return job{std::move(shared_data), std::move(future)};
+                }
+
+                bool read_input() {
+                    if (m_eof) {
+                        return false;
+                    }
+
+                    if (want_buffered_pages_removed() && m_offset > 0) {
+                        osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                    }
+
+                    const auto old_size = m_input.size();
+                    m_input.resize(old_size + osmium::io::Decompressor::input_buffer_size);
+                    const auto nread = osmium::io::detail::reliable_read(m_fd, &m_input[old_size], osmium::io::Decompressor::input_buffer_size);
+                    m_input.resize(old_size + static_cast<std::size_t>(nread));
+
+                    if (nread == 0) {
+                        m_eof = true;
+                        return false;
+                    }
+
+                    m_offset += static_cast<std::size_t>(nread);
+                    set_offset(m_offset);
+                    return true;
+                }
+
+                // Cut jobs from the input at the first stream start after
+                // min_job_size bytes.
+                void cut_jobs() {
+                    while (m_input.size() >= m_min_job_size + TInflater::header_size) {
+                        const char* const data = m_input.data();
+                        const char* const end = data + m_input.size() - TInflater::header_size + 1;
+                        const char* it = data + std::max(m_scan_pos, m_min_job_size);
+                        while (it < end && !TInflater::is_stream_start(it)) {
+                            ++it;
+                        }
+                        if (it >= end) {
+                            m_scan_pos = m_input.size() - TInflater::header_size + 1;
+                            if (m_input.size() > m_max_job_size) {
+                                m_serial = true;
+                            }
+                            return;
+                        }
+                        const auto pos = static_cast<std::size_t>(it - data);
+                        m_jobs.push_back(submit_job(m_input.substr(0, pos)));
+                        m_input.erase(0, pos);
+                        m_scan_pos = 0;
+                    }
+                }
+
+                void fill_jobs() {
+                    while (!m_serial && m_jobs.size() < m_max_jobs) {
+                        if (!read_input()) {
+                            if (!m_input.empty()) {
+                                m_jobs.push_back(submit_job(std::move(m_input)));
+                                m_input.clear();
+                                m_scan_pos = 0;
+                            }
+                            return;
+                        }
+                        cut_jobs();
+                    }
+                }
+
+                std::string read_serial() {
+                    if (!m_serial_inflater) {
+                        m_serial_inflater.reset(new TInflater{});
+                    }
+
+                    std::string output;
+                    while (output.empty()) {
+                        if (m_input.empty() && !read_input()) {
+                            if (!m_serial_inflater->at_stream_end()) {
+                                TInflater::throw_truncated_error();
+                            }
+                            break;
+                        }
+                        m_serial_inflater->decompress(m_input.data(), m_input.size(), output);
+                        m_input.clear();
+                    }
+
+                    return output;
+                }
+
+            public:
+
+                /**
+                 * Create a BlockDecompressor.
+                 *
+                 * @param fd File descriptor to read from.
+                 * @param pool Thread pool to use for decompressing jobs.
+                 * @param min_job_size Minimum size of the compressed input
+                 *                     for one job.
+                 * @param max_job_size If no stream start is found in this
+                 *                     many bytes, decompress serially.
+                 */
+                BlockDecompressor(const int fd, osmium::thread::Pool& pool,
+                                  const std::size_t min_job_size = default_min_job_size,
+                                  const std::size_t max_job_size = default_max_job_size) :
+                    m_pool(&pool),
+                    m_max_jobs(2 * static_cast<std::size_t>(pool.num_threads()) + 1),
+                    m_min_job_size(min_job_size),
+                    m_max_job_size(max_job_size),
+                    m_fd(fd) {
+                }
+
+                BlockDecompressor(const BlockDecompressor&) = delete;
+                BlockDecompressor& operator=(const BlockDecompressor&) = delete;
+
+                BlockDecompressor(BlockDecompressor&&) = delete;
+                BlockDecompressor& operator=(BlockDecompressor&&) = delete;
+
+                ~BlockDecompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                std::string read() override {
+                    while (true) {
+                        fill_jobs();
+
+                        if (m_jobs.empty()) {
+                            if (m_serial) {
+                                return read_serial();
+                            }
+                            return std::string{};
+                        }
+
+                        job_result result = m_jobs.front().result.get();
+                        if (result.complete) {
+                            m_jobs.pop_front();
+                            if (!result.output.empty()) {
+                                return std::move(result.output);
+                            }
+                            continue;
+                        }
+
+                        // The job didn't end at the end of a stream, so the
+                        // start of the next job wasn't a real stream start.
+                        std::string data{*m_jobs.front().data};
+                        m_jobs.pop_front();
+
+                        if (!m_jobs.empty()) {
+                            data += *m_jobs.front().data;
+                            m_jobs.front() = submit_job(std::move(data));
+                            continue;
+                        }
+
+                        if (m_eof && !m_serial) {
+                            TInflater::throw_truncated_error();
+                        }
+
+                        // Put the data back in front of the remaining input
+                        // and go on from there.
+                        m_scan_pos += data.size();
+                        m_input.insert(0, data);
+                    }
+                }
+
+                void close() override {
+                    if (m_fd >= 0) {
+                        m_jobs.clear();
+                        if (want_buffered_pages_removed()) {
+                            osmium::io::detail::remove_buffered_pages(m_fd);
+                        }
+                        const int fd = m_fd;
+                        m_fd = -1;
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                }
+
+            }; // class BlockDecompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BLOCK_DECOMPRESSOR_HPP
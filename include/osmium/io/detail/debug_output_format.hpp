@@ -343,8 +343,8 @@ namespace osmium {
 
             public:
 
-                DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
                     m_options(options),
                     m_utf8_prefix(options.use_color ? color_red  : ""),
                     m_utf8_suffix(options.use_color ? color_blue : "") {
@@ -352,6 +352,7 @@ namespace osmium {
 
                 std::string operator()() {
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
 
                     std::string out;
                     using std::swap;
@@ -591,7 +592,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options, buffer_pool()}));
                 }
 
             }; // class DebugOutputFormat
@@ -39,7 +39,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
@@ -49,11 +52,14 @@ DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
     namespace io {
 
+        class PBFBlobIndex;
+
         namespace detail {
 
             struct parser_arguments {
@@ -67,6 +73,15 @@ namespace osmium {
                 osmium::io::read_meta read_metadata;
                 osmium::io::buffers_type buffers_kind;
                 bool want_buffered_pages_removed;
+
+                // Optional settings, set them by name after initializing
+                // the members above.
+                const osmium::io::PBFBlobIndex* pbf_blob_index = nullptr;
+                bool use_mmap = false;
+                bool parallel_parsing = false;
+                bool use_xml_scanner = false;
+                osmium::Box filter_box{};
+                osmium::memory::BufferPool* buffer_pool = nullptr;
             };
 
             class Parser {
@@ -202,6 +217,10 @@ namespace osmium {
                     return m_buffer;
                 }
 
+                osmium::io::buffers_type buffers_kind() const noexcept {
+                    return m_buffers_kind;
+                }
+
                 void flush_nested_buffer() {
                     if (m_buffer.has_nested_buffers()) {
                         std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
@@ -215,21 +234,94 @@ namespace osmium {
                     }
                 }
 
+                // Send the current buffer on (unless it is empty) and
+                // start a new one.
+                void flush_buffer() {
+                    if (m_buffer.committed() > 0) {
+                        osmium::memory::Buffer new_buffer{initial_buffer_size,
+                                                          osmium::memory::Buffer::auto_grow::internal};
+                        using std::swap;
+                        swap(new_buffer, m_buffer);
+                        send_to_output_queue(std::move(new_buffer));
+                    }
+                }
+
                 void maybe_new_buffer(osmium::item_type current_type) {
                     if (m_buffers_kind == buffers_type::any) {
                         return;
                     }
 
-                    if (is_different_type(current_type) && m_buffer.committed() > 0) {
+                    if (is_different_type(current_type)) {
+                        flush_buffer();
+                    }
+                }
+
+            }; // class ParserWithBuffer
+
+            /**
+             * Collects the buffers created when parsing a chunk of input
+             * data on the thread pool. It has the same interface for
+             * filling buffers as the ParserWithBuffer class, but instead
+             * of sending the buffers to the output queue they are kept
+             * until the chunk is done and then returned all at once.
+             */
+            class ChunkBuffers {
+
+                enum {
+                    initial_buffer_size = 1024UL * 1024UL
+                };
+
+                std::vector<osmium::memory::Buffer> m_buffers;
+                osmium::memory::Buffer m_buffer{initial_buffer_size,
+                                                osmium::memory::Buffer::auto_grow::internal};
+
+                osmium::io::buffers_type m_buffers_kind;
+                osmium::item_type m_last_type = osmium::item_type::undefined;
+
+            public:
+
+                explicit ChunkBuffers(osmium::io::buffers_type buffers_kind) noexcept :
+                    m_buffers_kind(buffers_kind) {
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
+                }
+
+                void flush_nested_buffer() {
+                    if (m_buffer.has_nested_buffers()) {
+                        std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
+                        m_buffers.push_back(std::move(*buffer_ptr));
+                    }
+                }
+
+                void maybe_new_buffer(osmium::item_type current_type) {
+                    if (m_buffers_kind == buffers_type::any || m_last_type == current_type) {
+                        return;
+                    }
+
+                    if (m_last_type != osmium::item_type::undefined && m_buffer.committed() > 0) {
                         osmium::memory::Buffer new_buffer{initial_buffer_size,
                                                           osmium::memory::Buffer::auto_grow::internal};
                         using std::swap;
                         swap(new_buffer, m_buffer);
-                        send_to_output_queue(std::move(new_buffer));
+                        m_buffers.push_back(std::move(new_buffer));
+                    }
+                    m_last_type = current_type;
+                }
+
+                /**
+                 * Get all buffers filled so far in order. The object can
+                 * not be used any more after this.
+                 */
+                std::vector<osmium::memory::Buffer> get_buffers() {
+                    if (m_buffer.committed() > 0) {
+                        m_buffers.push_back(std::move(m_buffer));
                     }
+                    return std::move(m_buffers);
                 }
 
-            }; // class ParserWithBuffer
+            }; // class ChunkBuffers
 
             /**
              * This factory class is used to create objects that decode OSM
@@ -0,0 +1,709 @@
+#ifndef OSMIUM_IO_DETAIL_IO_URING_HPP
+#define OSMIUM_IO_DETAIL_IO_URING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifdef OSMIUM_WITH_IO_URING
+
+/**
+ * @file
+ *
+ * Asynchronous reading and writing of regular files with the Linux
+ * io_uring interface. This uses the system calls directly, so it only
+ * needs the kernel headers (Linux 5.6 or newer) and not liburing.
+ *
+ * Define OSMIUM_WITH_IO_URING to use this. If io_uring is not available
+ * at runtime (old kernel, forbidden by a seccomp filter, ...), if the file
+ * is not a regular file, or if the environment variable
+ * OSMIUM_USE_IO_URING is set to "no", the usual blocking reads and writes
+ * are used.
+ */
+
+#include <osmium/util/config.hpp>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Minimal wrapper around an io_uring submission and completion
+             * queue pair.
+             */
+            class IoUring {
+
+                int m_fd = -1;
+
+                void* m_sq_ring = MAP_FAILED;
+                void* m_cq_ring = MAP_FAILED;
+                std::size_t m_sq_ring_size = 0;
+                std::size_t m_cq_ring_size = 0;
+
+                io_uring_sqe* m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+                std::size_t m_sqes_size = 0;
+
+                unsigned* m_sq_head = nullptr;
+                unsigned* m_sq_tail = nullptr;
+                unsigned* m_sq_array = nullptr;
+                unsigned m_sq_mask = 0;
+                unsigned m_sq_entries = 0;
+
+                unsigned* m_cq_head = nullptr;
+                unsigned* m_cq_tail = nullptr;
+                io_uring_cqe* m_cqes = nullptr;
+                unsigned m_cq_mask = 0;
+
+                // Entries filled in after the submission queue tail, but
+                // not yet handed to the kernel.
+                unsigned m_to_submit = 0;
+
+                static void* map(std::size_t size, int fd, off_t offset) {
+                    void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset); // NOLINT(hicpp-signed-bitwise)
+                    if (ptr == MAP_FAILED) {
+                        throw std::system_error{errno, std::system_category(), "mmap of io_uring failed"};
+                    }
+                    return ptr;
+                }
+
+                template <typename T>
+                T* sq_ptr(unsigned offset) const noexcept {
+                    return reinterpret_cast<T*>(static_cast<char*>(m_sq_ring) + offset);
+                }
+
+                template <typename T>
+                T* cq_ptr(unsigned offset) const noexcept {
+                    return reinterpret_cast<T*>(static_cast<char*>(m_cq_ring) + offset);
+                }
+
+                void cleanup() noexcept {
+                    if (m_sqes != MAP_FAILED) {
+                        ::munmap(m_sqes, m_sqes_size);
+                    }
+                    if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring) {
+                        ::munmap(m_cq_ring, m_cq_ring_size);
+                    }
+                    if (m_sq_ring != MAP_FAILED) {
+                        ::munmap(m_sq_ring, m_sq_ring_size);
+                    }
+                    if (m_fd >= 0) {
+                        ::close(m_fd);
+                    }
+                }
+
+                void setup(unsigned entries) {
+                    io_uring_params params{};
+                    m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+                    if (m_fd < 0) {
+                        throw std::system_error{errno, std::system_category(), "io_uring_setup failed"};
+                    }
+
+                    // IORING_OP_READ and IORING_OP_WRITE are available
+                    // since Linux 5.6, which is also when this appeared.
+                    if (!(params.features & IORING_FEAT_RW_CUR_POS)) { // NOLINT(hicpp-signed-bitwise)
+                        throw std::system_error{ENOSYS, std::system_category(), "io_uring too old"};
+                    }
+
+                    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+                    if (params.features & IORING_FEAT_SINGLE_MMAP) { // NOLINT(hicpp-signed-bitwise)
+                        m_sq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+                        m_sq_ring = map(m_sq_ring_size, m_fd, IORING_OFF_SQ_RING);
+                        m_cq_ring = m_sq_ring;
+                    } else {
+                        m_sq_ring = map(m_sq_ring_size, m_fd, IORING_OFF_SQ_RING);
+                        m_cq_ring = map(m_cq_ring_size, m_fd, IORING_OFF_CQ_RING);
+                    }
+
+                    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+                    m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, m_fd, IORING_OFF_SQES));
+
+                    m_sq_head = sq_ptr<unsigned>(params.sq_off.head);
+                    m_sq_tail = sq_ptr<unsigned>(params.sq_off.tail);
+                    m_sq_array = sq_ptr<unsigned>(params.sq_off.array);
+                    m_sq_mask = *sq_ptr<unsigned>(params.sq_off.ring_mask);
+                    m_sq_entries = params.sq_entries;
+
+                    m_cq_head = cq_ptr<unsigned>(params.cq_off.head);
+                    m_cq_tail = cq_ptr<unsigned>(params.cq_off.tail);
+                    m_cqes = cq_ptr<io_uring_cqe>(params.cq_off.cqes);
+                    m_cq_mask = *cq_ptr<unsigned>(params.cq_off.ring_mask);
+                }
+
+            public:
+
+                /**
+                 * Set up an io_uring with (at least) the specified number
+                 * of submission queue entries.
+                 *
+                 * @throws std::system_error If io_uring is not available.
+                 */
+                explicit IoUring(unsigned entries) {
+                    try {
+                        setup(entries);
+                    } catch (...) {
+                        cleanup();
+                        throw;
+                    }
+                }
+
+                IoUring(const IoUring&) = delete;
+                IoUring& operator=(const IoUring&) = delete;
+
+                IoUring(IoUring&&) = delete;
+                IoUring& operator=(IoUring&&) = delete;
+
+                ~IoUring() noexcept {
+                    cleanup();
+                }
+
+                /**
+                 * Register a memory area with the kernel so that it can be
+                 * used with the *_FIXED operations (buffer index 0).
+                 *
+                 * @returns false if registering failed, usually because of
+                 *          the RLIMIT_MEMLOCK limit.
+                 */
+                bool register_buffer(void* buffer, std::size_t size) noexcept {
+                    iovec iov{buffer, size};
+                    return ::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+                }
+
+                /**
+                 * Get the next free submission queue entry (cleared) or
+                 * nullptr if the queue is full.
+                 */
+                io_uring_sqe* get_sqe() noexcept {
+                    const unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+                    const unsigned tail = *m_sq_tail + m_to_submit;
+                    if (tail - head >= m_sq_entries) {
+                        return nullptr;
+                    }
+
+                    const unsigned index = tail & m_sq_mask;
+                    io_uring_sqe* sqe = &m_sqes[index];
+                    std::memset(sqe, 0, sizeof(io_uring_sqe));
+                    m_sq_array[index] = index;
+                    ++m_to_submit;
+
+                    return sqe;
+                }
+
+                /**
+                 * Hand all new submission queue entries to the kernel and
+                 * wait until at least wait_nr completions are available.
+                 *
+                 * @throws std::system_error On error.
+                 */
+                void submit(unsigned wait_nr = 0) {
+                    if (m_to_submit > 0) {
+                        // make the new entries visible to the kernel
+                        __atomic_store_n(m_sq_tail, *m_sq_tail + m_to_submit, __ATOMIC_RELEASE);
+                    }
+
+                    unsigned to_submit = m_to_submit;
+                    m_to_submit = 0;
+                    while (to_submit > 0 || wait_nr > 0) {
+                        const unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0U;
+                        const auto result = ::syscall(__NR_io_uring_enter, m_fd, to_submit, wait_nr, flags, nullptr, 0);
+                        if (result < 0) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            throw std::system_error{errno, std::system_category(), "io_uring_enter failed"};
+                        }
+                        to_submit -= static_cast<unsigned>(result);
+                        if (to_submit == 0) {
+                            return;
+                        }
+                    }
+                }
+
+                /**
+                 * Take the next completion off the completion queue.
+                 *
+                 * @returns false if there is none.
+                 */
+                bool get_completion(uint64_t* user_data, int32_t* result) noexcept {
+                    const unsigned head = *m_cq_head;
+                    if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+                        return false;
+                    }
+
+                    const io_uring_cqe& cqe = m_cqes[head & m_cq_mask];
+                    *user_data = cqe.user_data;
+                    *result = cqe.res;
+                    __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+
+                    return true;
+                }
+
+            }; // class IoUring
+
+            /**
+             * Can io_uring be used for the file descriptor? It must be a
+             * regular file, because several reads or writes at different
+             * offsets are in flight at the same time. For writing the file
+             * must not be opened with O_APPEND.
+             */
+            inline bool io_uring_usable(int fd, bool for_writing) noexcept {
+                if (!osmium::config::use_io_uring()) {
+                    return false;
+                }
+
+                struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                if (::fstat(fd, &s) != 0 || !S_ISREG(s.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                    return false;
+                }
+
+                if (for_writing) {
+                    const int flags = ::fcntl(fd, F_GETFL);
+                    if (flags < 0 || (flags & O_APPEND)) { // NOLINT(hicpp-signed-bitwise)
+                        return false;
+                    }
+                }
+
+                return ::lseek(fd, 0, SEEK_CUR) >= 0;
+            }
+
+            /**
+             * Reads a file sequentially with several large reads in flight
+             * at the same time. The reads start at the current file
+             * position and go into one memory area which is registered
+             * with the kernel if possible. When this object is destroyed,
+             * the file position is set to the end of the data consumed.
+             */
+            class UringReader {
+
+                struct block {
+                    uint64_t offset = 0;
+                    std::size_t size = 0;
+                    bool in_flight = false;
+                    bool eof = false;
+                };
+
+                std::size_t m_block_size;
+                std::unique_ptr<char[]> m_memory;
+                std::vector<block> m_blocks;
+                IoUring m_ring;
+                int m_fd;
+                bool m_fixed_buffers;
+
+                // The file offset where the next block to be submitted
+                // starts.
+                uint64_t m_next_offset;
+
+                // The block currently consumed and the position in it.
+                std::size_t m_current = 0;
+                std::size_t m_pos = 0;
+
+                unsigned m_in_flight = 0;
+
+                // Set when any read returned end of file. No new blocks
+                // are submitted after that.
+                bool m_eof = false;
+
+                char* block_data(std::size_t index) const noexcept {
+                    return m_memory.get() + index * m_block_size;
+                }
+
+                void submit_block(std::size_t index) {
+                    block& b = m_blocks[index];
+                    io_uring_sqe* sqe = m_ring.get_sqe();
+                    assert(sqe);
+
+                    sqe->opcode = m_fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                    sqe->fd = m_fd;
+                    sqe->off = b.offset + b.size;
+                    sqe->addr = reinterpret_cast<uint64_t>(block_data(index) + b.size);
+                    sqe->len = static_cast<uint32_t>(m_block_size - b.size);
+                    sqe->buf_index = 0;
+                    sqe->user_data = index;
+
+                    b.in_flight = true;
+                    ++m_in_flight;
+                }
+
+                void start_block(std::size_t index) {
+                    block& b = m_blocks[index];
+                    b.offset = m_next_offset;
+                    b.size = 0;
+                    b.eof = m_eof;
+                    if (!m_eof) {
+                        m_next_offset += m_block_size;
+                        submit_block(index);
+                    }
+                }
+
+                void handle_completions() {
+                    uint64_t index = 0;
+                    int32_t result = 0;
+                    while (m_ring.get_completion(&index, &result)) {
+                        block& b = m_blocks[index];
+                        b.in_flight = false;
+                        --m_in_flight;
+
+                        if (result == -EINTR || result == -EAGAIN) {
+                            submit_block(index);
+                        } else if (result < 0) {
+                            throw std::system_error{-result, std::system_category(), "Read failed"};
+                        } else if (result == 0) {
+                            b.eof = true;
+                            m_eof = true;
+                        } else {
+                            b.size += static_cast<std::size_t>(result);
+                            if (b.size < m_block_size) {
+                                // short read, try again for the rest
+                                submit_block(index);
+                            }
+                        }
+                    }
+                }
+
+                // Wait until the current block is complete and return it.
+                block& current_block() {
+                    block& b = m_blocks[m_current];
+                    while (b.in_flight) {
+                        m_ring.submit(1);
+                        handle_completions();
+                        m_ring.submit();
+                    }
+                    return b;
+                }
+
+                // Re-use the current block (which has been consumed) for
+                // reading ahead and switch to the next one.
+                void next_block() {
+                    start_block(m_current);
+                    m_ring.submit();
+                    m_current = (m_current + 1) % m_blocks.size();
+                    m_pos = 0;
+                }
+
+            public:
+
+                /**
+                 * @param fd File descriptor of a regular file.
+                 * @param block_size Size of each read.
+                 * @param num_blocks Number of reads in flight.
+                 * @throws std::system_error If io_uring can not be set up.
+                 */
+                explicit UringReader(int fd, std::size_t block_size = 1024UL * 1024UL, unsigned num_blocks = 8) :
+                    m_block_size(block_size),
+                    m_memory(new char[block_size * num_blocks]),
+                    m_blocks(num_blocks),
+                    m_ring(num_blocks),
+                    m_fd(fd),
+                    m_fixed_buffers(m_ring.register_buffer(m_memory.get(), block_size * num_blocks)),
+                    m_next_offset(static_cast<uint64_t>(::lseek(fd, 0, SEEK_CUR))) {
+                    for (std::size_t i = 0; i < m_blocks.size(); ++i) {
+                        start_block(i);
+                    }
+                    m_ring.submit();
+                }
+
+                UringReader(const UringReader&) = delete;
+                UringReader& operator=(const UringReader&) = delete;
+
+                UringReader(UringReader&&) = delete;
+                UringReader& operator=(UringReader&&) = delete;
+
+                ~UringReader() noexcept {
+                    // The kernel might still write into our memory, so we
+                    // have to wait for all outstanding reads.
+                    try {
+                        m_ring.submit();
+                        uint64_t index = 0;
+                        int32_t result = 0;
+                        while (m_in_flight > 0) {
+                            m_ring.submit(1);
+                            while (m_ring.get_completion(&index, &result)) {
+                                --m_in_flight;
+                            }
+                        }
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                    ::lseek(m_fd, static_cast<off_t>(m_blocks[m_current].offset + m_pos), SEEK_SET);
+                }
+
+                /**
+                 * Read the next part of the file, at most one block.
+                 *
+                 * @returns The data or an empty string at the end of file.
+                 * @throws std::system_error On error.
+                 */
+                std::string read() {
+                    while (true) {
+                        block& b = current_block();
+                        if (m_pos < b.size) {
+                            std::string data(block_data(m_current) + m_pos, b.size - m_pos);
+                            m_pos = b.size;
+                            return data;
+                        }
+                        if (b.eof) {
+                            return {};
+                        }
+                        next_block();
+                    }
+                }
+
+                /**
+                 * Read exactly size bytes into buffer. If buffer is
+                 * nullptr, the data is skipped.
+                 *
+                 * @returns true if size bytes could be read, false if the
+                 *          end of file was encountered before.
+                 * @throws std::system_error On error.
+                 */
+                bool read_exactly(char* buffer, std::size_t size) {
+                    while (size > 0) {
+                        block& b = current_block();
+                        if (m_pos < b.size) {
+                            const auto len = std::min(size, b.size - m_pos);
+                            if (buffer) {
+                                std::memcpy(buffer, block_data(m_current) + m_pos, len);
+                                buffer += len;
+                            }
+                            size -= len;
+                            m_pos += len;
+                        } else if (b.eof) {
+                            return false;
+                        } else {
+                            next_block();
+                        }
+                    }
+                    return true;
+                }
+
+            }; // class UringReader
+
+            /**
+             * Writes a file sequentially with several writes in flight at
+             * the same time. The writes start at the current file position.
+             * Call flush() to wait for all outstanding writes. It also sets
+             * the file position to the end of the data written.
+             */
+            class UringWriter {
+
+                struct pending_write {
+                    std::string data;
+                    std::size_t done = 0;
+                    uint64_t offset = 0;
+                    bool in_use = false;
+                };
+
+                std::vector<pending_write> m_writes;
+                IoUring m_ring;
+                int m_fd;
+                uint64_t m_offset;
+                unsigned m_in_flight = 0;
+
+                void submit_write(std::size_t index) {
+                    pending_write& w = m_writes[index];
+                    io_uring_sqe* sqe = m_ring.get_sqe();
+                    assert(sqe);
+
+                    sqe->opcode = IORING_OP_WRITE;
+                    sqe->fd = m_fd;
+                    sqe->off = w.offset + w.done;
+                    sqe->addr = reinterpret_cast<uint64_t>(w.data.data() + w.done);
+                    sqe->len = static_cast<uint32_t>(w.data.size() - w.done);
+                    sqe->user_data = index;
+
+                    ++m_in_flight;
+                }
+
+                void handle_completions() {
+                    uint64_t index = 0;
+                    int32_t result = 0;
+                    while (m_ring.get_completion(&index, &result)) {
+                        pending_write& w = m_writes[index];
+                        --m_in_flight;
+
+                        if (result == -EINTR || result == -EAGAIN) {
+                            submit_write(index);
+                        } else if (result <= 0) {
+                            throw std::system_error{result < 0 ? -result : EIO, std::system_category(), "Write failed"};
+                        } else {
+                            w.done += static_cast<std::size_t>(result);
+                            if (w.done < w.data.size()) {
+                                // short write, try again for the rest
+                                submit_write(index);
+                            } else {
+                                w.data = std::string{};
+                                w.in_use = false;
+                            }
+                        }
+                    }
+                }
+
+                void wait_for_completion() {
+                    m_ring.submit(1);
+                    handle_completions();
+                    m_ring.submit();
+                }
+
+            public:
+
+                /**
+                 * @param fd File descriptor of a regular file.
+                 * @param max_in_flight Maximum number of writes in flight.
+                 * @throws std::system_error If io_uring can not be set up.
+                 */
+                explicit UringWriter(int fd, unsigned max_in_flight = 8) :
+                    m_writes(max_in_flight),
+                    m_ring(max_in_flight),
+                    m_fd(fd),
+                    m_offset(static_cast<uint64_t>(::lseek(fd, 0, SEEK_CUR))) {
+                }
+
+                UringWriter(const UringWriter&) = delete;
+                UringWriter& operator=(const UringWriter&) = delete;
+
+                UringWriter(UringWriter&&) = delete;
+                UringWriter& operator=(UringWriter&&) = delete;
+
+                ~UringWriter() noexcept {
+                    // The kernel might still read from our strings, so we
+                    // have to wait for all outstanding writes.
+                    try {
+                        m_ring.submit();
+                        uint64_t index = 0;
+                        int32_t result = 0;
+                        while (m_in_flight > 0) {
+                            m_ring.submit(1);
+                            while (m_ring.get_completion(&index, &result)) {
+                                --m_in_flight;
+                            }
+                        }
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                /**
+                 * Queue data for writing. Blocks if the maximum number of
+                 * writes is in flight until one of them is done.
+                 *
+                 * @throws std::system_error On error (possibly from an
+                 *         earlier write).
+                 */
+                void write(std::string&& data) {
+                    if (data.empty()) {
+                        return;
+                    }
+
+                    while (true) {
+                        for (std::size_t i = 0; i < m_writes.size(); ++i) {
+                            pending_write& w = m_writes[i];
+                            if (!w.in_use) {
+                                w.data = std::move(data);
+                                w.done = 0;
+                                w.offset = m_offset;
+                                w.in_use = true;
+                                m_offset += w.data.size();
+                                submit_write(i);
+                                m_ring.submit();
+                                return;
+                            }
+                        }
+                        wait_for_completion();
+                    }
+                }
+
+                /**
+                 * Wait for all outstanding writes.
+                 *
+                 * @throws std::system_error On error.
+                 */
+                void flush() {
+                    while (m_in_flight > 0) {
+                        wait_for_completion();
+                    }
+                    if (::lseek(m_fd, static_cast<off_t>(m_offset), SEEK_SET) < 0) {
+                        throw std::system_error{errno, std::system_category(), "Seek failed"};
+                    }
+                }
+
+            }; // class UringWriter
+
+            /**
+             * Create an io_uring reader or writer (T is UringReader or
+             * UringWriter) for the file descriptor if possible.
+             *
+             * @returns nullptr if io_uring can not be used. The caller
+             *          should then use the usual blocking calls.
+             */
+            template <typename T>
+            std::unique_ptr<T> make_uring_io(int fd) {
+                if (!io_uring_usable(fd, std::is_same<T, UringWriter>::value)) {
+                    return nullptr;
+                }
+                try {
+                    return std::unique_ptr<T>{new T{fd}};
+                } catch (const std::system_error&) {
+                    return nullptr;
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_WITH_IO_URING
+
+#endif // OSMIUM_IO_DETAIL_IO_URING_HPP
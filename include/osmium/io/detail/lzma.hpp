@@ -0,0 +1,106 @@
+#ifndef OSMIUM_IO_DETAIL_LZMA_HPP
+#define OSMIUM_IO_DETAIL_LZMA_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifdef OSMIUM_WITH_LZMA
+
+#include <cstdint>
+#include <string>
+
+#include <osmium/io/error.hpp>
+
+#include <protozero/version.hpp>
+
+#if PROTOZERO_VERSION_CODE >= 10600
+# include <protozero/data_view.hpp>
+#else
+# include <protozero/types.hpp>
+#endif
+
+#include <lzma.h>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Uncompress data using lzma. Both the xz and the legacy lzma
+             * container formats are understood.
+             *
+             * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view lzma_uncompress_string(const char* input, std::size_t input_size, std::size_t raw_size, std::string& output) {
+                output.resize(raw_size);
+
+                lzma_stream stream = LZMA_STREAM_INIT;
+                lzma_ret result = ::lzma_auto_decoder(&stream, UINT64_MAX, 0);
+                if (result != LZMA_OK) {
+                    throw io_error{"lzma decompression failed: can not initialize decoder"};
+                }
+
+                stream.next_in = reinterpret_cast<const uint8_t*>(input);
+                stream.avail_in = input_size;
+                stream.next_out = reinterpret_cast<uint8_t*>(&*output.begin());
+                stream.avail_out = raw_size;
+
+                result = ::lzma_code(&stream, LZMA_FINISH);
+                const std::size_t size = raw_size - stream.avail_out;
+                ::lzma_end(&stream);
+
+                if (result != LZMA_STREAM_END) {
+                    throw io_error{"lzma decompression failed: invalid data"};
+                }
+
+                if (size != raw_size) {
+                    throw io_error{"lzma decompression failed: data size does not match"};
+                }
+
+                return protozero::data_view{output.data(), output.size()};
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif
+
+#endif // OSMIUM_IO_DETAIL_LZMA_HPP
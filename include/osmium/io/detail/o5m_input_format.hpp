@@ -62,11 +62,13 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <future>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -151,90 +153,17 @@ namespace osmium {
 
             }; // class ReferenceTable
 
-            class O5mParser final : public ParserWithBuffer {
-
-                osmium::io::Header m_header;
-
-                std::string m_input;
-
-                const char* m_data;
-                const char* m_end;
+            /**
+             * Decodes o5m node, way, and relation datasets. It keeps the
+             * state needed for that (the string reference table and the
+             * delta-encoded values) which is cleared at every reset
+             * dataset. So the data between two reset datasets can be
+             * decoded independently from the rest of the file.
+             */
+            class O5mObjectDecoder {
 
                 ReferenceTable m_reference_table;
 
-                static int64_t zvarint(const char** data, const char* end) {
-                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
-                }
-
-                bool ensure_bytes_available(std::size_t need_bytes) {
-                    if (static_cast<std::size_t>(m_end - m_data) >= need_bytes) {
-                        return true;
-                    }
-
-                    if (input_done() && (m_input.size() < need_bytes)) {
-                        return false;
-                    }
-
-                    m_input.erase(0, m_data - m_input.data());
-
-                    while (m_input.size() < need_bytes) {
-                        const std::string data{get_input()};
-                        if (input_done()) {
-                            return false;
-                        }
-                        m_input.append(data);
-                    }
-
-                    m_data = m_input.data();
-                    m_end = m_input.data() + m_input.size();
-
-                    return true;
-                }
-
-                void check_header_magic() {
-                    static const unsigned char header_magic[] = {0xff, 0xe0, 0x04, 'o', '5'};
-
-                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data += sizeof(header_magic);
-                }
-
-                void check_file_type() {
-                    if (*m_data == 'm') {         // o5m data file
-                        m_header.set_has_multiple_object_versions(false);
-                    } else if (*m_data == 'c') {  // o5c change file
-                        m_header.set_has_multiple_object_versions(true);
-                    } else {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
-
-                void check_file_format_version() {
-                    if (*m_data != '2') {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
-
-                void decode_header() {
-                    if (!ensure_bytes_available(7)) { // overall length of header
-                        throw o5m_error{"file too short (incomplete header info)"};
-                    }
-
-                    check_header_magic();
-                    check_file_type();
-                    check_file_format_version();
-                }
-
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
-
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_id;
 
                 osmium::DeltaDecode<int64_t> m_delta_timestamp;
@@ -245,6 +174,12 @@ namespace osmium {
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_way_node_id;
                 std::array<osmium::DeltaDecode<osmium::object_id_type>, 3> m_delta_member_ids;
 
+            public:
+
+                static int64_t zvarint(const char** data, const char* end) {
+                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
+                }
+
                 void reset() {
                     m_reference_table.clear();
 
@@ -260,6 +195,8 @@ namespace osmium {
                     m_delta_member_ids[2].clear();
                 }
 
+            private:
+
                 const char* decode_string(const char** dataptr, const char* const end) {
                     assert(*dataptr != end);
 
@@ -380,8 +317,10 @@ namespace osmium {
                     return user;
                 }
 
-                void decode_node(const char* data, const char* const end) {
-                    osmium::builder::NodeBuilder builder{buffer()};
+            public:
+
+                void decode_node(osmium::memory::Buffer& buffer, const char* data, const char* const end) {
+                    osmium::builder::NodeBuilder builder{buffer};
 
                     builder.set_id(m_delta_id.update(zvarint(&data, end)));
 
@@ -402,8 +341,8 @@ namespace osmium {
                     }
                 }
 
-                void decode_way(const char* data, const char* const end) {
-                    osmium::builder::WayBuilder builder{buffer()};
+                void decode_way(osmium::memory::Buffer& buffer, const char* data, const char* const end) {
+                    osmium::builder::WayBuilder builder{buffer};
 
                     builder.set_id(m_delta_id.update(zvarint(&data, end)));
 
@@ -433,6 +372,8 @@ namespace osmium {
                     }
                 }
 
+            private:
+
                 static osmium::item_type decode_member_type(char c) {
                     if (c < '0' || c > '2') {
                         throw o5m_error{"unknown member type"};
@@ -467,8 +408,10 @@ namespace osmium {
                     return {member_type, role};
                 }
 
-                void decode_relation(const char* data, const char* const end) {
-                    osmium::builder::RelationBuilder builder{buffer()};
+            public:
+
+                void decode_relation(osmium::memory::Buffer& buffer, const char* data, const char* const end) {
+                    osmium::builder::RelationBuilder builder{buffer};
 
                     builder.set_id(m_delta_id.update(zvarint(&data, end)));
 
@@ -505,18 +448,128 @@ namespace osmium {
                     }
                 }
 
+            }; // class O5mObjectDecoder
+
+            class O5mParser final : public ParserWithBuffer {
+
+                enum {
+                    parallel_chunk_size = 1024UL * 1024UL
+                };
+
+                // Chunks can only be cut at resets. If there hasn't been
+                // one for this many bytes, the data up to the next reset
+                // is decoded in the parser thread instead, so that memory
+                // use stays bounded for files that only have resets
+                // between the node, way, and relation sections.
+                enum {
+                    max_parallel_chunk_size = 8UL * 1024UL * 1024UL
+                };
+
+                using chunk_result_type = std::vector<osmium::memory::Buffer>;
+
+                osmium::io::Header m_header;
+
+                std::string m_input;
+
+                const char* m_data;
+                const char* m_end;
+
+                O5mObjectDecoder m_decoder;
+
+                // Object datasets collected for decoding on the thread pool
+                // in parallel mode. Chunks always start after a reset.
+                std::string m_chunk;
+
+                std::deque<std::future<chunk_result_type>> m_pending;
+                std::size_t m_max_pending = 0;
+
+                bool m_parallel_parsing;
+
+                // Set in parallel mode while the data up to the next reset
+                // is decoded in the parser thread.
+                bool m_decode_here = false;
+
+                bool ensure_bytes_available(std::size_t need_bytes) {
+                    if (static_cast<std::size_t>(m_end - m_data) >= need_bytes) {
+                        return true;
+                    }
+
+                    if (input_done() && (m_input.size() < need_bytes)) {
+                        return false;
+                    }
+
+                    m_input.erase(0, m_data - m_input.data());
+
+                    while (m_input.size() < need_bytes) {
+                        const std::string data{get_input()};
+                        if (input_done()) {
+                            return false;
+                        }
+                        m_input.append(data);
+                    }
+
+                    m_data = m_input.data();
+                    m_end = m_input.data() + m_input.size();
+
+                    return true;
+                }
+
+                void check_header_magic() {
+                    static const unsigned char header_magic[] = {0xff, 0xe0, 0x04, 'o', '5'};
+
+                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data += sizeof(header_magic);
+                }
+
+                void check_file_type() {
+                    if (*m_data == 'm') {         // o5m data file
+                        m_header.set_has_multiple_object_versions(false);
+                    } else if (*m_data == 'c') {  // o5c change file
+                        m_header.set_has_multiple_object_versions(true);
+                    } else {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void check_file_format_version() {
+                    if (*m_data != '2') {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void decode_header() {
+                    if (!ensure_bytes_available(7)) { // overall length of header
+                        throw o5m_error{"file too short (incomplete header info)"};
+                    }
+
+                    check_header_magic();
+                    check_file_type();
+                    check_file_format_version();
+                }
+
+                void mark_header_as_done() {
+                    set_header_value(m_header);
+                }
+
                 void decode_bbox(const char* data, const char* const end) {
-                    const auto sw_lon = zvarint(&data, end);
-                    const auto sw_lat = zvarint(&data, end);
-                    const auto ne_lon = zvarint(&data, end);
-                    const auto ne_lat = zvarint(&data, end);
+                    const auto sw_lon = O5mObjectDecoder::zvarint(&data, end);
+                    const auto sw_lat = O5mObjectDecoder::zvarint(&data, end);
+                    const auto ne_lon = O5mObjectDecoder::zvarint(&data, end);
+                    const auto ne_lat = O5mObjectDecoder::zvarint(&data, end);
 
                     m_header.add_box(osmium::Box{osmium::Location{sw_lon, sw_lat},
                                                  osmium::Location{ne_lon, ne_lat}});
                 }
 
                 void decode_timestamp(const char* data, const char* const end) {
-                    const auto timestamp = osmium::Timestamp{zvarint(&data, end)}.to_iso();
+                    const auto timestamp = osmium::Timestamp{O5mObjectDecoder::zvarint(&data, end)}.to_iso();
                     m_header.set("o5m_timestamp", timestamp);
                     m_header.set("timestamp", timestamp);
                 }
@@ -533,6 +586,163 @@ namespace osmium {
                     reset        = 0xff
                 };
 
+                static bool is_object(dataset_type ds_type) noexcept {
+                    return ds_type == dataset_type::node ||
+                           ds_type == dataset_type::way ||
+                           ds_type == dataset_type::relation;
+                }
+
+                static osmium::item_type object_item_type(dataset_type ds_type) noexcept {
+                    switch (ds_type) {
+                        case dataset_type::node:
+                            return osmium::item_type::node;
+                        case dataset_type::way:
+                            return osmium::item_type::way;
+                        default:
+                            break;
+                    }
+                    return osmium::item_type::relation;
+                }
+
+                static void decode_object(O5mObjectDecoder& decoder, osmium::memory::Buffer& buffer, dataset_type ds_type, const char* data, const char* const end) {
+                    switch (ds_type) {
+                        case dataset_type::node:
+                            decoder.decode_node(buffer, data, end);
+                            break;
+                        case dataset_type::way:
+                            decoder.decode_way(buffer, data, end);
+                            break;
+                        default:
+                            decoder.decode_relation(buffer, data, end);
+                            break;
+                    }
+                    buffer.commit();
+                }
+
+                // Decode the object and reset datasets in a chunk. The
+                // datasets have already been filtered by type.
+                template <typename TBuffers>
+                static void decode_datasets(TBuffers& buffers, O5mObjectDecoder& decoder, const std::string& chunk) {
+                    const char* data = chunk.data();
+                    const char* const end = data + chunk.size();
+                    while (data != end) {
+                        const auto ds_type = static_cast<dataset_type>(*data++);
+                        if (ds_type == dataset_type::reset) {
+                            decoder.reset();
+                            continue;
+                        }
+                        const auto length = protozero::decode_varint(&data, end);
+                        buffers.maybe_new_buffer(object_item_type(ds_type));
+                        decode_object(decoder, buffers.buffer(), ds_type, data, data + length);
+                        data += length;
+                        buffers.flush_nested_buffer();
+                    }
+                }
+
+                // Decode a chunk on the thread pool.
+                static chunk_result_type decode_chunk(const std::string& chunk, osmium::io::buffers_type kind) {
+                    ChunkBuffers buffers{kind};
+                    O5mObjectDecoder decoder;
+                    decode_datasets(buffers, decoder, chunk);
+                    return buffers.get_buffers();
+                }
+
+                // Wait for the oldest chunk to be decoded and send its
+                // buffers on in input order.
+                void send_oldest_chunk() {
+                    auto buffers = m_pending.front().get();
+                    m_pending.pop_front();
+                    for (auto& buffer : buffers) {
+                        send_to_output_queue(std::move(buffer));
+                    }
+                }
+
+                void submit_chunk() {
+                    if (m_chunk.empty()) {
+                        return;
+                    }
+
+                    const auto kind = buffers_kind();
+                    const auto chunk = std::make_shared<std::string>(std::move(m_chunk));
+                    m_chunk.clear();
+                    m_pending.push_back(get_pool().submit([chunk, kind] {
+                        return decode_chunk(*chunk, kind);
+                    }));
+
+                    while (m_pending.size() > m_max_pending) {
+                        send_oldest_chunk();
+                    }
+                }
+
+                // Copy an object dataset into the current chunk. The length
+                // is written again as varint, because the input it was read
+                // from might be gone when the chunk is decoded.
+                void add_to_chunk(dataset_type ds_type, const char* data, uint64_t length) {
+                    m_chunk += static_cast<char>(ds_type);
+                    uint64_t value = length;
+                    while (value >= 0x80U) {
+                        m_chunk += static_cast<char>((value & 0x7fU) | 0x80U);
+                        value >>= 7U;
+                    }
+                    m_chunk += static_cast<char>(value);
+                    m_chunk.append(data, length);
+                }
+
+                // The current chunk got too large without a reset. Decode
+                // it and everything up to the next reset in this thread.
+                void start_decoding_here() {
+                    while (!m_pending.empty()) {
+                        send_oldest_chunk();
+                    }
+                    m_decoder.reset();
+                    decode_datasets(*this, m_decoder, m_chunk);
+                    m_chunk.clear();
+                    m_decode_here = true;
+                }
+
+                void reset() {
+                    if (!m_parallel_parsing) {
+                        m_decoder.reset();
+                        return;
+                    }
+
+                    if (m_decode_here) {
+                        // Everything decoded here has to be sent on before
+                        // the results of the next chunk.
+                        flush_buffer();
+                        m_decode_here = false;
+                        return;
+                    }
+
+                    // Data after a reset can be decoded independently of
+                    // everything before it, so this is where chunks are cut.
+                    if (m_chunk.size() >= parallel_chunk_size) {
+                        submit_chunk();
+                    } else if (!m_chunk.empty()) {
+                        m_chunk += static_cast<char>(dataset_type::reset);
+                    }
+                }
+
+                void handle_object(dataset_type ds_type, uint64_t length) {
+                    mark_header_as_done();
+
+                    const auto type = object_item_type(ds_type);
+                    if (!(read_types() & osmium::osm_entity_bits::from_item_type(type))) {
+                        return;
+                    }
+
+                    if (m_parallel_parsing && !m_decode_here) {
+                        add_to_chunk(ds_type, m_data, length);
+                        if (m_chunk.size() >= max_parallel_chunk_size) {
+                            start_decoding_here();
+                        }
+                        return;
+                    }
+
+                    maybe_new_buffer(type);
+                    decode_object(m_decoder, buffer(), ds_type, m_data, m_data + length);
+                }
+
                 void decode_data() {
                     while (ensure_bytes_available(1)) {
                         const auto ds_type = static_cast<dataset_type>(*m_data++);
@@ -554,41 +764,13 @@ namespace osmium {
                                 throw o5m_error{"premature end of file"};
                             }
 
-                            switch (ds_type) {
-                                case dataset_type::node:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::node) {
-                                        maybe_new_buffer(osmium::item_type::node);
-                                        decode_node(m_data, m_data + length);
-                                        buffer().commit();
-                                    }
-                                    break;
-                                case dataset_type::way:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::way) {
-                                        maybe_new_buffer(osmium::item_type::way);
-                                        decode_way(m_data, m_data + length);
-                                        buffer().commit();
-                                    }
-                                    break;
-                                case dataset_type::relation:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::relation) {
-                                        maybe_new_buffer(osmium::item_type::relation);
-                                        decode_relation(m_data, m_data + length);
-                                        buffer().commit();
-                                    }
-                                    break;
-                                case dataset_type::bounding_box:
-                                    decode_bbox(m_data, m_data + length);
-                                    break;
-                                case dataset_type::timestamp:
-                                    decode_timestamp(m_data, m_data + length);
-                                    break;
-                                default:
-                                    // ignore unknown datasets
-                                    break;
-                            }
+                            if (is_object(ds_type)) {
+                                handle_object(ds_type, length);
+                            } else if (ds_type == dataset_type::bounding_box) {
+                                decode_bbox(m_data, m_data + length);
+                            } else if (ds_type == dataset_type::timestamp) {
+                                decode_timestamp(m_data, m_data + length);
+                            } // ignore unknown datasets
 
                             if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
                                 break;
@@ -600,6 +782,13 @@ namespace osmium {
                         }
                     }
 
+                    if (m_parallel_parsing) {
+                        submit_chunk();
+                        while (!m_pending.empty()) {
+                            send_oldest_chunk();
+                        }
+                    }
+
                     mark_header_as_done();
                     flush_final_buffer();
                 }
@@ -609,7 +798,8 @@ namespace osmium {
                 explicit O5mParser(parser_arguments& args) :
                     ParserWithBuffer(args),
                     m_data(m_input.data()),
-                    m_end(m_data) {
+                    m_end(m_data),
+                    m_parallel_parsing(args.parallel_parsing) {
                 }
 
                 O5mParser(const O5mParser&) = delete;
@@ -623,6 +813,10 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_o5m_in");
 
+                    if (m_parallel_parsing) {
+                        m_max_pending = 2 * static_cast<std::size_t>(get_pool().num_threads()) + 1;
+                    }
+
                     decode_header();
                     decode_data();
                 }
@@ -35,15 +35,25 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/opl_parser_functions.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -98,14 +108,267 @@ namespace osmium {
                 }
             }
 
+            // Feed data from a contiguous block of memory line by line to
+            // the OPL parser function. The data is not changed, each line
+            // is copied into a reused string to get the null termination
+            // the parser needs.
+            template <typename T>
+            void line_by_line(const char* data, std::size_t size, T& worker) {
+                const char* const end = data + size;
+                std::string line;
+
+                while (data != end) {
+                    const char* eol = data;
+                    while (eol != end && *eol != '\n' && *eol != '\r') {
+                        ++eol;
+                    }
+                    if (eol != data) {
+                        line.assign(data, eol);
+                        worker.parse_line(line.c_str());
+                    }
+                    data = eol == end ? end : eol + 1;
+                }
+            }
+
+            // Find the first end of line character ('\n' or '\r') in the
+            // range [data, data + size). Returns nullptr if there is none.
+            inline const char* find_end_of_line(const char* data, std::size_t size) noexcept {
+                const char* const end = data + size;
+                const auto it = std::find_if(data, end, [](const char c) {
+                    return c == '\n' || c == '\r';
+                });
+                return it == end ? nullptr : it;
+            }
+
+            // Count the lines in a block of data the same way line_by_line()
+            // does, ie. empty lines are not counted. Used to keep the line
+            // numbers in error messages correct when parsing in parallel.
+            inline uint64_t count_opl_lines(const char* data, std::size_t size) noexcept {
+                uint64_t count = 0;
+                bool in_line = false;
+                for (const char* const end = data + size; data != end; ++data) {
+                    if (*data == '\n' || *data == '\r') {
+                        in_line = false;
+                    } else if (!in_line) {
+                        in_line = true;
+                        ++count;
+                    }
+                }
+                return count;
+            }
+
+            // Parses a chunk of OPL data made up of complete lines into
+            // its own buffers. Used from the thread pool when parsing in
+            // parallel.
+            class OPLChunkParser {
+
+                ChunkBuffers m_buffers;
+                uint64_t m_line_count;
+                osmium::osm_entity_bits::type m_read_types;
+
+            public:
+
+                OPLChunkParser(uint64_t first_line, osmium::osm_entity_bits::type read_types, osmium::io::buffers_type buffers_kind) :
+                    m_buffers(buffers_kind),
+                    m_line_count(first_line),
+                    m_read_types(read_types) {
+                }
+
+                void parse_line(const char* data) {
+                    switch (*data) {
+                        case 'n':
+                            m_buffers.maybe_new_buffer(osmium::item_type::node);
+                            break;
+                        case 'w':
+                            m_buffers.maybe_new_buffer(osmium::item_type::way);
+                            break;
+                        case 'r':
+                            m_buffers.maybe_new_buffer(osmium::item_type::relation);
+                            break;
+                        case 'c':
+                            m_buffers.maybe_new_buffer(osmium::item_type::way);
+                            break;
+                    }
+
+                    if (opl_parse_line(m_line_count, data, m_buffers.buffer(), m_read_types)) {
+                        m_buffers.flush_nested_buffer();
+                    }
+                    ++m_line_count;
+                }
+
+                std::vector<osmium::memory::Buffer> get_buffers() {
+                    return m_buffers.get_buffers();
+                }
+
+            }; // class OPLChunkParser
+
             class OPLParser final : public ParserWithBuffer {
 
+                enum {
+                    parallel_chunk_size = 1024UL * 1024UL
+                };
+
+                using chunk_result_type = std::vector<osmium::memory::Buffer>;
+
+                struct pending_chunk {
+                    std::future<chunk_result_type> result;
+                    std::size_t end_offset;
+                };
+
                 uint64_t m_line_count = 0;
+                std::atomic<std::size_t>* m_offset_ptr;
+                int m_fd;
+                bool m_use_mmap;
+                bool m_parallel_parsing;
+
+                std::deque<pending_chunk> m_pending;
+                std::size_t m_max_pending = 0;
+
+                // Wait for the oldest chunk to be parsed and send its
+                // buffers on in input order.
+                void send_oldest_chunk() {
+                    auto buffers = m_pending.front().result.get();
+                    if (m_offset_ptr && m_pending.front().end_offset > 0) {
+                        *m_offset_ptr = m_pending.front().end_offset;
+                    }
+                    m_pending.pop_front();
+                    for (auto& buffer : buffers) {
+                        send_to_output_queue(std::move(buffer));
+                    }
+                }
+
+                // Parse the data in the range [first, last), which must be
+                // made up of complete lines, on the thread pool. The owner
+                // keeps the data alive until the parsing is done.
+                template <typename TOwner>
+                void submit_chunk(TOwner owner, const char* first, const char* last, std::size_t end_offset = 0) {
+                    const uint64_t first_line = m_line_count;
+                    m_line_count += count_opl_lines(first, static_cast<std::size_t>(last - first));
+
+                    const auto types = read_types();
+                    const auto kind = buffers_kind();
+                    m_pending.push_back(pending_chunk{get_pool().submit([owner, first, last, first_line, types, kind] {
+                        OPLChunkParser parser{first_line, types, kind};
+                        line_by_line(first, static_cast<std::size_t>(last - first), parser);
+                        return parser.get_buffers();
+                    }), end_offset});
+
+                    while (m_pending.size() > m_max_pending) {
+                        send_oldest_chunk();
+                    }
+                }
+
+                void submit_string_chunk(std::string&& chunk) {
+                    const auto data = std::make_shared<const std::string>(std::move(chunk));
+                    submit_chunk(data, data->data(), data->data() + data->size());
+                }
+
+                // Parse the input coming from the input queue in chunks of
+                // complete lines on the thread pool.
+                void parse_input_in_parallel() {
+                    std::string chunk;
+
+                    while (!input_done()) {
+                        std::string input{get_input()};
+                        if (chunk.empty()) {
+                            chunk = std::move(input);
+                        } else {
+                            chunk.append(input);
+                        }
+
+                        if (chunk.size() < parallel_chunk_size) {
+                            continue;
+                        }
+
+                        const auto pos = chunk.find_last_of("\n\r");
+                        if (pos == std::string::npos) {
+                            continue;
+                        }
+
+                        std::string rest{chunk, pos + 1};
+                        chunk.resize(pos + 1);
+                        submit_string_chunk(std::move(chunk));
+                        chunk = std::move(rest);
+                    }
+
+                    if (!chunk.empty()) {
+                        submit_string_chunk(std::move(chunk));
+                    }
+                }
+
+                // Parse the file from a memory mapping in chunks ending at
+                // line boundaries on the thread pool.
+                void parse_mapped_file_in_parallel() {
+                    const auto mapping = std::make_shared<const osmium::util::MemoryMapping>(osmium::file_size(m_fd), osmium::util::MemoryMapping::mapping_mode::readonly, m_fd);
+                    osmium::io::detail::reliable_close(m_fd);
+                    m_fd = -1;
+
+                    const char* const data = mapping->get_addr<const char>();
+                    const std::size_t size = mapping->size();
+                    std::size_t offset = 0;
+                    while (offset < size) {
+                        std::size_t chunk_end = size;
+                        if (size - offset > parallel_chunk_size) {
+                            const auto* eol = find_end_of_line(data + offset + parallel_chunk_size, size - offset - parallel_chunk_size);
+                            if (eol) {
+                                chunk_end = static_cast<std::size_t>(eol - data) + 1;
+                            }
+                        }
+                        submit_chunk(mapping, data + offset, data + chunk_end, chunk_end);
+                        offset = chunk_end;
+                    }
+                }
+
+                void run_in_parallel() {
+                    m_max_pending = 2 * static_cast<std::size_t>(get_pool().num_threads()) + 1;
+
+                    if (m_use_mmap && m_fd != -1) {
+                        parse_mapped_file_in_parallel();
+                    } else {
+                        parse_input_in_parallel();
+                    }
+
+                    while (!m_pending.empty()) {
+                        send_oldest_chunk();
+                    }
+                }
+
+                // Parse the file from a memory mapping in chunks ending at
+                // line boundaries. The offset is updated after each chunk.
+                void parse_mapped_file() {
+                    const osmium::util::MemoryMapping mapping{osmium::file_size(m_fd), osmium::util::MemoryMapping::mapping_mode::readonly, m_fd};
+                    osmium::io::detail::reliable_close(m_fd);
+                    m_fd = -1;
+
+                    constexpr const std::size_t chunk_size = 1024UL * 1024UL;
+
+                    const char* const data = mapping.get_addr<const char>();
+                    const std::size_t size = mapping.size();
+                    std::size_t offset = 0;
+                    while (offset < size) {
+                        std::size_t chunk_end = size;
+                        if (size - offset > chunk_size) {
+                            const auto* eol = find_end_of_line(data + offset + chunk_size, size - offset - chunk_size);
+                            if (eol) {
+                                chunk_end = static_cast<std::size_t>(eol - data) + 1;
+                            }
+                        }
+                        line_by_line(data + offset, chunk_end - offset, *this);
+                        offset = chunk_end;
+                        if (m_offset_ptr) {
+                            *m_offset_ptr = offset;
+                        }
+                    }
+                }
 
             public:
 
                 explicit OPLParser(parser_arguments& args) :
-                    ParserWithBuffer(args) {
+                    ParserWithBuffer(args),
+                    m_offset_ptr(args.offset_ptr),
+                    m_fd(args.fd),
+                    m_use_mmap(args.use_mmap),
+                    m_parallel_parsing(args.parallel_parsing) {
                     set_header_value(osmium::io::Header{});
                 }
 
@@ -142,7 +405,16 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_opl_in");
 
-                    line_by_line(*this);
+                    if (m_parallel_parsing) {
+                        run_in_parallel();
+                        return;
+                    }
+
+                    if (m_use_mmap && m_fd != -1) {
+                        parse_mapped_file();
+                    } else {
+                        line_by_line(*this);
+                    }
 
                     flush_final_buffer();
                 }
@@ -173,13 +173,14 @@ namespace osmium {
 
             public:
 
-                OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
                     m_options(options) {
                 }
 
                 std::string operator()() {
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
 
                     std::string out;
                     using std::swap;
@@ -295,7 +296,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options, buffer_pool()}));
                 }
 
             }; // class OPLOutputFormat
@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
@@ -58,16 +59,30 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Put the buffer into a shared_ptr. If a buffer pool is given,
+             * the buffer is handed back to it when it is not used any more.
+             */
+            inline std::shared_ptr<osmium::memory::Buffer> make_shared_buffer(osmium::memory::Buffer&& buffer, osmium::memory::BufferPool* buffer_pool) {
+                if (buffer_pool) {
+                    return buffer_pool->share(std::move(buffer));
+                }
+                return std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+            }
+
             class OutputBlock : public osmium::handler::Handler {
 
             protected:
 
+                // Reset this as soon as the data has been converted so
+                // that the buffer is returned to its pool (if any) before
+                // the result of the task becomes visible.
                 std::shared_ptr<osmium::memory::Buffer> m_input_buffer;
 
                 std::shared_ptr<std::string> m_out;
 
-                explicit OutputBlock(osmium::memory::Buffer&& buffer) :
-                    m_input_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))),
+                explicit OutputBlock(osmium::memory::Buffer&& buffer, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_input_buffer(make_shared_buffer(std::move(buffer), buffer_pool)),
                     m_out(std::make_shared<std::string>()) {
                 }
 
@@ -110,6 +125,21 @@ namespace osmium {
 
                 osmium::thread::Pool& m_pool;
                 future_string_queue_type& m_output_queue;
+                osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
+                osmium::memory::BufferPool* buffer_pool() const noexcept {
+                    return m_buffer_pool;
+                }
+
+                /**
+                 * Hand a buffer which has been written back to the buffer
+                 * pool (if there is one).
+                 */
+                void recycle_buffer(osmium::memory::Buffer&& buffer) {
+                    if (m_buffer_pool) {
+                        m_buffer_pool->put(std::move(buffer));
+                    }
+                }
 
                 /**
                  * Wrap the string into a future and add it to the output
@@ -134,6 +164,14 @@ namespace osmium {
 
                 virtual ~OutputFormat() noexcept = default;
 
+                /**
+                 * Set the pool the buffers are handed back to after they
+                 * have been written.
+                 */
+                void set_buffer_pool(osmium::memory::BufferPool* buffer_pool) noexcept {
+                    m_buffer_pool = buffer_pool;
+                }
+
                 virtual void write_header(const osmium::io::Header& /*header*/) {
                 }
 
@@ -215,7 +253,8 @@ namespace osmium {
 
                 ~BlackholeOutputFormat() noexcept override = default;
 
-                void write_buffer(osmium::memory::Buffer&& /*buffer*/) override {
+                void write_buffer(osmium::memory::Buffer&& buffer) override {
+                    recycle_buffer(std::move(buffer));
                 }
 
             }; // class BlackholeOutputFormat
@@ -73,10 +73,18 @@ namespace osmium {
 
             const int64_t resolution_convert = lonlat_resolution / osmium::detail::coordinate_precision;
 
+            // value of the format field in the BlobHeader indexdata written
+            // by libosmium
+            constexpr const char* osmium_indexdata_format() noexcept {
+                return "osmium";
+            }
+
             enum class pbf_compression : uint8_t {
                 none = 0,
                 zlib = 1,
-                lz4 = 2
+                lz4 = 2,
+                zstd = 3,
+                lzma = 4 // only for reading
             };
 
             inline pbf_compression get_compression_type(const std::string& val) {
@@ -89,6 +97,9 @@ namespace osmium {
                 if (val == "lz4") {
                     return pbf_compression::lz4;
                 }
+                if (val == "zstd") {
+                    return pbf_compression::zstd;
+                }
                 throw std::invalid_argument{"Unknown value for 'pbf_compression' option."};
             }
 
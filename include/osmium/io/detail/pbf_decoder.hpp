@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -49,6 +51,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
@@ -60,11 +63,20 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/util/delta.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #ifdef OSMIUM_WITH_LZ4
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_LZMA
+# include <osmium/io/detail/lzma.hpp>
+#endif
+
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
@@ -135,6 +147,41 @@ namespace osmium {
                     });
                 }
 
+                /**
+                 * Decode all remaining values into the column in one go,
+                 * converting each raw varint using the convert function.
+                 * Runs of single-byte varints, which make up most of the
+                 * delta-encoded data in DenseNodes, are detected eight
+                 * bytes at a time and decoded without going through the
+                 * generic varint decoder.
+                 */
+                template <typename TFunc>
+                void decode_column(std::vector<std::int64_t>& column, TFunc&& convert) {
+                    if (has_single_value()) {
+                        column.assign(1, get_and_clear_value());
+                        return;
+                    }
+
+                    column.resize(size());
+                    std::size_t n = 0;
+                    const char* data = m_data;
+                    while (data != m_end) {
+                        if (m_end - data >= 8) {
+                            std::uint64_t word = 0;
+                            std::memcpy(&word, data, sizeof(word));
+                            if ((word & 0x8080808080808080ULL) == 0) {
+                                for (int i = 0; i < 8; ++i) {
+                                    column[n++] = convert(static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])));
+                                }
+                                data += 8;
+                                continue;
+                            }
+                        }
+                        column[n++] = convert(protozero::decode_varint(&data, m_end));
+                    }
+                    m_data = m_end;
+                }
+
             }; // class values_access
 
             class values_access_int32 : public values_access<std::int32_t> {
@@ -150,6 +197,12 @@ namespace osmium {
                     return static_cast<int32_t>(next());
                 }
 
+                void decode_int32_column(std::vector<std::int64_t>& column) {
+                    decode_column(column, [](std::uint64_t value) noexcept {
+                        return static_cast<int32_t>(value);
+                    });
+                }
+
             }; // class values_access_int32
 
             class values_access_uint32 : public values_access<std::uint32_t> {
@@ -180,6 +233,12 @@ namespace osmium {
                     return protozero::decode_zigzag32(static_cast<uint32_t>(next()));
                 }
 
+                void decode_sint32_column(std::vector<std::int64_t>& column) {
+                    decode_column(column, [](std::uint64_t value) noexcept {
+                        return protozero::decode_zigzag32(static_cast<uint32_t>(value));
+                    });
+                }
+
             }; // class values_access_sint32
 
             class values_access_sint64 : public values_access<std::int64_t> {
@@ -195,8 +254,26 @@ namespace osmium {
                     return protozero::decode_zigzag64(next());
                 }
 
+                void decode_sint64_column(std::vector<std::int64_t>& column) {
+                    decode_column(column, [](std::uint64_t value) noexcept {
+                        return protozero::decode_zigzag64(value);
+                    });
+                }
+
             }; // class values_access_sint64
 
+            /**
+             * Undo delta encoding of a column of values in place by
+             * calculating its prefix sum.
+             */
+            inline void delta_decode_column(std::vector<std::int64_t>& column) noexcept {
+                std::uint64_t sum = 0;
+                for (auto& value : column) {
+                    sum += static_cast<std::uint64_t>(value);
+                    value = static_cast<std::int64_t>(sum);
+                }
+            }
+
             using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
 
             class PBFPrimitiveBlockDecoder {
@@ -215,10 +292,22 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::read_meta m_read_metadata;
 
+                // Columns for batch decoding of DenseNodes. They are kept
+                // here so the memory can be reused for all groups in a block.
+                std::vector<int64_t> m_dense_ids;
+                std::vector<int64_t> m_dense_lats;
+                std::vector<int64_t> m_dense_lons;
+                std::vector<int64_t> m_dense_versions;
+                std::vector<int64_t> m_dense_timestamps;
+                std::vector<int64_t> m_dense_changesets;
+                std::vector<int64_t> m_dense_uids;
+                std::vector<int64_t> m_dense_user_sids;
+                std::vector<int64_t> m_dense_visibles;
+
                 void decode_stringtable(const data_view& data) {
                     if (!m_stringtable.empty()) {
                         throw osmium::pbf_error{"more than one stringtable in pbf file"};
@@ -629,6 +718,25 @@ namespace osmium {
                     }
                 }
 
+                // Decode the id and location arrays of a DenseNodes group
+                // into columns and undo the delta encoding on them before
+                // any nodes are built.
+                void decode_dense_columns(values_access_sint64& ids, values_access_sint64& lats, values_access_sint64& lons) {
+                    ids.decode_sint64_column(m_dense_ids);
+                    lats.decode_sint64_column(m_dense_lats);
+                    lons.decode_sint64_column(m_dense_lons);
+
+                    if (m_dense_lats.size() < m_dense_ids.size() ||
+                        m_dense_lons.size() < m_dense_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    delta_decode_column(m_dense_ids);
+                    delta_decode_column(m_dense_lats);
+                    delta_decode_column(m_dense_lons);
+                }
+
                 void decode_dense_nodes_without_metadata(const data_view& data) {
                     values_access_sint64 ids;
                     values_access_sint64 lats;
@@ -667,28 +775,18 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
-
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
-                        }
+                    decode_dense_columns(ids, lats, lons);
 
+                    for (std::size_t i = 0; i < m_dense_ids.size(); ++i) {
                         {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.next_sint64()));
+                            node.set_id(m_dense_ids[i]);
 
-                            const auto lon = dense_longitude.update(lons.next_sint64());
-                            const auto lat = dense_latitude.update(lats.next_sint64());
                             builder.object().set_location(osmium::Location{
-                                    convert_pbf_lon(lon),
-                                    convert_pbf_lat(lat)
+                                    convert_pbf_lon(m_dense_lons[i]),
+                                    convert_pbf_lat(m_dense_lats[i])
                             });
 
                             if (!tags.empty()) {
@@ -794,32 +892,33 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
-                    osmium::DeltaDecode<int64_t> dense_uid;
-                    osmium::DeltaDecode<int64_t> dense_user_sid;
-                    osmium::DeltaDecode<int64_t> dense_changeset;
-                    osmium::DeltaDecode<int64_t> dense_timestamp;
-
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
-                        }
+                    decode_dense_columns(ids, lats, lons);
+
+                    if (has_info) {
+                        versions.decode_int32_column(m_dense_versions);
+                        timestamps.decode_sint64_column(m_dense_timestamps);
+                        delta_decode_column(m_dense_timestamps);
+                        changesets.decode_sint64_column(m_dense_changesets);
+                        delta_decode_column(m_dense_changesets);
+                        uids.decode_sint32_column(m_dense_uids);
+                        delta_decode_column(m_dense_uids);
+                        user_sids.decode_sint32_column(m_dense_user_sids);
+                        delta_decode_column(m_dense_user_sids);
+                        visibles.decode_int32_column(m_dense_visibles);
+                    }
 
+                    for (std::size_t i = 0; i < m_dense_ids.size(); ++i) {
                         {
                             bool visible = true;
 
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.next_sint64()));
+                            node.set_id(m_dense_ids[i]);
 
                             if (has_info) {
-                                if (!versions.empty()) {
-                                    const auto version = versions.next_int32();
+                                if (i < m_dense_versions.size()) {
+                                    const auto version = m_dense_versions[i];
                                     if (version < -1) {
                                         throw osmium::pbf_error{"object version must not be negative"};
                                     }
@@ -831,8 +930,8 @@ namespace osmium {
                                     }
                                 }
 
-                                if (!changesets.empty()) {
-                                    const auto changeset_id = dense_changeset.update(changesets.next_sint64());
+                                if (i < m_dense_changesets.size()) {
+                                    const auto changeset_id = m_dense_changesets[i];
                                     if (changeset_id < -1 || changeset_id >= std::numeric_limits<changeset_id_type>::max()) {
                                         throw osmium::pbf_error{"object changeset_id must be between 0 and 2^32-1"};
                                     }
@@ -844,33 +943,31 @@ namespace osmium {
                                     }
                                 }
 
-                                if (!timestamps.empty()) {
-                                    node.set_timestamp(dense_timestamp.update(timestamps.next_sint64()) * m_date_factor / 1000);
+                                if (i < m_dense_timestamps.size()) {
+                                    node.set_timestamp(m_dense_timestamps[i] * m_date_factor / 1000);
                                 }
 
-                                if (!uids.empty()) {
-                                    node.set_uid_from_signed(static_cast<osmium::signed_user_id_type>(dense_uid.update(uids.next_sint32())));
+                                if (i < m_dense_uids.size()) {
+                                    node.set_uid_from_signed(static_cast<osmium::signed_user_id_type>(m_dense_uids[i]));
                                 }
 
-                                if (!visibles.empty()) {
-                                    visible = (visibles.next_int32() != 0);
+                                if (i < m_dense_visibles.size()) {
+                                    visible = (m_dense_visibles[i] != 0);
                                 }
                                 node.set_visible(visible);
 
-                                if (!user_sids.empty()) {
-                                    const auto& u = m_stringtable.at(dense_user_sid.update(user_sids.next_sint32()));
+                                if (i < m_dense_user_sids.size()) {
+                                    const auto& u = m_stringtable.at(m_dense_user_sids[i]);
                                     builder.set_user(u.first, u.second);
                                 }
                             }
 
                             // even if the node isn't visible, there's still a record
                             // of its lat/lon in the dense arrays.
-                            const auto lon = dense_longitude.update(lons.next_sint64());
-                            const auto lat = dense_latitude.update(lats.next_sint64());
                             if (visible) {
                                 builder.object().set_location(osmium::Location{
-                                        convert_pbf_lon(lon),
-                                        convert_pbf_lat(lat)
+                                        convert_pbf_lon(m_dense_lons[i]),
+                                        convert_pbf_lat(m_dense_lats[i])
                                 });
                             }
 
@@ -882,11 +979,24 @@ namespace osmium {
                     }
                 }
 
+                // Decoded objects need several times the space of the
+                // uncompressed block. If the buffer comes from a pool, it
+                // is large enough for the whole block in most cases, so
+                // no further (not pooled) buffers have to be allocated.
+                static osmium::memory::Buffer create_buffer(const data_view& data, osmium::memory::BufferPool* buffer_pool) {
+                    if (!buffer_pool) {
+                        return osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                    }
+                    return buffer_pool->get(std::max(static_cast<std::size_t>(initial_buffer_size), data.size() * 8),
+                                            osmium::memory::Buffer::auto_grow::internal);
+                }
+
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
                     m_data(data),
                     m_read_types(read_types),
+                    m_buffer(create_buffer(data, buffer_pool)),
                     m_read_metadata(read_metadata) {
                 }
 
@@ -911,7 +1021,7 @@ namespace osmium {
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            inline data_view decode_blob(const data_view& blob_data, std::string& output) {
                 int32_t raw_size = 0;
                 protozero::data_view compressed_data;
                 pbf_compression use_compression = pbf_compression::none;
@@ -938,7 +1048,13 @@ namespace osmium {
                             compressed_data = pbf_blob.get_view();
                             break;
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_lzma_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_LZMA
+                            use_compression = pbf_compression::lzma;
+                            compressed_data = pbf_blob.get_view();
+                            break;
+#else
                             throw osmium::pbf_error{"lzma blobs not supported"};
+#endif
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_lz4_data, protozero::pbf_wire_type::length_delimited):
 #ifdef OSMIUM_WITH_LZ4
                             use_compression = pbf_compression::lz4;
@@ -948,7 +1064,13 @@ namespace osmium {
                             throw osmium::pbf_error{"lz4 blobs not supported"};
 #endif
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zstd_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_ZSTD
+                            use_compression = pbf_compression::zstd;
+                            compressed_data = pbf_blob.get_view();
+                            break;
+#else
                             throw osmium::pbf_error{"zstd blobs not supported"};
+#endif
                         default:
                             pbf_blob.skip();
                     }
@@ -982,6 +1104,28 @@ namespace osmium {
                         );
 #else
                         break;
+#endif
+                    case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                        return osmium::io::detail::zstd_uncompress_string(
+                            compressed_data.data(),
+                            compressed_data.size(),
+                            static_cast<std::size_t>(raw_size),
+                            output
+                        );
+#else
+                        break;
+#endif
+                    case pbf_compression::lzma:
+#ifdef OSMIUM_WITH_LZMA
+                        return osmium::io::detail::lzma_uncompress_string(
+                            compressed_data.data(),
+                            compressed_data.size(),
+                            static_cast<std::size_t>(raw_size),
+                            output
+                        );
+#else
+                        break;
 #endif
                 }
                 std::abort(); // should never be here
@@ -1085,6 +1229,213 @@ namespace osmium {
                 return header;
             }
 
+            inline uint32_t get_size_in_network_byte_order(const char* d) noexcept {
+                return (static_cast<uint32_t>(static_cast<unsigned char>(d[3]))) |
+                       (static_cast<uint32_t>(static_cast<unsigned char>(d[2])) <<  8U) |
+                       (static_cast<uint32_t>(static_cast<unsigned char>(d[1])) << 16U) |
+                       (static_cast<uint32_t>(static_cast<unsigned char>(d[0])) << 24U);
+            }
+
+            /**
+             * Information about a blob stored in the indexdata field of
+             * its BlobHeader. The defaults are used if there is no such
+             * information.
+             */
+            struct pbf_blob_indexdata {
+
+                /// Entity types in the blob.
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::all;
+
+                /// Bounding box of the nodes in the blob (if known).
+                osmium::Box bbox;
+
+            }; // struct pbf_blob_indexdata
+
+            /**
+             * Is a blob with the given entity types and bounding box
+             * needed when reading the entity types in read_types and
+             * (if it is valid) only the nodes in filter_box?
+             *
+             * Blobs with other entities than nodes and blobs without a
+             * valid bounding box are always needed if they contain any of
+             * the types in read_types.
+             */
+            inline bool pbf_blob_wanted(osmium::osm_entity_bits::type types,
+                                        const osmium::Box& bbox,
+                                        osmium::osm_entity_bits::type read_types,
+                                        const osmium::Box& filter_box) noexcept {
+                if ((types & read_types) == osmium::osm_entity_bits::nothing) {
+                    return false;
+                }
+
+                if (types != osmium::osm_entity_bits::node || !bbox.valid() || !filter_box.valid()) {
+                    return true;
+                }
+
+                return bbox.bottom_left().x() <= filter_box.top_right().x() &&
+                       bbox.top_right().x() >= filter_box.bottom_left().x() &&
+                       bbox.bottom_left().y() <= filter_box.top_right().y() &&
+                       bbox.top_right().y() >= filter_box.bottom_left().y();
+            }
+
+            /**
+             * Decode the indexdata field of a BlobHeader. If the data was
+             * not written by libosmium or can not be parsed, it is ignored
+             * and the defaults are returned.
+             */
+            inline pbf_blob_indexdata decode_blob_indexdata(const data_view& data) noexcept {
+                pbf_blob_indexdata result;
+                if (data.empty()) {
+                    return result;
+                }
+
+                pbf_blob_indexdata decoded;
+                bool has_format = false;
+                std::array<int32_t, 4> bbox{{0, 0, 0, 0}};
+                unsigned int bbox_fields = 0;
+                try {
+                    protozero::pbf_message<OsmiumIndexData::IndexData> pbf_indexdata{data};
+                    while (pbf_indexdata.next()) {
+                        switch (pbf_indexdata.tag_and_type()) {
+                            case protozero::tag_and_type(OsmiumIndexData::IndexData::required_string_format, protozero::pbf_wire_type::length_delimited): {
+                                    const auto format = pbf_indexdata.get_view();
+                                    has_format = format.size() == std::strlen(osmium_indexdata_format()) &&
+                                                 std::memcmp(format.data(), osmium_indexdata_format(), format.size()) == 0;
+                                }
+                                break;
+                            case protozero::tag_and_type(OsmiumIndexData::IndexData::optional_uint32_entity_bits, protozero::pbf_wire_type::varint): {
+                                    const auto bits = pbf_indexdata.get_uint32();
+                                    if (bits != 0 && (bits & ~static_cast<uint32_t>(osmium::osm_entity_bits::all)) == 0) {
+                                        decoded.types = static_cast<osmium::osm_entity_bits::type>(bits);
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OsmiumIndexData::IndexData::optional_sint32_min_x, protozero::pbf_wire_type::varint):
+                                bbox[0] = pbf_indexdata.get_sint32();
+                                bbox_fields |= 1U;
+                                break;
+                            case protozero::tag_and_type(OsmiumIndexData::IndexData::optional_sint32_min_y, protozero::pbf_wire_type::varint):
+                                bbox[1] = pbf_indexdata.get_sint32();
+                                bbox_fields |= 2U;
+                                break;
+                            case protozero::tag_and_type(OsmiumIndexData::IndexData::optional_sint32_max_x, protozero::pbf_wire_type::varint):
+                                bbox[2] = pbf_indexdata.get_sint32();
+                                bbox_fields |= 4U;
+                                break;
+                            case protozero::tag_and_type(OsmiumIndexData::IndexData::optional_sint32_max_y, protozero::pbf_wire_type::varint):
+                                bbox[3] = pbf_indexdata.get_sint32();
+                                bbox_fields |= 8U;
+                                break;
+                            default:
+                                pbf_indexdata.skip();
+                        }
+                    }
+                } catch (...) {
+                    return result;
+                }
+
+                if (!has_format) {
+                    return result;
+                }
+
+                // The bounding box is only used if it is complete. The
+                // extend() function ignores invalid locations.
+                if (bbox_fields == 0xfU) {
+                    decoded.bbox.extend(osmium::Location{bbox[0], bbox[1]});
+                    decoded.bbox.extend(osmium::Location{bbox[2], bbox[3]});
+                }
+
+                return decoded;
+            }
+
+            /**
+             * Decode the BlobHeader. Make sure it contains the expected
+             * type. Return the size of the following Blob.
+             *
+             * @param data Input data
+             * @param expected_type "OSMHeader" or "OSMData"
+             * @param indexdata If not nullptr, information from the
+             *                  indexdata field is stored here.
+             * @returns Size of the Blob following this BlobHeader
+             * @throws osmium::pbf_error If there was a parsing error
+             */
+            inline std::size_t decode_blob_header(const data_view& data, const char* expected_type, pbf_blob_indexdata* indexdata = nullptr) {
+                protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
+                data_view blob_header_type;
+                data_view blob_header_indexdata;
+                std::size_t blob_header_datasize = 0;
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                            blob_header_type = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::optional_bytes_indexdata, protozero::pbf_wire_type::length_delimited):
+                            blob_header_indexdata = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                            blob_header_datasize = pbf_blob_header.get_int32();
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (blob_header_datasize == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+
+                if (indexdata) {
+                    *indexdata = decode_blob_indexdata(blob_header_indexdata);
+                }
+
+                return blob_header_datasize;
+            }
+
+            /**
+             * Find out which types of OSM entities are in a PrimitiveBlock.
+             * This only looks at the PrimitiveGroups and doesn't decode
+             * any objects, so it is much cheaper than a full decode.
+             *
+             * @param data Uncompressed PrimitiveBlock
+             * @returns Bitset of entity types found
+             * @throws osmium::pbf_error If there was a parsing error
+             */
+            inline osmium::osm_entity_bits::type decode_primitive_block_types(const data_view& data) {
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                types |= osmium::osm_entity_bits::node;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                types |= osmium::osm_entity_bits::way;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
+                                types |= osmium::osm_entity_bits::relation;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets, protozero::pbf_wire_type::length_delimited):
+                                types |= osmium::osm_entity_bits::changeset;
+                                break;
+                            default:
+                                break;
+                        }
+                        pbf_primitive_group.skip();
+                    }
+                }
+
+                return types;
+            }
+
             /**
              * Decode HeaderBlock.
              *
@@ -1092,7 +1443,7 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
@@ -1101,20 +1452,38 @@ namespace osmium {
             class PBFDataBlobDecoder {
 
                 std::shared_ptr<std::string> m_input_buffer;
+                std::shared_ptr<const osmium::util::MemoryMapping> m_mapping;
+                data_view m_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                osmium::memory::BufferPool* m_buffer_pool;
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
                     m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                    m_data(*m_input_buffer),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool) {
+                }
+
+                /**
+                 * Decode a blob inside a memory mapped file. The data is not
+                 * copied, the mapping is kept alive until the blob is
+                 * decoded.
+                 */
+                PBFDataBlobDecoder(std::shared_ptr<const osmium::util::MemoryMapping> mapping, const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_mapping(std::move(mapping)),
+                    m_data(data),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool) {
                 }
 
                 osmium::memory::Buffer operator()() {
                     std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
+                    PBFPrimitiveBlockDecoder decoder{decode_blob(m_data, output), m_read_types, m_read_metadata, m_buffer_pool};
                     return decoder();
                 }
 
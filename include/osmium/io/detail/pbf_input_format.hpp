@@ -34,16 +34,23 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/io_uring.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/pbf_decoder.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
@@ -63,12 +70,118 @@ namespace osmium {
 
         namespace detail {
 
+#ifndef _WIN32
+            /**
+             * A file descriptor shared between the PBF parser and the tasks
+             * reading blobs from it. The file is closed when the last user
+             * is done with it.
+             */
+            class shared_file_descriptor {
+
+                int m_fd;
+
+            public:
+
+                explicit shared_file_descriptor(int fd) noexcept :
+                    m_fd(fd) {
+                }
+
+                shared_file_descriptor(const shared_file_descriptor&) = delete;
+                shared_file_descriptor& operator=(const shared_file_descriptor&) = delete;
+
+                shared_file_descriptor(shared_file_descriptor&&) = delete;
+                shared_file_descriptor& operator=(shared_file_descriptor&&) = delete;
+
+                ~shared_file_descriptor() noexcept {
+                    try {
+                        osmium::io::detail::reliable_close(m_fd);
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                int get() const noexcept {
+                    return m_fd;
+                }
+
+            }; // class shared_file_descriptor
+
+            /**
+             * Reads the blob at the position given in a pbf_blob_info from
+             * the file and decodes it. This runs in the pool threads, so
+             * several blobs can be read at the same time.
+             */
+            class PBFDataBlobReader {
+
+                std::shared_ptr<shared_file_descriptor> m_file;
+                osmium::io::pbf_blob_info m_blob;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::io::read_meta m_read_metadata;
+                bool m_want_buffered_pages_removed;
+                osmium::memory::BufferPool* m_buffer_pool;
+
+            public:
+
+                PBFDataBlobReader(std::shared_ptr<shared_file_descriptor> file,
+                                  const osmium::io::pbf_blob_info& blob,
+                                  const osmium::osm_entity_bits::type read_types,
+                                  const osmium::io::read_meta read_metadata,
+                                  const bool want_buffered_pages_removed,
+                                  osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_file(std::move(file)),
+                    m_blob(blob),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_want_buffered_pages_removed(want_buffered_pages_removed),
+                    m_buffer_pool(buffer_pool) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    // Take the file out of this object, so that it is closed
+                    // (if this is the last user) before the result becomes
+                    // visible to the reader.
+                    const auto file = std::move(m_file);
+
+                    std::string input_buffer(m_blob.size, '\0');
+
+                    if (!osmium::io::detail::read_exactly_at(file->get(), &*input_buffer.begin(), input_buffer.size(), m_blob.offset)) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+
+                    if (m_want_buffered_pages_removed) {
+                        osmium::io::detail::remove_buffered_pages(file->get(), m_blob.offset, m_blob.size);
+                    }
+
+                    PBFDataBlobDecoder decoder{std::move(input_buffer), m_read_types, m_read_metadata, m_buffer_pool};
+                    return decoder();
+                }
+
+            }; // class PBFDataBlobReader
+#endif
+
             class PBFParser final : public Parser {
 
                 std::string m_input_buffer;
                 std::atomic<std::size_t>* m_offset_ptr;
+                const osmium::io::PBFBlobIndex* m_blob_index;
                 int m_fd;
                 bool m_want_buffered_pages_removed;
+                bool m_use_mmap;
+                osmium::Box m_filter_box;
+                osmium::memory::BufferPool* m_buffer_pool;
+
+#ifdef OSMIUM_WITH_IO_URING
+                std::unique_ptr<osmium::io::detail::UringReader> m_uring;
+#endif
+
+                bool read_exactly_from_file(char* buffer, std::size_t size) {
+#ifdef OSMIUM_WITH_IO_URING
+                    if (m_uring) {
+                        return m_uring->read_exactly(buffer, size);
+                    }
+#endif
+                    return osmium::io::detail::read_exactly(m_fd, buffer, static_cast<unsigned int>(size));
+                }
 
                 /**
                  * Make sure the input data contains at least the specified
@@ -100,13 +213,6 @@ namespace osmium {
                     m_input_buffer.erase(0, size);
                 }
 
-                static uint32_t get_size_in_network_byte_order(const char* d) noexcept {
-                    return (static_cast<uint32_t>(d[3])) |
-                           (static_cast<uint32_t>(d[2]) <<  8U) |
-                           (static_cast<uint32_t>(d[1]) << 16U) |
-                           (static_cast<uint32_t>(d[0]) << 24U);
-                }
-
                 static uint32_t check_size(uint32_t size) {
                     if (size > static_cast<uint32_t>(max_blob_header_size)) {
                         throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
@@ -121,7 +227,7 @@ namespace osmium {
                 uint32_t read_blob_header_size_from_file() {
                     if (m_fd != -1) {
                         std::array<char, sizeof(uint32_t)> buffer{};
-                        if (!osmium::io::detail::read_exactly(m_fd, buffer.data(), static_cast<unsigned int>(buffer.size()))) {
+                        if (!read_exactly_from_file(buffer.data(), buffer.size())) {
                             return 0; // EOF
                         }
 
@@ -149,40 +255,7 @@ namespace osmium {
                     return size;
                 }
 
-                /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
-                 */
-                static size_t decode_blob_header(const protozero::data_view& data, const char* expected_type) {
-                    protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
-                    protozero::data_view blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag_and_type()) {
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
-                                blob_header_type = pbf_blob_header.get_view();
-                                break;
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
-                        }
-                    }
-
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
-                    }
-
-                    if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
-                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
-                    }
-
-                    return blob_header_datasize;
-                }
-
-                size_t check_type_and_get_blob_size(const char* expected_type) {
+                size_t check_type_and_get_blob_size(const char* expected_type, pbf_blob_indexdata* indexdata = nullptr) {
                     assert(expected_type);
 
                     const auto size = read_blob_header_size_from_file();
@@ -192,16 +265,50 @@ namespace osmium {
 
                     if (m_fd != -1) {
                         auto const buffer = read_from_input_queue_with_check(size);
-                        const auto blob_size = decode_blob_header(protozero::data_view{buffer.data(), size}, expected_type);
+                        const auto blob_size = decode_blob_header(protozero::data_view{buffer.data(), size}, expected_type, indexdata);
                         return blob_size;
                     }
 
                     ensure_available_in_input_queue(size);
-                    const auto blob_size = decode_blob_header(protozero::data_view{m_input_buffer.data(), size}, expected_type);
+                    const auto blob_size = decode_blob_header(protozero::data_view{m_input_buffer.data(), size}, expected_type, indexdata);
                     pop_from_input_queue(size);
                     return blob_size;
                 }
 
+                // Skip over a blob without decoding it. If the file is
+                // seekable, the blob is not even read.
+                void skip_blob(size_t size) {
+                    if (m_fd == -1) {
+                        ensure_available_in_input_queue(size);
+                        pop_from_input_queue(size);
+                        return;
+                    }
+
+#ifdef OSMIUM_WITH_IO_URING
+                    if (m_uring) {
+                        if (!m_uring->read_exactly(nullptr, size)) {
+                            throw osmium::pbf_error{"unexpected EOF"};
+                        }
+                        if (m_offset_ptr) {
+                            *m_offset_ptr += size;
+                        }
+                        return;
+                    }
+#endif
+
+                    // file_offset() returns 0 for pipes which are then read
+                    const auto offset = osmium::file_offset(m_fd);
+                    if (offset == 0 || offset + size > osmium::file_size(m_fd)) {
+                        read_from_input_queue_with_check(size);
+                        return;
+                    }
+
+                    osmium::file_seek(m_fd, offset + size);
+                    if (m_offset_ptr) {
+                        *m_offset_ptr += size;
+                    }
+                }
+
                 std::string read_from_input_queue_with_check(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error{std::string{"invalid blob size: "} +
@@ -212,7 +319,7 @@ namespace osmium {
                     if (m_fd != -1) {
                         buffer.resize(size);
 
-                        if (!osmium::io::detail::read_exactly(m_fd, &*buffer.begin(), static_cast<unsigned int>(size))) {
+                        if (!read_exactly_from_file(&*buffer.begin(), size)) {
                             throw osmium::pbf_error{"unexpected EOF"};
                         }
 
@@ -237,10 +344,16 @@ namespace osmium {
 
                 void parse_data_blobs() {
                     const bool use_pool = osmium::config::use_pool_threads_for_pbf_parsing();
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
+                    pbf_blob_indexdata indexdata;
+                    while (const auto size = check_type_and_get_blob_size("OSMData", &indexdata)) {
+                        if (!pbf_blob_wanted(indexdata.types, indexdata.bbox, read_types(), m_filter_box)) {
+                            skip_blob(size);
+                            continue;
+                        }
+
                         std::string input_buffer{read_from_input_queue_with_check(size)};
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata(), m_buffer_pool};
 
                         if (use_pool) {
                             send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
@@ -254,13 +367,172 @@ namespace osmium {
                     }
                 }
 
+#ifndef _WIN32
+                // The blob index can only be used for regular files,
+                // because the blobs are read with pread() at the offsets
+                // from the index. Pipes (stdin, URLs) are read as usual.
+                bool use_blob_index() const noexcept {
+                    if (!m_blob_index || m_fd == -1) {
+                        return false;
+                    }
+                    struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                    return ::fstat(m_fd, &s) == 0 && S_ISREG(s.st_mode); // NOLINT(hicpp-signed-bitwise)
+                }
+
+                // Read the data blobs listed in the blob index. Instead of
+                // walking through the file, each blob is read with its own
+                // pread() call in the pool thread which also decodes it.
+                void parse_data_blobs_with_index() {
+                    if (m_blob_index->file_size() != 0 && m_blob_index->file_size() != osmium::file_size(m_fd)) {
+                        throw osmium::pbf_error{"blob index does not match file (different size)"};
+                    }
+
+                    const bool use_pool = osmium::config::use_pool_threads_for_pbf_parsing();
+
+                    // From now on the file is owned by the shared pointer,
+                    // it will be closed after the last blob has been read.
+                    const auto file = std::make_shared<shared_file_descriptor>(m_fd);
+                    m_fd = -1;
+
+                    for (const auto& blob : *m_blob_index) {
+                        if (blob.size > max_uncompressed_blob_size) {
+                            throw osmium::pbf_error{std::string{"invalid blob size: "} +
+                                                    std::to_string(blob.size)};
+                        }
+
+                        if (pbf_blob_wanted(blob.entity_bits(), blob.bbox, read_types(), m_filter_box)) {
+                            PBFDataBlobReader data_blob_reader{file, blob, read_types(), read_metadata(), m_want_buffered_pages_removed, m_buffer_pool};
+
+                            if (use_pool) {
+                                send_to_output_queue(get_pool().submit(std::move(data_blob_reader)));
+                            } else {
+                                send_to_output_queue(data_blob_reader());
+                            }
+                        }
+
+                        if (m_offset_ptr) {
+                            *m_offset_ptr = blob.offset + blob.size;
+                        }
+                    }
+                }
+#endif
+
+                /**
+                 * Get the next blob with the expected type from memory
+                 * starting at the given offset. The offset is moved to the
+                 * beginning of the following blob header.
+                 *
+                 * @returns View of the blob or an empty view at the end of
+                 *          the data.
+                 */
+                static data_view get_blob_from_memory(const data_view& data, std::size_t& offset, const char* expected_type, pbf_blob_indexdata* indexdata = nullptr) {
+                    if (offset == data.size()) {
+                        return data_view{};
+                    }
+
+                    if (data.size() - offset < sizeof(uint32_t)) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const auto header_size = check_size(get_size_in_network_byte_order(data.data() + offset));
+                    offset += sizeof(uint32_t);
+
+                    if (data.size() - offset < header_size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const auto size = decode_blob_header(data_view{data.data() + offset, header_size}, expected_type, indexdata);
+                    offset += header_size;
+
+                    if (size > max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} +
+                                                std::to_string(size)};
+                    }
+                    if (data.size() - offset < size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const data_view blob{data.data() + offset, size};
+                    offset += size;
+
+                    return blob;
+                }
+
+                // Parse the file from a memory mapping. The blobs are handed
+                // to the decoders as views into the mapping, so the data is
+                // never copied. Blobs which are not compressed can be decoded
+                // directly from the mapping.
+                void parse_mapped_file() {
+                    const auto mapping = std::make_shared<const osmium::util::MemoryMapping>(osmium::file_size(m_fd), osmium::util::MemoryMapping::mapping_mode::readonly, m_fd);
+                    const data_view data{mapping->get_addr<const char>(), mapping->size()};
+
+                    // The mapping stays valid after the file is closed.
+                    osmium::io::detail::reliable_close(m_fd);
+                    m_fd = -1;
+
+                    std::size_t offset = 0;
+                    const auto header_blob = get_blob_from_memory(data, offset, "OSMHeader");
+                    if (header_blob.empty()) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    set_header_value(decode_header(header_blob));
+
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    if (m_blob_index && m_blob_index->file_size() != 0 && m_blob_index->file_size() != data.size()) {
+                        throw osmium::pbf_error{"blob index does not match file (different size)"};
+                    }
+
+                    const bool use_pool = osmium::config::use_pool_threads_for_pbf_parsing();
+                    const auto send_blob = [&](const data_view& blob) {
+                        PBFDataBlobDecoder data_blob_parser{mapping, blob, read_types(), read_metadata(), m_buffer_pool};
+                        if (use_pool) {
+                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
+                        } else {
+                            send_to_output_queue(data_blob_parser());
+                        }
+                    };
+
+                    if (m_blob_index) {
+                        for (const auto& blob : *m_blob_index) {
+                            if (blob.size > max_uncompressed_blob_size || blob.offset + blob.size > data.size()) {
+                                throw osmium::pbf_error{"blob index does not match file (invalid blob)"};
+                            }
+                            if (pbf_blob_wanted(blob.entity_bits(), blob.bbox, read_types(), m_filter_box)) {
+                                send_blob(data_view{data.data() + blob.offset, blob.size});
+                            }
+                            if (m_offset_ptr) {
+                                *m_offset_ptr = blob.offset + blob.size;
+                            }
+                        }
+                        return;
+                    }
+
+                    pbf_blob_indexdata indexdata;
+                    while (true) {
+                        const auto blob = get_blob_from_memory(data, offset, "OSMData", &indexdata);
+                        if (blob.empty()) {
+                            break;
+                        }
+                        if (pbf_blob_wanted(indexdata.types, indexdata.bbox, read_types(), m_filter_box)) {
+                            send_blob(blob);
+                        }
+                        if (m_offset_ptr) {
+                            *m_offset_ptr = offset;
+                        }
+                    }
+                }
+
             public:
 
                 explicit PBFParser(parser_arguments& args) :
                     Parser(args),
                     m_offset_ptr(args.offset_ptr),
+                    m_blob_index(args.pbf_blob_index),
                     m_fd(args.fd),
-                    m_want_buffered_pages_removed(args.want_buffered_pages_removed) {
+                    m_want_buffered_pages_removed(args.want_buffered_pages_removed),
+                    m_use_mmap(args.use_mmap),
+                    m_filter_box(args.filter_box),
+                    m_buffer_pool(args.buffer_pool) {
                 }
 
                 PBFParser(const PBFParser&) = delete;
@@ -274,12 +546,42 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_pbf_in");
 
+                    if (m_use_mmap && m_fd != -1) {
+                        parse_mapped_file();
+                        return;
+                    }
+
+#ifndef _WIN32
+                    const bool with_blob_index = use_blob_index();
+#else
+                    const bool with_blob_index = false;
+#endif
+
+#ifdef OSMIUM_WITH_IO_URING
+                    // With a blob index the data blobs are read with pread()
+                    // from the thread pool, so reading ahead is not useful.
+                    if (m_fd != -1 && !m_want_buffered_pages_removed && !with_blob_index) {
+                        m_uring = make_uring_io<UringReader>(m_fd);
+                    }
+#endif
+
                     parse_header_blob();
 
                     if (read_types() != osmium::osm_entity_bits::nothing) {
+#ifndef _WIN32
+                        if (with_blob_index) {
+                            parse_data_blobs_with_index();
+                        } else {
+                            parse_data_blobs();
+                        }
+#else
                         parse_data_blobs();
+#endif
                     }
 
+#ifdef OSMIUM_WITH_IO_URING
+                    m_uring.reset();
+#endif
                     osmium::io::detail::reliable_close(m_fd);
                 }
 
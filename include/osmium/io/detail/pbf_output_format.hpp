@@ -55,6 +55,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/metadata_options.hpp>
@@ -75,6 +76,10 @@ DEALINGS IN THE SOFTWARE.
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/pbf_builder.hpp>
 #include <protozero/pbf_writer.hpp>
 #include <protozero/types.hpp>
@@ -111,6 +116,13 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways = false;
 
+                /**
+                 * Should information about the contents of each blob (entity
+                 * types and bounding box of the nodes) be added to the
+                 * indexdata field of the BlobHeader?
+                 */
+                bool add_indexdata = false;
+
             }; // struct pbf_output_options
 
             /**
@@ -278,6 +290,7 @@ namespace osmium {
                 std::unique_ptr<DenseNodes> m_dense_nodes;
                 OSMFormat::PrimitiveGroup m_type;
                 int m_count = 0;
+                osmium::Box m_bbox;
 
             public:
 
@@ -315,9 +328,23 @@ namespace osmium {
                         m_dense_nodes = std::make_unique<DenseNodes>(&m_stringtable, &m_options);
                     }
                     m_dense_nodes->add_node(node);
+                    m_bbox.extend(node.location());
                     ++m_count;
                 }
 
+                /// Extend the bounding box of the nodes in this block.
+                void extend_bbox(const osmium::Location& location) noexcept {
+                    m_bbox.extend(location);
+                }
+
+                /**
+                 * The bounding box of the nodes in this block. Invalid if
+                 * this is not a node block or no node has a valid location.
+                 */
+                const osmium::Box& bbox() const noexcept {
+                    return m_bbox;
+                }
+
                 // There are two functions store_in_stringtable(_unsigned)
                 // here because of an inconsistency in the OSMPBF format
                 // specification. Both uint32 and sint32 types are used in
@@ -352,6 +379,21 @@ namespace osmium {
                     max_used_blob_size = max_uncompressed_blob_size * 95U / 100U
                 };
 
+                /// The type of entities in this block.
+                osmium::osm_entity_bits::type entity_bits() const noexcept {
+                    switch (m_type) {
+                        case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                            return osmium::osm_entity_bits::way;
+                        case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                            return osmium::osm_entity_bits::relation;
+                        case OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets:
+                            return osmium::osm_entity_bits::changeset;
+                        default:
+                            break;
+                    }
+                    return osmium::osm_entity_bits::node;
+                }
+
                 bool can_add(OSMFormat::PrimitiveGroup type) const noexcept {
                     if (type != m_type) {
                         return false;
@@ -376,6 +418,23 @@ namespace osmium {
 
                 pbf_compression m_use_compression;
 
+                bool m_add_indexdata = false;
+
+                std::string indexdata() const {
+                    std::string data;
+                    protozero::pbf_builder<OsmiumIndexData::IndexData> pbf_indexdata{data};
+                    pbf_indexdata.add_string(OsmiumIndexData::IndexData::required_string_format, osmium_indexdata_format());
+                    pbf_indexdata.add_uint32(OsmiumIndexData::IndexData::optional_uint32_entity_bits, static_cast<uint32_t>(m_block->entity_bits()));
+                    const auto& bbox = m_block->bbox();
+                    if (bbox.valid()) {
+                        pbf_indexdata.add_sint32(OsmiumIndexData::IndexData::optional_sint32_min_x, bbox.bottom_left().x());
+                        pbf_indexdata.add_sint32(OsmiumIndexData::IndexData::optional_sint32_min_y, bbox.bottom_left().y());
+                        pbf_indexdata.add_sint32(OsmiumIndexData::IndexData::optional_sint32_max_x, bbox.top_right().x());
+                        pbf_indexdata.add_sint32(OsmiumIndexData::IndexData::optional_sint32_max_y, bbox.top_right().y());
+                    }
+                    return data;
+                }
+
             public:
 
                 /**
@@ -400,12 +459,15 @@ namespace osmium {
                  * @param type Type of blob.
                  * @param use_compression The type of compression to use.
                  * @param compression_level Compression level.
+                 * @param add_indexdata Add information about the block to
+                 *                      the BlobHeader.
                  */
-                SerializeBlob(std::shared_ptr<PrimitiveBlock> block, pbf_blob_type type, pbf_compression use_compression, int compression_level) :
+                SerializeBlob(std::shared_ptr<PrimitiveBlock> block, pbf_blob_type type, pbf_compression use_compression, int compression_level, bool add_indexdata = false) :
                     m_block(std::move(block)),
                     m_compression_level(compression_level),
                     m_blob_type(type),
-                    m_use_compression(use_compression) {
+                    m_use_compression(use_compression),
+                    m_add_indexdata(add_indexdata) {
                 }
 
                 /**
@@ -446,6 +508,16 @@ namespace osmium {
 #else
                             throw osmium::pbf_error{"lz4 blobs not supported"};
 #endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
+#else
+                            throw osmium::pbf_error{"zstd blobs not supported"};
+#endif
+                        case pbf_compression::lzma:
+                            throw osmium::pbf_error{"writing lzma blobs not supported"};
                     }
 
                     std::string blob_header_data;
@@ -453,6 +525,10 @@ namespace osmium {
 
                     pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, m_blob_type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
 
+                    if (m_add_indexdata && m_block) {
+                        pbf_blob_header.add_bytes(FileFormat::BlobHeader::optional_bytes_indexdata, indexdata());
+                    }
+
                     // The static_cast is okay, because the size can never
                     // be much larger than max_uncompressed_blob_size. This
                     // is due to the assert above and the fact that the zlib
@@ -478,35 +554,21 @@ namespace osmium {
 
             }; // class SerializeBlob
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * Encodes OSM objects into PrimitiveBlocks. A new block is
+             * started whenever the current one is full or the type of
+             * PrimitiveGroup changes. Finished blocks are collected and can
+             * be taken out with take_blocks().
+             */
+            class PrimitiveBlockEncoder : public osmium::handler::Handler {
 
-                pbf_output_options m_options;
+                const pbf_output_options& m_options;
 
                 std::shared_ptr<PrimitiveBlock> m_primitive_block;
 
-                std::size_t m_bucket_count = StringTable::min_bucket_count;
+                std::vector<std::shared_ptr<PrimitiveBlock>> m_blocks;
 
-                void store_primitive_block() {
-                    if (!m_primitive_block || m_primitive_block->count() == 0) {
-                        return;
-                    }
-
-                    // Remember the bucket_count of the hash in the string
-                    // table. It will be used when initializing the string
-                    // table for the next block.
-                    //
-                    // Some versions of the std library will set the bucket
-                    // count always larger then what we set it to. We decrease
-                    // the bucket count by one, this way the bucket will not
-                    // grow too much.
-                    m_bucket_count = m_primitive_block->get_bucket_count() - 1;
-
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(m_primitive_block),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression,
-                                      m_options.compression_level}));
-                }
+                std::size_t m_bucket_count = StringTable::min_bucket_count;
 
                 template <typename T>
                 void add_meta(const osmium::OSMObject& object, T& pbf_object) {
@@ -552,11 +614,235 @@ namespace osmium {
 
                 void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
                     if (!m_primitive_block || !m_primitive_block->can_add(type)) {
-                        store_primitive_block();
+                        finish_block();
                         m_primitive_block = std::make_shared<PrimitiveBlock>(m_options, type, m_bucket_count);
                     }
                 }
 
+            public:
+
+                explicit PrimitiveBlockEncoder(const pbf_output_options& options) :
+                    m_options(options) {
+                }
+
+                /**
+                 * Finish the current block (if there is one) and add it to
+                 * the list of finished blocks.
+                 */
+                void finish_block() {
+                    if (!m_primitive_block || m_primitive_block->count() == 0) {
+                        return;
+                    }
+
+                    // Remember the bucket_count of the hash in the string
+                    // table. It will be used when initializing the string
+                    // table for the next block.
+                    //
+                    // Some versions of the std library will set the bucket
+                    // count always larger then what we set it to. We decrease
+                    // the bucket count by one, this way the bucket will not
+                    // grow too much.
+                    m_bucket_count = m_primitive_block->get_bucket_count() - 1;
+
+                    m_blocks.push_back(std::move(m_primitive_block));
+                }
+
+                /**
+                 * Get all finished blocks in the order they were created.
+                 * Afterwards the list of finished blocks is empty.
+                 */
+                std::vector<std::shared_ptr<PrimitiveBlock>> take_blocks() {
+                    std::vector<std::shared_ptr<PrimitiveBlock>> blocks;
+                    blocks.swap(m_blocks);
+                    return blocks;
+                }
+
+                void node(const osmium::Node& node) {
+                    if (m_options.use_dense_nodes) {
+                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
+                        m_primitive_block->add_dense_node(node);
+                        return;
+                    }
+
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
+                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
+
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
+                    add_meta(node, pbf_node);
+
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, node.location().y());
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, node.location().x());
+                    m_primitive_block->extend_bbox(node.location());
+                }
+
+                void way(const osmium::Way& way) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
+                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
+
+                    pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
+                    add_meta(way, pbf_way);
+
+                    {
+                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_way, static_cast<protozero::pbf_tag_type>(OSMFormat::Way::packed_sint64_refs)};
+                        for (const auto& node_ref : way.nodes()) {
+                            field.add_element(delta_id.update(node_ref.ref()));
+                        }
+                    }
+
+                    if (m_options.locations_on_ways) {
+                        {
+                            osmium::DeltaEncode<int64_t, int64_t> delta;
+                            protozero::packed_field_sint64 field{pbf_way, static_cast<protozero::pbf_tag_type>(OSMFormat::Way::packed_sint64_lon)};
+                            for (const auto& node_ref : way.nodes()) {
+                                field.add_element(delta.update(node_ref.location().x()));
+                            }
+                        }
+                        {
+                            osmium::DeltaEncode<int64_t, int64_t> delta;
+                            protozero::packed_field_sint64 field{pbf_way, static_cast<protozero::pbf_tag_type>(OSMFormat::Way::packed_sint64_lat)};
+                            for (const auto& node_ref : way.nodes()) {
+                                field.add_element(delta.update(node_ref.location().y()));
+                            }
+                        }
+                    }
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
+
+                    pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
+                    add_meta(relation, pbf_relation);
+
+                    {
+                        protozero::packed_field_int32 field{pbf_relation, static_cast<protozero::pbf_tag_type>(OSMFormat::Relation::packed_int32_roles_sid)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(m_primitive_block->store_in_stringtable(member.role()));
+                        }
+                    }
+
+                    {
+                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_relation, static_cast<protozero::pbf_tag_type>(OSMFormat::Relation::packed_sint64_memids)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(delta_id.update(member.ref()));
+                        }
+                    }
+
+                    {
+                        protozero::packed_field_int32 field{pbf_relation, static_cast<protozero::pbf_tag_type>(OSMFormat::Relation::packed_MemberType_types)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(static_cast<int32_t>(osmium::item_type_to_nwr_index(member.type())));
+                        }
+                    }
+                }
+
+            }; // class PrimitiveBlockEncoder
+
+            /**
+             * Returns the type of PrimitiveGroup an OSM object of the
+             * specified type will be encoded in or 0 if it will not be
+             * encoded at all.
+             */
+            inline int primitive_group_for(osmium::item_type type, bool use_dense_nodes) noexcept {
+                switch (type) {
+                    case osmium::item_type::node:
+                        return use_dense_nodes ? static_cast<int>(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense)
+                                               : static_cast<int>(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
+                    case osmium::item_type::way:
+                        return static_cast<int>(OSMFormat::PrimitiveGroup::repeated_Way_ways);
+                    case osmium::item_type::relation:
+                        return static_cast<int>(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                    default:
+                        break;
+                }
+                return 0;
+            }
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                PrimitiveBlockEncoder m_encoder{m_options};
+
+                /// Encode buffers in parallel on the thread pool?
+                bool m_parallel_encoding = false;
+
+                void store_primitive_blocks() {
+                    for (auto& block : m_encoder.take_blocks()) {
+                        m_output_queue.push(m_pool.submit(
+                            SerializeBlob{std::move(block),
+                                          pbf_blob_type::data,
+                                          m_options.use_compression,
+                                          m_options.compression_level,
+                                          m_options.add_indexdata}));
+                    }
+                }
+
+                /**
+                 * Encode the objects in [first, last) into one or more
+                 * blocks on the thread pool and push the resulting blobs
+                 * into the output queue.
+                 */
+                void encode_batch_in_pool(const std::shared_ptr<osmium::memory::Buffer>& buffer,
+                                          osmium::memory::Buffer::const_iterator first,
+                                          osmium::memory::Buffer::const_iterator last) {
+                    m_output_queue.push(m_pool.submit([options = m_options, shared_buffer = buffer, first, last]() mutable {
+                        PrimitiveBlockEncoder encoder{options};
+                        osmium::apply(first, last, encoder);
+                        encoder.finish_block();
+
+                        // release the buffer early, so it can go back to
+                        // the buffer pool before the result is visible
+                        shared_buffer.reset();
+
+                        std::string output;
+                        for (auto& block : encoder.take_blocks()) {
+                            output += SerializeBlob{std::move(block),
+                                                    pbf_blob_type::data,
+                                                    options.use_compression,
+                                                    options.compression_level,
+                                                    options.add_indexdata}();
+                        }
+                        return output;
+                    }));
+                }
+
+                /**
+                 * Split the buffer into batches of objects which will end
+                 * up in the same block and encode each batch on the thread
+                 * pool. Blocks never span batches, so the order of blocks
+                 * in the output is the same regardless of the scheduling
+                 * of the tasks.
+                 */
+                void write_buffer_parallel(osmium::memory::Buffer&& buffer) {
+                    const auto shared_buffer = make_shared_buffer(std::move(buffer), buffer_pool());
+
+                    auto first = shared_buffer->cbegin();
+                    int group = 0;
+                    int count = 0;
+                    for (auto it = shared_buffer->cbegin(); it != shared_buffer->cend(); ++it) {
+                        const int item_group = primitive_group_for(it->type(), m_options.use_dense_nodes);
+                        if (item_group == 0) {
+                            continue;
+                        }
+                        if (count > 0 && (item_group != group || count >= max_entities_per_block)) {
+                            encode_batch_in_pool(shared_buffer, first, it);
+                            count = 0;
+                        }
+                        if (count == 0) {
+                            first = it;
+                            group = item_group;
+                        }
+                        ++count;
+                    }
+
+                    if (count > 0) {
+                        encode_batch_in_pool(shared_buffer, first, shared_buffer->cend());
+                    }
+                }
+
             public:
 
                 PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
@@ -572,6 +858,8 @@ namespace osmium {
                     m_options.add_historical_information_flag = file.has_multiple_object_versions();
                     m_options.add_visible_flag = file.has_multiple_object_versions();
                     m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.add_indexdata = file.is_true("pbf_indexdata");
+                    m_parallel_encoding = file.is_true("pbf_parallel_encoding");
 
                     const auto pbl = file.get("pbf_compression_level");
                     if (pbl.empty()) {
@@ -586,6 +874,13 @@ namespace osmium {
                                 m_options.compression_level = osmium::io::detail::lz4_default_compression_level();
 #endif
                                 break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                m_options.compression_level = osmium::io::detail::zstd_default_compression_level();
+#endif
+                                break;
+                            case pbf_compression::lzma:
+                                break;
                         }
                     } else {
                         char* end_ptr = nullptr;
@@ -604,6 +899,13 @@ namespace osmium {
                                 osmium::io::detail::lz4_check_compression_level(val);
 #endif
                                 break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                osmium::io::detail::zstd_check_compression_level(val);
+#endif
+                                break;
+                            case pbf_compression::lzma:
+                                break;
                         }
                         m_options.compression_level = static_cast<int>(val);
                     }
@@ -667,91 +969,18 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
-                }
-
-                void write_end() final {
-                    store_primitive_block();
-                }
-
-                void node(const osmium::Node& node) {
-                    if (m_options.use_dense_nodes) {
-                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
-                        m_primitive_block->add_dense_node(node);
+                    if (m_parallel_encoding) {
+                        write_buffer_parallel(std::move(buffer));
                         return;
                     }
-
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
-                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
-
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
-                    add_meta(node, pbf_node);
-
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, node.location().y());
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, node.location().x());
-                }
-
-                void way(const osmium::Way& way) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
-                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
-
-                    pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
-                    add_meta(way, pbf_way);
-
-                    {
-                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
-                        protozero::packed_field_sint64 field{pbf_way, static_cast<protozero::pbf_tag_type>(OSMFormat::Way::packed_sint64_refs)};
-                        for (const auto& node_ref : way.nodes()) {
-                            field.add_element(delta_id.update(node_ref.ref()));
-                        }
-                    }
-
-                    if (m_options.locations_on_ways) {
-                        {
-                            osmium::DeltaEncode<int64_t, int64_t> delta;
-                            protozero::packed_field_sint64 field{pbf_way, static_cast<protozero::pbf_tag_type>(OSMFormat::Way::packed_sint64_lon)};
-                            for (const auto& node_ref : way.nodes()) {
-                                field.add_element(delta.update(node_ref.location().x()));
-                            }
-                        }
-                        {
-                            osmium::DeltaEncode<int64_t, int64_t> delta;
-                            protozero::packed_field_sint64 field{pbf_way, static_cast<protozero::pbf_tag_type>(OSMFormat::Way::packed_sint64_lat)};
-                            for (const auto& node_ref : way.nodes()) {
-                                field.add_element(delta.update(node_ref.location().y()));
-                            }
-                        }
-                    }
+                    osmium::apply(buffer.cbegin(), buffer.cend(), m_encoder);
+                    store_primitive_blocks();
+                    recycle_buffer(std::move(buffer));
                 }
 
-                void relation(const osmium::Relation& relation) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
-                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
-
-                    pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
-                    add_meta(relation, pbf_relation);
-
-                    {
-                        protozero::packed_field_int32 field{pbf_relation, static_cast<protozero::pbf_tag_type>(OSMFormat::Relation::packed_int32_roles_sid)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(m_primitive_block->store_in_stringtable(member.role()));
-                        }
-                    }
-
-                    {
-                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
-                        protozero::packed_field_sint64 field{pbf_relation, static_cast<protozero::pbf_tag_type>(OSMFormat::Relation::packed_sint64_memids)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(delta_id.update(member.ref()));
-                        }
-                    }
-
-                    {
-                        protozero::packed_field_int32 field{pbf_relation, static_cast<protozero::pbf_tag_type>(OSMFormat::Relation::packed_MemberType_types)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(static_cast<int32_t>(osmium::item_type_to_nwr_index(member.type())));
-                        }
-                    }
+                void write_end() final {
+                    m_encoder.finish_block();
+                    store_primitive_blocks();
                 }
 
             }; // class PBFOutputFormat
@@ -63,6 +63,26 @@ namespace osmium {
 
             } // namespace FileFormat
 
+            // Contents of the BlobHeader indexdata field as written by
+            // libosmium. This is not part of the official format, other
+            // programs might store something else in there. The format
+            // field is used to recognize our own data. The bounding box
+            // of the nodes in a blob is stored in the same units as the
+            // coordinates in osmium::Location.
+
+            namespace OsmiumIndexData {
+
+                enum class IndexData : protozero::pbf_tag_type {
+                    required_string_format      = 1,
+                    optional_uint32_entity_bits = 2,
+                    optional_sint32_min_x       = 3,
+                    optional_sint32_min_y       = 4,
+                    optional_sint32_max_x       = 5,
+                    optional_sint32_max_y       = 6
+                };
+
+            } // namespace OsmiumIndexData
+
             // directly translated from
             // https://github.com/openstreetmap/OSM-binary/blob/master/src/osmformat.proto
 
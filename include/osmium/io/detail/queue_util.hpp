@@ -34,7 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/bounded_queue.hpp>
 
 #include <cassert>
 #include <exception>
@@ -49,7 +49,7 @@ namespace osmium {
         namespace detail {
 
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using future_queue_type = osmium::thread::BoundedQueue<std::future<T>>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
@@ -228,6 +228,39 @@ namespace osmium {
                 return true;
             }
 
+#ifndef _WIN32
+            /**
+             * Read exactly size bytes from fd at the given offset into buffer.
+             * This uses pread(2), so it doesn't change the file offset and
+             * can be called from several threads at the same time with the
+             * same file descriptor. Does not work on pipes.
+             *
+             * @pre buffer Buffer for data to be read. Must be at least size bytes long.
+             * @returns true if size bytes could be read
+             *          false if EOF was encountered
+             * @throws std::system_error On error.
+             */
+            inline bool read_exactly_at(int fd, char* buffer, std::size_t size, std::size_t offset) {
+                std::size_t done = 0;
+
+                while (done < size) {
+                    const auto read_size = ::pread(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+                    if (read_size < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    if (read_size == 0) { // EOF
+                        return false;
+                    }
+                    done += static_cast<std::size_t>(read_size);
+                }
+
+                return true;
+            }
+#endif
+
             inline void reliable_fsync(const int fd) {
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
@@ -312,6 +345,21 @@ namespace osmium {
 #endif
             }
 
+            /**
+             * Tell the kernel to remove all pages from the specified range
+             * of this file from the buffer cache. Used when parts of a file
+             * are read out of order and will not be needed again soon.
+             */
+#if defined(__linux__) || defined(__FreeBSD__)
+            inline void remove_buffered_pages(int fd, std::size_t offset, std::size_t size) noexcept {
+                if (fd > 0 && size > 0) {
+                    ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+                }
+#else
+            inline void remove_buffered_pages(int /*fd*/, std::size_t /*offset*/, std::size_t /*size*/) noexcept {
+#endif
+            }
+
         } // namespace detail
 
     } // namespace io
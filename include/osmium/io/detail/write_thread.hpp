@@ -86,11 +86,11 @@ namespace osmium {
 
                     try {
                         while (true) {
-                            const std::string data{m_queue.pop()};
+                            std::string data{m_queue.pop()};
                             if (at_end_of_data(data)) {
                                 break;
                             }
-                            m_compressor->write(data);
+                            m_compressor->write_owned(std::move(data));
                         }
                         m_compressor->close();
                         m_promise.set_value(m_compressor->file_size());
@@ -58,14 +58,20 @@ DEALINGS IN THE SOFTWARE.
 
 #include <expat.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <deque>
 #include <exception>
 #include <future>
 #include <limits>
 #include <memory>
+#include <new>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -125,7 +131,73 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser final : public ParserWithBuffer {
+            /**
+             * Storage for a builder which is constructed in place when
+             * needed. Used instead of std::unique_ptr to avoid a memory
+             * allocation for every OSM object.
+             */
+            template <typename T>
+            class builder_slot {
+
+                alignas(T) unsigned char m_storage[sizeof(T)];
+                bool m_valid = false;
+
+            public:
+
+                builder_slot() noexcept = default;
+
+                builder_slot(const builder_slot&) = delete;
+                builder_slot& operator=(const builder_slot&) = delete;
+
+                builder_slot(builder_slot&&) = delete;
+                builder_slot& operator=(builder_slot&&) = delete;
+
+                ~builder_slot() noexcept {
+                    reset();
+                }
+
+                template <typename... TArgs>
+                void emplace(TArgs&&... args) {
+                    reset();
+                    new (m_storage) T(std::forward<TArgs>(args)...);
+                    m_valid = true;
+                }
+
+                void reset() noexcept {
+                    if (m_valid) {
+                        m_valid = false;
+                        reinterpret_cast<T*>(m_storage)->~T();
+                    }
+                }
+
+                explicit operator bool() const noexcept {
+                    return m_valid;
+                }
+
+                T& operator*() noexcept {
+                    assert(m_valid);
+                    return *reinterpret_cast<T*>(m_storage);
+                }
+
+                T* operator->() noexcept {
+                    assert(m_valid);
+                    return reinterpret_cast<T*>(m_storage);
+                }
+
+            }; // class builder_slot
+
+            /**
+             * Builds OSM objects from the XML elements reported by an XML
+             * parser. The objects are written into buffers provided by the
+             * TOutput object, which must have the functions buffer(),
+             * maybe_new_buffer(), flush_nested_buffer() and
+             * set_header_value() like the ParserWithBuffer class.
+             */
+            template <typename TOutput>
+            class XMLElementHandler {
+
+                TOutput& m_output;
+                osmium::osm_entity_bits::type m_read_types;
 
                 enum class context {
                     osm,
@@ -152,120 +224,33 @@ namespace osmium {
 
                 osmium::io::Header m_header;
 
-                std::unique_ptr<osmium::builder::NodeBuilder>                m_node_builder;
-                std::unique_ptr<osmium::builder::WayBuilder>                 m_way_builder;
-                std::unique_ptr<osmium::builder::RelationBuilder>            m_relation_builder;
-                std::unique_ptr<osmium::builder::ChangesetBuilder>           m_changeset_builder;
-                std::unique_ptr<osmium::builder::ChangesetDiscussionBuilder> m_changeset_discussion_builder;
+                builder_slot<osmium::builder::NodeBuilder>                m_node_builder;
+                builder_slot<osmium::builder::WayBuilder>                 m_way_builder;
+                builder_slot<osmium::builder::RelationBuilder>            m_relation_builder;
+                builder_slot<osmium::builder::ChangesetBuilder>           m_changeset_builder;
+                builder_slot<osmium::builder::ChangesetDiscussionBuilder> m_changeset_discussion_builder;
 
-                std::unique_ptr<osmium::builder::TagListBuilder>             m_tl_builder;
-                std::unique_ptr<osmium::builder::WayNodeListBuilder>         m_wnl_builder;
-                std::unique_ptr<osmium::builder::RelationMemberListBuilder>  m_rml_builder;
+                builder_slot<osmium::builder::TagListBuilder>             m_tl_builder;
+                builder_slot<osmium::builder::WayNodeListBuilder>         m_wnl_builder;
+                builder_slot<osmium::builder::RelationMemberListBuilder>  m_rml_builder;
 
                 std::string m_comment_text;
 
-                /**
-                 * A C++ wrapper for the Expat parser that makes sure no memory
-                 * is leaked.
-                 */
-                class ExpatXMLParser {
-
-                    XML_Parser m_parser;
-                    std::exception_ptr m_exception_ptr{}; // NOLINT(bugprone-throw-keyword-missing) see https://bugs.llvm.org/show_bug.cgi?id=52400
-
-                    template <typename TFunc>
-                    void member_wrap(XMLParser& xml_parser, TFunc&& func) noexcept {
-                        if (m_exception_ptr) {
-                            return;
-                        }
-                        try {
-                            std::forward<TFunc>(func)(xml_parser);
-                        } catch (...) {
-                            m_exception_ptr = std::current_exception();
-                            XML_StopParser(m_parser, 0);
-                        }
-                    }
-
-                    template <typename TFunc>
-                    static void wrap(void* data, TFunc&& func) noexcept {
-                        assert(data);
-                        auto& xml_parser = *static_cast<XMLParser*>(data);
-                        xml_parser.m_expat_xml_parser->member_wrap(xml_parser, std::forward<TFunc>(func));
-                    }
-
-                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
-                            xml_parser.start_element(element, attrs);
-                        });
-                    }
-
-                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
-                            xml_parser.end_element(element);
-                        });
-                    }
-
-                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
-                            xml_parser.characters(text, len);
-                        });
-                    }
-
-                    // This handler is called when there are any XML entities
-                    // declared in the OSM file. Entities are normally not used,
-                    // but they can be misused. See
-                    // https://en.wikipedia.org/wiki/Billion_laughs
-                    // The handler will just throw an error.
-                    static void entity_declaration_handler(void* data,
-                            const XML_Char* /*entityName*/,
-                            int /*is_parameter_entity*/,
-                            const XML_Char* /*value*/,
-                            int /*value_length*/,
-                            const XML_Char* /*base*/,
-                            const XML_Char* /*systemId*/,
-                            const XML_Char* /*publicId*/,
-                            const XML_Char* /*notationName*/) noexcept {
-                        wrap(data, [&](XMLParser& /*xml_parser*/) {
-                            throw osmium::xml_error{"XML entities are not supported"};
-                        });
-                    }
-
-                public:
-
-                    explicit ExpatXMLParser(void* callback_object) :
-                        m_parser(XML_ParserCreate(nullptr)) {
-                        if (!m_parser) {
-                            throw osmium::io_error{"Internal error: Can not create parser"};
-                        }
-                        XML_SetUserData(m_parser, callback_object);
-                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
-                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
-                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
-                    }
-
-                    ExpatXMLParser(const ExpatXMLParser&) = delete;
-                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
-
-                    ExpatXMLParser(ExpatXMLParser&&) = delete;
-                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
-
-                    ~ExpatXMLParser() noexcept {
-                        XML_ParserFree(m_parser);
-                    }
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_read_types;
+                }
 
-                    void operator()(const std::string& data, bool last) {
-                        assert(data.size() < std::numeric_limits<int>::max());
-                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
-                            if (m_exception_ptr) {
-                                std::rethrow_exception(m_exception_ptr);
-                            }
-                            throw osmium::xml_error{m_parser};
-                        }
-                    }
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_output.buffer();
+                }
 
-                }; // class ExpatXMLParser
+                void maybe_new_buffer(osmium::item_type current_type) {
+                    m_output.maybe_new_buffer(current_type);
+                }
 
-                ExpatXMLParser* m_expat_xml_parser{nullptr};
+                void flush_nested_buffer() {
+                    m_output.flush_nested_buffer();
+                }
 
                 template <typename TFunc>
                 static void check_attributes(const XML_Char** attrs, TFunc&& check) {
@@ -338,13 +323,13 @@ namespace osmium {
                     });
 
                     if (!m_tl_builder) {
-                        m_tl_builder = std::make_unique<osmium::builder::TagListBuilder>(builder);
+                        m_tl_builder.emplace(builder);
                     }
                     m_tl_builder->add_tag(k, v);
                 }
 
                 void mark_header_as_done() {
-                    set_header_value(m_header);
+                    m_output.set_header_value(m_header);
                 }
 
                 void top_level_element(const XML_Char* element, const XML_Char** attrs) {
@@ -391,7 +376,7 @@ namespace osmium {
                         mark_header_as_done();
                         if (read_types() & osmium::osm_entity_bits::node) {
                             maybe_new_buffer(osmium::item_type::node);
-                            m_node_builder = std::make_unique<osmium::builder::NodeBuilder>(buffer());
+                            m_node_builder.emplace(buffer());
                             m_node_builder->set_user(init_object(m_node_builder->object(), attrs));
                         }
                         return;
@@ -402,7 +387,7 @@ namespace osmium {
                         mark_header_as_done();
                         if (read_types() & osmium::osm_entity_bits::way) {
                             maybe_new_buffer(osmium::item_type::way);
-                            m_way_builder = std::make_unique<osmium::builder::WayBuilder>(buffer());
+                            m_way_builder.emplace(buffer());
                             m_way_builder->set_user(init_object(m_way_builder->object(), attrs));
                         }
                         return;
@@ -413,7 +398,7 @@ namespace osmium {
                         mark_header_as_done();
                         if (read_types() & osmium::osm_entity_bits::relation) {
                             maybe_new_buffer(osmium::item_type::relation);
-                            m_relation_builder = std::make_unique<osmium::builder::RelationBuilder>(buffer());
+                            m_relation_builder.emplace(buffer());
                             m_relation_builder->set_user(init_object(m_relation_builder->object(), attrs));
                         }
                         return;
@@ -428,7 +413,7 @@ namespace osmium {
                         mark_header_as_done();
                         if (read_types() & osmium::osm_entity_bits::changeset) {
                             maybe_new_buffer(osmium::item_type::changeset);
-                            m_changeset_builder = std::make_unique<osmium::builder::ChangesetBuilder>(buffer());
+                            m_changeset_builder.emplace(buffer());
                             init_changeset(*m_changeset_builder, attrs);
                         }
                     } else if (!std::strcmp(element, "create")) {
@@ -472,6 +457,17 @@ namespace osmium {
                     }
                 }
 
+            public:
+
+                XMLElementHandler(TOutput& output, osmium::osm_entity_bits::type read_types) :
+                    m_output(output),
+                    m_read_types(read_types) {
+                }
+
+                const osmium::io::Header& header() const noexcept {
+                    return m_header;
+                }
+
                 void start_element(const XML_Char* element, const XML_Char** attrs) {
                     if (m_context_stack.empty()) {
                         top_level_element(element, attrs);
@@ -508,7 +504,7 @@ namespace osmium {
                                     m_tl_builder.reset();
 
                                     if (!m_wnl_builder) {
-                                        m_wnl_builder = std::make_unique<osmium::builder::WayNodeListBuilder>(*m_way_builder);
+                                        m_wnl_builder.emplace(*m_way_builder);
                                     }
 
                                     NodeRef nr;
@@ -542,7 +538,7 @@ namespace osmium {
                                     m_tl_builder.reset();
 
                                     if (!m_rml_builder) {
-                                        m_rml_builder = std::make_unique<osmium::builder::RelationMemberListBuilder>(*m_relation_builder);
+                                        m_rml_builder.emplace(*m_relation_builder);
                                     }
 
                                     item_type type = item_type::undefined;
@@ -591,7 +587,7 @@ namespace osmium {
                                 if (read_types() & osmium::osm_entity_bits::changeset) {
                                     m_tl_builder.reset();
                                     if (!m_changeset_discussion_builder) {
-                                        m_changeset_discussion_builder = std::make_unique<osmium::builder::ChangesetDiscussionBuilder>(*m_changeset_builder);
+                                        m_changeset_discussion_builder.emplace(*m_changeset_builder);
                                     }
                                 }
                             } else if (!std::strcmp(element, "tag")) {
@@ -746,23 +742,768 @@ namespace osmium {
                     }
                 }
 
+            }; // class XMLElementHandler
+
+            inline bool xml_is_space(char c) noexcept {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+            }
+
+            // Check whether the element name in [first, last) is name.
+            inline bool xml_name_is(const char* first, const char* last, const char* name) noexcept {
+                const auto len = std::strlen(name);
+                return static_cast<std::size_t>(last - first) == len && !std::memcmp(first, name, len);
+            }
+
+            // Write the UTF-8 encoding of the code point to out and return
+            // the position after it.
+            inline char* xml_append_utf8(char* out, uint32_t cp) noexcept {
+                if (cp < 0x80UL) {
+                    *out++ = static_cast<char>(cp);
+                } else if (cp < 0x800UL) {
+                    *out++ = static_cast<char>(0xc0U | (cp >> 6U));
+                    *out++ = static_cast<char>(0x80U | (cp & 0x3fU));
+                } else if (cp < 0x10000UL) {
+                    *out++ = static_cast<char>(0xe0U | (cp >> 12U));
+                    *out++ = static_cast<char>(0x80U | ((cp >> 6U) & 0x3fU));
+                    *out++ = static_cast<char>(0x80U | (cp & 0x3fU));
+                } else {
+                    *out++ = static_cast<char>(0xf0U | (cp >> 18U));
+                    *out++ = static_cast<char>(0x80U | ((cp >> 12U) & 0x3fU));
+                    *out++ = static_cast<char>(0x80U | ((cp >> 6U) & 0x3fU));
+                    *out++ = static_cast<char>(0x80U | (cp & 0x3fU));
+                }
+                return out;
+            }
+
+            // Find the '>' at the end of the tag starting at first, skipping
+            // over quoted attribute values. Returns nullptr if the end is not
+            // in the data.
+            template <typename T>
+            T* xml_find_tag_end(T* first, T* last) noexcept {
+                for (; first != last; ++first) {
+                    if (*first == '>') {
+                        return first;
+                    }
+                    if (*first == '"' || *first == '\'') {
+                        auto* quote = static_cast<T*>(std::memchr(first + 1, *first, static_cast<std::size_t>(last - first - 1)));
+                        if (!quote) {
+                            return nullptr;
+                        }
+                        first = quote;
+                    }
+                }
+                return nullptr;
+            }
+
+            /**
+             * A fast non-validating XML scanner for OSM XML files. It can
+             * be used instead of the Expat parser and understands the
+             * subset of XML used in OSM files: Elements, attributes,
+             * character data, comments, processing instructions, and CDATA
+             * sections. There is no support for DTDs and no entities other
+             * than the predefined ones and character references. The input
+             * must be UTF-8 encoded.
+             *
+             * The data is parsed in place: Element names and attribute
+             * values are null-terminated and unescaped directly in the
+             * input, so there are no allocations per element. For every
+             * element the handler functions start_element(), end_element(),
+             * and characters() are called with the same arguments Expat
+             * would use.
+             *
+             * The input can be given in pieces of any size. Incomplete
+             * markup at the end of a piece is kept until the next piece
+             * arrives.
+             */
+            template <typename THandler>
+            class XMLScanner {
+
+                THandler& m_handler;
+
+                // Data from the end of the last input that could not be
+                // parsed yet.
+                std::string m_rest;
+
+                // Names and values of the attributes of the current element
+                // in the format Expat uses.
+                std::vector<const char*> m_attrs;
+
+                // Names of the currently open elements. Only the first
+                // m_depth entries are used, the others are kept around so
+                // their memory can be reused.
+                std::vector<std::string> m_open_elements;
+                std::size_t m_depth = 0;
+
+                uint64_t m_line;
+                bool m_root_done = false;
+
+                [[noreturn]] void error(const std::string& message) const {
+                    osmium::xml_error e{std::string{"XML parsing error at line "} + std::to_string(m_line) + ": " + message};
+                    e.line = m_line;
+                    throw e;
+                }
+
+                // Decode a character reference or one of the predefined
+                // entities. The name of the reference is in [first, last),
+                // it is written to out. Returns the position after the
+                // decoded character.
+                char* decode_reference(const char* first, const char* last, char* out) const {
+                    if (first != last && *first == '#') {
+                        ++first;
+                        const bool hex = first != last && *first == 'x';
+                        if (hex) {
+                            ++first;
+                        }
+                        if (first == last) {
+                            error("invalid character reference");
+                        }
+                        uint32_t cp = 0;
+                        for (; first != last; ++first) {
+                            uint32_t digit = 0;
+                            if (*first >= '0' && *first <= '9') {
+                                digit = static_cast<uint32_t>(*first - '0');
+                            } else if (hex && *first >= 'a' && *first <= 'f') {
+                                digit = static_cast<uint32_t>(*first - 'a' + 10);
+                            } else if (hex && *first >= 'A' && *first <= 'F') {
+                                digit = static_cast<uint32_t>(*first - 'A' + 10);
+                            } else {
+                                error("invalid character reference");
+                            }
+                            cp = cp * (hex ? 16U : 10U) + digit;
+                            if (cp > 0x10ffffUL) {
+                                error("reference to invalid character number");
+                            }
+                        }
+                        if ((cp < 0x20UL && cp != 0x09UL && cp != 0x0aUL && cp != 0x0dUL) ||
+                            (cp >= 0xd800UL && cp <= 0xdfffUL) ||
+                            cp == 0xfffeUL || cp == 0xffffUL) {
+                            error("reference to invalid character number");
+                        }
+                        return xml_append_utf8(out, cp);
+                    }
+
+                    if (xml_name_is(first, last, "amp")) {
+                        *out = '&';
+                    } else if (xml_name_is(first, last, "lt")) {
+                        *out = '<';
+                    } else if (xml_name_is(first, last, "gt")) {
+                        *out = '>';
+                    } else if (xml_name_is(first, last, "quot")) {
+                        *out = '"';
+                    } else if (xml_name_is(first, last, "apos")) {
+                        *out = '\'';
+                    } else {
+                        error("undefined entity");
+                    }
+                    return out + 1;
+                }
+
+                // Decode references and normalize line ends in [first, last)
+                // in place. In attribute values all white space characters
+                // are replaced by spaces. Returns the new end of the data.
+                char* decode(char* first, char* last, bool attribute) const {
+                    char* out = first;
+                    while (first != last) {
+                        const char c = *first;
+                        if (c == '&') {
+                            const auto* semicolon = static_cast<const char*>(std::memchr(first, ';', static_cast<std::size_t>(last - first)));
+                            if (!semicolon) {
+                                error("invalid reference");
+                            }
+                            out = decode_reference(first + 1, semicolon, out);
+                            first += semicolon - first + 1;
+                        } else if (c == '\r') {
+                            *out++ = attribute ? ' ' : '\n';
+                            ++first;
+                            if (first != last && *first == '\n') {
+                                ++first;
+                            }
+                        } else if (attribute && (c == '\n' || c == '\t')) {
+                            *out++ = ' ';
+                            ++first;
+                        } else if (c == '<') {
+                            error("invalid '<' in attribute value");
+                        } else {
+                            *out++ = c;
+                            ++first;
+                        }
+                    }
+                    return out;
+                }
+
+                static char* find(char* first, char* last, const char* str) noexcept {
+                    const auto* end = str + std::strlen(str);
+                    auto* pos = std::search(first, last, str, end);
+                    return pos == last ? nullptr : pos;
+                }
+
+                void text(char* first, char* last) {
+                    if (m_depth == 0) {
+                        if (!std::all_of(first, last, xml_is_space)) {
+                            error("text outside of document element");
+                        }
+                        return;
+                    }
+                    char* const end = decode(first, last, false);
+                    if (end != first) {
+                        m_handler.characters(first, static_cast<int>(end - first));
+                    }
+                }
+
+                void start_tag(char* first, char* last) {
+                    char* pos = first + 1;
+                    while (pos != last && !xml_is_space(*pos) && *pos != '/') {
+                        ++pos;
+                    }
+                    char* const name_end = pos;
+                    if (name_end == first + 1) {
+                        error("invalid element name");
+                    }
+
+                    bool empty_element = false;
+                    m_attrs.clear();
+                    while (true) {
+                        while (pos != last && xml_is_space(*pos)) {
+                            ++pos;
+                        }
+                        if (pos == last) {
+                            break;
+                        }
+                        if (*pos == '/') {
+                            if (pos + 1 != last) {
+                                error("invalid '/' in element");
+                            }
+                            empty_element = true;
+                            break;
+                        }
+
+                        char* const attr_name = pos;
+                        while (pos != last && *pos != '=' && !xml_is_space(*pos)) {
+                            ++pos;
+                        }
+                        char* const attr_name_end = pos;
+                        while (pos != last && xml_is_space(*pos)) {
+                            ++pos;
+                        }
+                        if (pos == last || *pos != '=') {
+                            error("attribute without value");
+                        }
+                        ++pos;
+                        while (pos != last && xml_is_space(*pos)) {
+                            ++pos;
+                        }
+                        if (pos == last || (*pos != '"' && *pos != '\'')) {
+                            error("attribute value must be quoted");
+                        }
+                        char* const value = pos + 1;
+                        auto* value_end = static_cast<char*>(std::memchr(value, *pos, static_cast<std::size_t>(last - value)));
+                        if (!value_end) {
+                            error("unterminated attribute value");
+                        }
+                        pos = value_end + 1;
+                        if (pos != last && !xml_is_space(*pos) && *pos != '/') {
+                            error("missing space between attributes");
+                        }
+
+                        *attr_name_end = '\0';
+                        *decode(value, value_end, true) = '\0';
+                        m_attrs.push_back(attr_name);
+                        m_attrs.push_back(value);
+                    }
+                    m_attrs.push_back(nullptr);
+                    *name_end = '\0';
+
+                    const char* const name = first + 1;
+                    if (m_depth == 0 && m_root_done) {
+                        error("junk after document element");
+                    }
+                    m_handler.start_element(name, m_attrs.data());
+
+                    if (empty_element) {
+                        m_handler.end_element(name);
+                        m_root_done = m_depth == 0;
+                        return;
+                    }
+
+                    if (m_depth == m_open_elements.size()) {
+                        m_open_elements.emplace_back(name);
+                    } else {
+                        m_open_elements[m_depth].assign(name);
+                    }
+                    ++m_depth;
+                }
+
+                void end_tag(char* first, char* last) {
+                    char* const name = first + 2;
+                    char* pos = name;
+                    while (pos != last && !xml_is_space(*pos)) {
+                        ++pos;
+                    }
+                    char* const name_end = pos;
+                    while (pos != last && xml_is_space(*pos)) {
+                        ++pos;
+                    }
+                    if (pos != last) {
+                        error("invalid end tag");
+                    }
+                    if (m_depth == 0) {
+                        error("end tag without start tag");
+                    }
+                    const auto& open = m_open_elements[m_depth - 1];
+                    if (open.size() != static_cast<std::size_t>(name_end - name) ||
+                        std::memcmp(open.data(), name, open.size()) != 0) {
+                        error("mismatched tag");
+                    }
+                    *name_end = '\0';
+                    m_handler.end_element(name);
+                    --m_depth;
+                    m_root_done = m_depth == 0;
+                }
+
+                // Handle comments, CDATA sections, processing instructions,
+                // and the document type declaration. Returns the position
+                // of the last character of the markup or nullptr if it is
+                // not complete.
+                char* special_markup(char* first, char* last) {
+                    char* end = nullptr;
+                    if (first[1] == '?') {
+                        end = find(first + 2, last, "?>");
+                        return end ? end + 1 : nullptr;
+                    }
+
+                    if (!std::strncmp(first, "<!--", 4)) {
+                        end = find(first + 4, last, "-->");
+                        return end ? end + 2 : nullptr;
+                    }
+
+                    if (!std::strncmp(first, "<![CDATA[", 9)) {
+                        end = find(first + 9, last, "]]>");
+                        if (!end) {
+                            return nullptr;
+                        }
+                        if (m_depth == 0) {
+                            error("CDATA section outside of document element");
+                        }
+                        if (end != first + 9) {
+                            m_handler.characters(first + 9, static_cast<int>(end - first - 9));
+                        }
+                        return end + 2;
+                    }
+
+                    if (!std::strncmp(first, "<!DOCTYPE", 9)) {
+                        end = xml_find_tag_end(first, last);
+                        if (end && std::find(first, end, '[') != end) {
+                            error("DTDs are not supported");
+                        }
+                        return end;
+                    }
+
+                    error("invalid markup");
+                }
+
+                // Parse everything in [first, last) that is complete.
+                // Returns the position of the first character that was
+                // not parsed.
+                char* scan(char* first, char* last, bool eof) {
+                    while (first != last) {
+                        if (*first != '<') {
+                            auto* lt = static_cast<char*>(std::memchr(first, '<', static_cast<std::size_t>(last - first)));
+                            if (!lt) {
+                                if (!eof) {
+                                    return first;
+                                }
+                                lt = last;
+                            }
+                            const auto lines = std::count(first, lt, '\n');
+                            text(first, lt);
+                            m_line += static_cast<uint64_t>(lines);
+                            first = lt;
+                            continue;
+                        }
+
+                        // Not enough data to find out what kind of markup
+                        // this is.
+                        if (!eof && last - first < 9) {
+                            return first;
+                        }
+
+                        if (first[1] == '!' || first[1] == '?') {
+                            char* const end = special_markup(first, last);
+                            if (!end) {
+                                return first;
+                            }
+                            m_line += static_cast<uint64_t>(std::count(first, end, '\n'));
+                            first = end + 1;
+                            continue;
+                        }
+
+                        char* const end = xml_find_tag_end(first, last);
+                        if (!end) {
+                            return first;
+                        }
+                        const auto lines = std::count(first, end, '\n');
+                        if (first[1] == '/') {
+                            end_tag(first, end);
+                        } else {
+                            start_tag(first, end);
+                        }
+                        m_line += static_cast<uint64_t>(lines);
+                        first = end + 1;
+                    }
+
+                    return first;
+                }
+
             public:
 
-                explicit XMLParser(parser_arguments& args) :
-                    ParserWithBuffer(args) {
+                explicit XMLScanner(THandler& handler, uint64_t first_line = 1) :
+                    m_handler(handler),
+                    m_line(first_line) {
                 }
 
-                XMLParser(const XMLParser&) = delete;
-                XMLParser& operator=(const XMLParser&) = delete;
+                /**
+                 * Parse the next piece of input data.
+                 *
+                 * @param data The data.
+                 * @param last Set this to true for the last piece.
+                 * @throws osmium::xml_error If the data is not well-formed.
+                 */
+                void operator()(std::string data, bool last) {
+                    std::string input;
+                    if (m_rest.empty()) {
+                        input.swap(data);
+                    } else {
+                        m_rest.append(data);
+                        input.swap(m_rest);
+                    }
 
-                XMLParser(XMLParser&&) = delete;
-                XMLParser& operator=(XMLParser&&) = delete;
+                    char* const first = &input[0];
+                    char* const end = first + input.size();
+                    char* const pos = scan(first, end, last);
 
-                ~XMLParser() noexcept override = default;
+                    if (!last) {
+                        m_rest.assign(pos, end);
+                        return;
+                    }
 
-                void run() override {
-                    osmium::thread::set_thread_name("_osmium_xml_in");
+                    if (pos != end) {
+                        error("unclosed token");
+                    }
+                    if (m_depth > 0) {
+                        error("missing end tag for element <" + m_open_elements[m_depth - 1] + ">");
+                    }
+                    if (!m_root_done) {
+                        error("no element found");
+                    }
+                }
+
+                /**
+                 * Check that the input given so far ends between two
+                 * OSM objects: Everything except white space has been
+                 * parsed and exactly depth elements are still open. This
+                 * is used at the end of chunks that are not the last one.
+                 *
+                 * @param depth The number of enclosing elements open at
+                 *              the end of the chunk.
+                 * @throws osmium::xml_error If the chunk is incomplete.
+                 */
+                void end_of_chunk(std::size_t depth) const {
+                    if (!std::all_of(m_rest.cbegin(), m_rest.cend(), xml_is_space)) {
+                        error("unclosed token");
+                    }
+                    if (m_depth > depth) {
+                        error("missing end tag for element <" + m_open_elements[m_depth - 1] + ">");
+                    }
+                    if (m_depth < depth) {
+                        error("mismatched tag");
+                    }
+                }
+
+            }; // class XMLScanner
+
+            /**
+             * Finds places where OSM XML data can be cut into chunks that
+             * can be parsed independently: the start tags of nodes, ways,
+             * relations, and changesets. It only looks at the beginning of
+             * each tag and keeps track of the elements enclosing the OSM
+             * objects (the root element and the create, modify, and delete
+             * sections in change files). A chunk can then be parsed on its
+             * own after the start tags of those elements returned by
+             * prefix().
+             */
+            class XMLChunkFinder {
+
+                std::vector<std::string> m_open_elements;
+                std::size_t m_pos = 0;
+
+                static bool is_enclosing_element(const char* first, const char* last) noexcept {
+                    return xml_name_is(first, last, "osm") ||
+                           xml_name_is(first, last, "osmChange") ||
+                           xml_name_is(first, last, "create") ||
+                           xml_name_is(first, last, "modify") ||
+                           xml_name_is(first, last, "delete");
+                }
+
+                static bool is_object_element(const char* first, const char* last) noexcept {
+                    return xml_name_is(first, last, "node") ||
+                           xml_name_is(first, last, "way") ||
+                           xml_name_is(first, last, "relation") ||
+                           xml_name_is(first, last, "changeset");
+                }
+
+                static const char* name_end(const char* first, const char* last) noexcept {
+                    while (first != last && !xml_is_space(*first) && *first != '>' && *first != '/') {
+                        ++first;
+                    }
+                    return first;
+                }
+
+            public:
+
+                /**
+                 * Find the start tag of the next OSM object in the data
+                 * at or after min_pos. The search continues where the last
+                 * one ended.
+                 *
+                 * @param data The data.
+                 * @param min_pos Ignore objects before this position.
+                 * @param last Is this all the data there is?
+                 * @returns The position of the start tag or std::string::npos
+                 *          if more data is needed to find it.
+                 */
+                std::size_t find(const std::string& data, std::size_t min_pos, bool last) {
+                    const char* const begin = data.data();
+                    const char* const end = begin + data.size();
+
+                    while (true) {
+                        const auto lt = data.find('<', m_pos);
+                        if (lt == std::string::npos) {
+                            m_pos = data.size();
+                            return std::string::npos;
+                        }
+                        m_pos = lt;
+                        if (!last && data.size() - lt < 16) {
+                            return std::string::npos;
+                        }
+
+                        const char* const tag = begin + lt;
+                        std::size_t next = std::string::npos;
+                        if (!data.compare(lt, 4, "<!--")) {
+                            next = data.find("-->", lt + 4);
+                        } else if (!data.compare(lt, 9, "<![CDATA[")) {
+                            next = data.find("]]>", lt + 9);
+                        } else if (!data.compare(lt, 2, "<?")) {
+                            next = data.find("?>", lt + 2);
+                        } else if (!data.compare(lt, 2, "<!")) {
+                            next = data.find('>', lt + 2);
+                        } else if (!data.compare(lt, 2, "</")) {
+                            const char* const name = tag + 2;
+                            const char* const ne = name_end(name, end);
+                            if (!m_open_elements.empty() && is_enclosing_element(name, ne)) {
+                                m_open_elements.pop_back();
+                            }
+                            next = lt + 1;
+                        } else {
+                            const char* const name = tag + 1;
+                            const char* const ne = name_end(name, end);
+                            if (is_object_element(name, ne)) {
+                                if (lt >= min_pos && !m_open_elements.empty()) {
+                                    return lt;
+                                }
+                            } else if (is_enclosing_element(name, ne)) {
+                                const char* const tag_end = xml_find_tag_end(ne, end);
+                                if (!tag_end) {
+                                    return std::string::npos;
+                                }
+                                if (tag_end[-1] != '/') {
+                                    m_open_elements.emplace_back(name, ne);
+                                }
+                            }
+                            next = lt + 1;
+                        }
+
+                        if (next == std::string::npos) {
+                            return std::string::npos;
+                        }
+                        m_pos = next + 1;
+                    }
+                }
+
+                /**
+                 * The number of elements enclosing the OSM objects at the
+                 * current position.
+                 */
+                std::size_t depth() const noexcept {
+                    return m_open_elements.size();
+                }
+
+                /**
+                 * Tell the chunk finder that the first num bytes of the
+                 * data have been removed.
+                 */
+                void remove_first(std::size_t num) noexcept {
+                    m_pos -= num;
+                }
+
+                /**
+                 * The start tags of the elements enclosing the OSM objects
+                 * at the current position.
+                 */
+                std::string prefix() const {
+                    std::string result;
+                    for (const auto& name : m_open_elements) {
+                        result += '<';
+                        result += name;
+                        if (name == "osm" || name == "osmChange") {
+                            result += " version=\"0.6\"";
+                        }
+                        result += '>';
+                    }
+                    return result;
+                }
+
+            }; // class XMLChunkFinder
+
+            class XMLParser final : public ParserWithBuffer {
 
+                friend class XMLElementHandler<XMLParser>;
+
+                enum {
+                    parallel_chunk_size = 1024UL * 1024UL
+                };
+
+                using chunk_result_type = std::vector<osmium::memory::Buffer>;
+
+                // Output for the XMLElementHandler when parsing chunks on
+                // the thread pool. The header is only read in the parser
+                // thread, so it is ignored here.
+                class ChunkOutput : public ChunkBuffers {
+
+                public:
+
+                    using ChunkBuffers::ChunkBuffers;
+
+                    void set_header_value(const osmium::io::Header& /*header*/) noexcept {
+                    }
+
+                }; // class ChunkOutput
+
+                /**
+                 * A C++ wrapper for the Expat parser that makes sure no memory
+                 * is leaked.
+                 */
+                class ExpatXMLParser {
+
+                    XML_Parser m_parser;
+                    std::exception_ptr m_exception_ptr{}; // NOLINT(bugprone-throw-keyword-missing) see https://bugs.llvm.org/show_bug.cgi?id=52400
+
+                    template <typename TFunc>
+                    void member_wrap(XMLParser& xml_parser, TFunc&& func) noexcept {
+                        if (m_exception_ptr) {
+                            return;
+                        }
+                        try {
+                            std::forward<TFunc>(func)(xml_parser);
+                        } catch (...) {
+                            m_exception_ptr = std::current_exception();
+                            XML_StopParser(m_parser, 0);
+                        }
+                    }
+
+                    template <typename TFunc>
+                    static void wrap(void* data, TFunc&& func) noexcept {
+                        assert(data);
+                        auto& xml_parser = *static_cast<XMLParser*>(data);
+                        xml_parser.m_expat_xml_parser->member_wrap(xml_parser, std::forward<TFunc>(func));
+                    }
+
+                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) noexcept {
+                        wrap(data, [&](XMLParser& xml_parser) {
+                            xml_parser.m_handler.start_element(element, attrs);
+                        });
+                    }
+
+                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) noexcept {
+                        wrap(data, [&](XMLParser& xml_parser) {
+                            xml_parser.m_handler.end_element(element);
+                        });
+                    }
+
+                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) noexcept {
+                        wrap(data, [&](XMLParser& xml_parser) {
+                            xml_parser.m_handler.characters(text, len);
+                        });
+                    }
+
+                    // This handler is called when there are any XML entities
+                    // declared in the OSM file. Entities are normally not used,
+                    // but they can be misused. See
+                    // https://en.wikipedia.org/wiki/Billion_laughs
+                    // The handler will just throw an error.
+                    static void entity_declaration_handler(void* data,
+                            const XML_Char* /*entityName*/,
+                            int /*is_parameter_entity*/,
+                            const XML_Char* /*value*/,
+                            int /*value_length*/,
+                            const XML_Char* /*base*/,
+                            const XML_Char* /*systemId*/,
+                            const XML_Char* /*publicId*/,
+                            const XML_Char* /*notationName*/) noexcept {
+                        wrap(data, [&](XMLParser& /*xml_parser*/) {
+                            throw osmium::xml_error{"XML entities are not supported"};
+                        });
+                    }
+
+                public:
+
+                    explicit ExpatXMLParser(void* callback_object) :
+                        m_parser(XML_ParserCreate(nullptr)) {
+                        if (!m_parser) {
+                            throw osmium::io_error{"Internal error: Can not create parser"};
+                        }
+                        XML_SetUserData(m_parser, callback_object);
+                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
+                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
+                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
+                    }
+
+                    ExpatXMLParser(const ExpatXMLParser&) = delete;
+                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
+
+                    ExpatXMLParser(ExpatXMLParser&&) = delete;
+                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
+
+                    ~ExpatXMLParser() noexcept {
+                        XML_ParserFree(m_parser);
+                    }
+
+                    void operator()(const std::string& data, bool last) {
+                        assert(data.size() < std::numeric_limits<int>::max());
+                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
+                            if (m_exception_ptr) {
+                                std::rethrow_exception(m_exception_ptr);
+                            }
+                            throw osmium::xml_error{m_parser};
+                        }
+                    }
+
+                }; // class ExpatXMLParser
+
+                ExpatXMLParser* m_expat_xml_parser{nullptr};
+
+                XMLElementHandler<XMLParser> m_handler;
+
+                std::deque<std::future<chunk_result_type>> m_pending;
+                std::size_t m_max_pending = 0;
+
+                bool m_use_scanner;
+                bool m_parallel_parsing;
+
+                void mark_header_as_done() {
+                    set_header_value(m_handler.header());
+                }
+
+                void parse_with_expat() {
                     ExpatXMLParser parser{this};
                     m_expat_xml_parser = &parser;
 
@@ -774,13 +1515,162 @@ namespace osmium {
                         }
                     }
 
-                    mark_header_as_done();
-                    flush_final_buffer();
-
                     // so we don't have a dangling link to local parser variable
                     m_expat_xml_parser = nullptr;
                 }
 
+                void parse_with_scanner() {
+                    XMLScanner<XMLElementHandler<XMLParser>> scanner{m_handler};
+
+                    while (!input_done()) {
+                        std::string data{get_input()};
+                        scanner(std::move(data), input_done());
+                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
+                            break;
+                        }
+                    }
+                }
+
+                // Wait for the oldest chunk to be parsed and send its
+                // buffers on in input order.
+                void send_oldest_chunk() {
+                    auto buffers = m_pending.front().get();
+                    m_pending.pop_front();
+                    for (auto& buffer : buffers) {
+                        send_to_output_queue(std::move(buffer));
+                    }
+                }
+
+                // Parse a chunk of data on the thread pool. The prefix
+                // contains the start tags of the enclosing elements. All
+                // chunks but the last must end with end_depth enclosing
+                // elements open, otherwise an object in it is incomplete.
+                void submit_chunk(std::string&& data, std::string&& prefix, uint64_t first_line, bool last, std::size_t end_depth = 0) {
+                    const auto types = read_types();
+                    const auto kind = buffers_kind();
+                    const auto chunk = std::make_shared<std::pair<std::string, std::string>>(std::move(prefix), std::move(data));
+                    m_pending.push_back(get_pool().submit([chunk, first_line, last, end_depth, types, kind] {
+                        ChunkOutput output{kind};
+                        XMLElementHandler<ChunkOutput> handler{output, types};
+                        XMLScanner<XMLElementHandler<ChunkOutput>> scanner{handler, first_line};
+                        scanner(std::move(chunk->first), false);
+                        scanner(std::move(chunk->second), last);
+                        if (!last) {
+                            scanner.end_of_chunk(end_depth);
+                        }
+                        return output.get_buffers();
+                    }));
+
+                    while (m_pending.size() > m_max_pending) {
+                        send_oldest_chunk();
+                    }
+                }
+
+                // Read the data up to the first OSM object with the scanner
+                // in this thread, then cut the rest into chunks at object
+                // boundaries which are parsed on the thread pool.
+                void parse_in_parallel() {
+                    m_max_pending = 2 * static_cast<std::size_t>(get_pool().num_threads()) + 1;
+
+                    XMLChunkFinder finder;
+                    std::string data;
+                    bool eof = false;
+
+                    auto get_more_input = [&]() {
+                        std::string input{get_input()};
+                        if (data.empty()) {
+                            data = std::move(input);
+                        } else {
+                            data.append(input);
+                        }
+                        eof = input_done();
+                    };
+
+                    std::size_t first_object = std::string::npos;
+                    while (!eof) {
+                        get_more_input();
+                        first_object = finder.find(data, 0, eof);
+                        if (first_object != std::string::npos) {
+                            break;
+                        }
+                    }
+
+                    XMLScanner<XMLElementHandler<XMLParser>> scanner{m_handler};
+                    if (first_object == std::string::npos) {
+                        scanner(std::move(data), true);
+                        return;
+                    }
+
+                    uint64_t line = 1 + static_cast<uint64_t>(std::count(data.cbegin(), data.cbegin() + static_cast<std::ptrdiff_t>(first_object), '\n'));
+                    scanner(data.substr(0, first_object), false);
+                    scanner.end_of_chunk(finder.depth());
+                    mark_header_as_done();
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    data.erase(0, first_object);
+                    finder.remove_first(first_object);
+                    std::string prefix{finder.prefix()};
+
+                    while (true) {
+                        const auto cut = finder.find(data, parallel_chunk_size, eof);
+                        if (cut == std::string::npos) {
+                            if (!eof) {
+                                get_more_input();
+                                continue;
+                            }
+                            submit_chunk(std::move(data), std::move(prefix), line, true);
+                            break;
+                        }
+
+                        std::string rest{data, cut};
+                        data.resize(cut);
+                        const auto lines = static_cast<uint64_t>(std::count(data.cbegin(), data.cend(), '\n'));
+                        submit_chunk(std::move(data), std::move(prefix), line, false, finder.depth());
+                        line += lines;
+                        prefix = finder.prefix();
+                        data = std::move(rest);
+                        finder.remove_first(cut);
+                    }
+
+                    while (!m_pending.empty()) {
+                        send_oldest_chunk();
+                    }
+                }
+
+            public:
+
+                explicit XMLParser(parser_arguments& args) :
+                    ParserWithBuffer(args),
+                    m_handler(*this, args.read_which_entities),
+                    m_use_scanner(args.use_xml_scanner),
+                    m_parallel_parsing(args.parallel_parsing) {
+                }
+
+                XMLParser(const XMLParser&) = delete;
+                XMLParser& operator=(const XMLParser&) = delete;
+
+                XMLParser(XMLParser&&) = delete;
+                XMLParser& operator=(XMLParser&&) = delete;
+
+                ~XMLParser() noexcept override = default;
+
+                void run() override {
+                    osmium::thread::set_thread_name("_osmium_xml_in");
+
+                    if (m_parallel_parsing) {
+                        parse_in_parallel();
+                    } else if (m_use_scanner) {
+                        parse_with_scanner();
+                    } else {
+                        parse_with_expat();
+                    }
+
+                    mark_header_as_done();
+                    flush_final_buffer();
+                }
+
             }; // class XMLParser
 
             // we want the register_parser() function to run, setting
@@ -245,13 +245,14 @@ namespace osmium {
 
             public:
 
-                XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
                     m_options(options) {
                 }
 
                 std::string operator()() {
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
 
                     if (m_options.use_change_ops) {
                         open_close_op_tag();
@@ -464,7 +465,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options, buffer_pool()}));
                 }
 
                 void write_end() final {
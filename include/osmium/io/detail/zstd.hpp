@@ -0,0 +1,137 @@
+#ifndef OSMIUM_IO_DETAIL_ZSTD_HPP
+#define OSMIUM_IO_DETAIL_ZSTD_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifdef OSMIUM_WITH_ZSTD
+
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <osmium/io/error.hpp>
+
+#include <protozero/version.hpp>
+
+#if PROTOZERO_VERSION_CODE >= 10600
+# include <protozero/data_view.hpp>
+#else
+# include <protozero/types.hpp>
+#endif
+
+#include <zstd.h>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            constexpr int zstd_default_compression_level() noexcept {
+                return ZSTD_CLEVEL_DEFAULT;
+            }
+
+            inline void zstd_check_compression_level(int value) {
+                if (value < 1 || value > ::ZSTD_maxCLevel()) {
+                    throw std::invalid_argument{"The 'pbf_compression_level' for zstd compression must be between 1 and " +
+                                                std::to_string(::ZSTD_maxCLevel()) + "."};
+                }
+            }
+
+            /**
+             * Compress data using zstd.
+             *
+             * @param input Data to compress.
+             * @param compression_level Compression level.
+             * @returns Compressed data.
+             */
+            inline std::string zstd_compress(const std::string& input, int compression_level = zstd_default_compression_level()) {
+                const std::size_t output_size = ::ZSTD_compressBound(input.size());
+
+                std::string output(output_size, '\0');
+
+                const std::size_t result = ::ZSTD_compress(
+                    &*output.begin(),
+                    output_size,
+                    input.data(),
+                    input.size(),
+                    compression_level);
+
+                if (::ZSTD_isError(result)) {
+                    throw io_error{std::string{"zstd compression failed: "} + ::ZSTD_getErrorName(result)};
+                }
+
+                output.resize(result);
+
+                return output;
+            }
+
+            /**
+             * Uncompress data using zstd.
+             *
+             * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view zstd_uncompress_string(const char* input, std::size_t input_size, std::size_t raw_size, std::string& output) {
+                output.resize(raw_size);
+
+                const std::size_t result = ::ZSTD_decompress(
+                    &*output.begin(),
+                    raw_size,
+                    input,
+                    input_size);
+
+                if (::ZSTD_isError(result)) {
+                    throw io_error{std::string{"zstd decompression failed: "} + ::ZSTD_getErrorName(result)};
+                }
+
+                if (result != raw_size) {
+                    throw io_error{"zstd decompression failed: data size does not match"};
+                }
+
+                return protozero::data_view{output.data(), output.size()};
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif
+
+#endif // OSMIUM_IO_DETAIL_ZSTD_HPP
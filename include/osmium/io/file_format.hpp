@@ -62,6 +62,11 @@ namespace osmium {
             single = 1
         };
 
+        enum class use_mmap {
+            no  = 0,
+            yes = 1
+        };
+
         inline const char* as_string(const file_format format) noexcept {
             switch (format) {
                 case file_format::xml:
@@ -43,6 +43,8 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/block_compressor.hpp>
+#include <osmium/io/detail/block_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
@@ -50,6 +52,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
@@ -100,6 +103,128 @@ namespace osmium {
                 throw osmium::gzip_error{error, error_code};
             }
 
+            /**
+             * Compress the input into a complete gzip stream (a "member"
+             * in gzip terminology). Several of these can be concatenated
+             * to form a valid gzip file.
+             */
+            inline std::string gzip_compress_member(const std::string& input, const int compression_level = Z_DEFAULT_COMPRESSION) {
+                assert(input.size() < std::numeric_limits<unsigned int>::max());
+
+                z_stream zstream{};
+                // 16 added to the window bits makes zlib write a gzip header
+                int result = deflateInit2(&zstream, compression_level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY); // NOLINT(hicpp-signed-bitwise)
+                if (result != Z_OK) {
+                    throw gzip_error{"gzip error: compression init failed", result};
+                }
+
+                std::string output(deflateBound(&zstream, static_cast<uLong>(input.size())), '\0');
+
+                zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(input.data()));
+                zstream.avail_in = static_cast<unsigned int>(input.size());
+                zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
+                zstream.avail_out = static_cast<unsigned int>(output.size());
+
+                result = deflate(&zstream, Z_FINISH);
+                const auto size = zstream.total_out;
+                deflateEnd(&zstream);
+
+                if (result != Z_STREAM_END) {
+                    throw gzip_error{"gzip error: compression failed", result};
+                }
+
+                output.resize(static_cast<std::size_t>(size));
+                return output;
+            }
+
+            /**
+             * Decompresses any number of gzip members in a row. Used by
+             * the BlockDecompressor.
+             */
+            class gzip_stream_inflater {
+
+                z_stream m_zstream;
+                bool m_at_stream_end = true;
+
+            public:
+
+                enum : std::size_t {
+                    header_size = 10
+                };
+
+                static bool is_stream_start(const char* data) noexcept {
+                    const auto* d = reinterpret_cast<const unsigned char*>(data);
+                    return d[0] == 0x1fU && d[1] == 0x8bU && d[2] == 8U && // magic and deflate method
+                           (d[3] & 0xe0U) == 0 &&                          // reserved flags not set
+                           (d[8] == 0 || d[8] == 2 || d[8] == 4) &&         // extra flags
+                           (d[9] <= 13U || d[9] == 255U);                   // operating system
+                }
+
+                [[noreturn]] static void throw_truncated_error() {
+                    throw gzip_error{"gzip error: unexpected end of file"};
+                }
+
+                gzip_stream_inflater() :
+                    m_zstream() {
+                    const int result = inflateInit2(&m_zstream, MAX_WBITS + 16); // NOLINT(hicpp-signed-bitwise)
+                    if (result != Z_OK) {
+                        throw gzip_error{"gzip error: decompression init failed", result};
+                    }
+                }
+
+                gzip_stream_inflater(const gzip_stream_inflater&) = delete;
+                gzip_stream_inflater& operator=(const gzip_stream_inflater&) = delete;
+
+                gzip_stream_inflater(gzip_stream_inflater&&) = delete;
+                gzip_stream_inflater& operator=(gzip_stream_inflater&&) = delete;
+
+                ~gzip_stream_inflater() noexcept {
+                    inflateEnd(&m_zstream);
+                }
+
+                void decompress(const char* data, const std::size_t size, std::string& output) {
+                    assert(size < std::numeric_limits<unsigned int>::max());
+                    m_zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                    m_zstream.avail_in = static_cast<unsigned int>(size);
+
+                    // Output buffer filled up, there might be more output
+                    // even if there is no input left.
+                    bool output_full = false;
+
+                    while (m_zstream.avail_in > 0 || output_full) {
+                        if (m_at_stream_end) {
+                            inflateReset(&m_zstream);
+                            m_at_stream_end = false;
+                        }
+
+                        const std::size_t old_size = output.size();
+                        const std::size_t chunk_size = std::max(static_cast<std::size_t>(m_zstream.avail_in) * 4, static_cast<std::size_t>(64UL * 1024UL));
+                        output.resize(old_size + chunk_size);
+                        m_zstream.next_out = reinterpret_cast<unsigned char*>(&output[old_size]);
+                        m_zstream.avail_out = static_cast<unsigned int>(chunk_size);
+
+                        const int result = inflate(&m_zstream, Z_NO_FLUSH);
+                        output_full = result == Z_OK && m_zstream.avail_out == 0;
+                        output.resize(old_size + chunk_size - m_zstream.avail_out);
+
+                        if (result == Z_STREAM_END) {
+                            m_at_stream_end = true;
+                        } else if (result != Z_OK && !(result == Z_BUF_ERROR && m_zstream.avail_in == 0)) {
+                            std::string message{"gzip error: inflate failed: "};
+                            if (m_zstream.msg) {
+                                message.append(m_zstream.msg);
+                            }
+                            throw gzip_error{message, result};
+                        }
+                    }
+                }
+
+                bool at_stream_end() const noexcept {
+                    return m_at_stream_end;
+                }
+
+            }; // class gzip_stream_inflater
+
         } // namespace detail
 
         class GzipCompressor final : public Compressor {
@@ -348,6 +473,30 @@ namespace osmium {
                 return registered_gzip_compression;
             }
 
+            const bool registered_gzip_block_compressor = osmium::io::CompressionFactory::instance().register_block_compressor(osmium::io::file_compression::gzip,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool, const std::size_t block_size) {
+                    return new osmium::io::detail::BlockCompressor{fd, sync, pool, block_size, [](const std::string& data) {
+                        return gzip_compress_member(data);
+                    }};
+                }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_gzip_block_compressor() noexcept {
+                return registered_gzip_block_compressor;
+            }
+
+            const bool registered_gzip_block_decompressor = osmium::io::CompressionFactory::instance().register_block_decompressor(osmium::io::file_compression::gzip,
+                [](const int fd, osmium::thread::Pool& pool) {
+                    return new osmium::io::detail::BlockDecompressor<gzip_stream_inflater>{fd, pool};
+                }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_gzip_block_decompressor() noexcept {
+                return registered_gzip_block_decompressor;
+            }
+
         } // namespace detail
 
     } // namespace io
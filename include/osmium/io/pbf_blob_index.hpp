@@ -0,0 +1,389 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to create or use an index of the blobs
+ * in an OSM PBF file.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`.
+ */
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/util/file.hpp>
+
+#include <protozero/types.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Information about one OSMData blob in a PBF file.
+         */
+        struct pbf_blob_info {
+
+            /// Offset of the Blob (not the BlobHeader) in the file.
+            std::uint64_t offset = 0;
+
+            /// Size of the Blob in bytes.
+            std::uint32_t size = 0;
+
+            /// Entity types in this blob (osmium::osm_entity_bits::type).
+            std::uint32_t types = osmium::osm_entity_bits::all;
+
+            /// Bounding box of the nodes in this blob (invalid if unknown).
+            osmium::Box bbox;
+
+            pbf_blob_info() noexcept = default;
+
+            pbf_blob_info(std::uint64_t blob_offset, std::uint32_t blob_size, osmium::osm_entity_bits::type blob_types = osmium::osm_entity_bits::all, const osmium::Box& blob_bbox = osmium::Box{}) noexcept :
+                offset(blob_offset),
+                size(blob_size),
+                types(blob_types),
+                bbox(blob_bbox) {
+            }
+
+            /// Entity types in this blob.
+            osmium::osm_entity_bits::type entity_bits() const noexcept {
+                return static_cast<osmium::osm_entity_bits::type>(types);
+            }
+
+        }; // struct pbf_blob_info
+
+        static_assert(sizeof(pbf_blob_info) == 32, "pbf_blob_info must be 32 bytes");
+
+        /**
+         * An index of all OSMData blobs in a PBF file. It contains the
+         * offset, size, and (optionally) the types of entities and the
+         * bounding box of the nodes for each blob.
+         *
+         * Create it with create_pbf_blob_index() or load it from a file
+         * written earlier with dump(). Give it to the osmium::io::Reader
+         * as an additional argument. The reader will then not walk the
+         * file sequentially but read the blobs in the pool threads in
+         * parallel. The data is still delivered in order. Blobs which
+         * don't contain any of the entity types the reader was asked for
+         * or, if the reader was given a bounding box, node blobs outside
+         * that box are not read at all.
+         *
+         * If you remove blobs from the front of the index (see
+         * remove_first()), the reader will start reading in the middle
+         * of the file. This can be used to restart processing.
+         */
+        class PBFBlobIndex {
+
+            static constexpr const char* magic() noexcept {
+                return "OSMPBFBI";
+            }
+
+            enum : std::uint32_t {
+                magic_size = 8,
+                format_version = 2
+            };
+
+            // Version 1 of the format didn't have the bounding boxes.
+            struct pbf_blob_info_v1 {
+                std::uint64_t offset;
+                std::uint32_t size;
+                std::uint32_t types;
+            }; // struct pbf_blob_info_v1
+
+            struct file_header {
+                std::array<char, magic_size> magic;
+                std::uint32_t version;
+                std::uint32_t record_size;
+                std::uint64_t file_size;
+                std::uint64_t count;
+            }; // struct file_header
+
+            std::vector<pbf_blob_info> m_blobs;
+            std::uint64_t m_file_size = 0;
+
+        public:
+
+            using const_iterator = std::vector<pbf_blob_info>::const_iterator;
+
+            PBFBlobIndex() = default;
+
+            /**
+             * Create an empty index for a file of the given size. The
+             * size is checked against the actual file when the index is
+             * used. Set to 0 to disable this check.
+             */
+            explicit PBFBlobIndex(std::uint64_t file_size) noexcept :
+                m_file_size(file_size) {
+            }
+
+            /// The size of the PBF file this index was created from.
+            std::uint64_t file_size() const noexcept {
+                return m_file_size;
+            }
+
+            /// The number of blobs in this index.
+            std::size_t size() const noexcept {
+                return m_blobs.size();
+            }
+
+            bool empty() const noexcept {
+                return m_blobs.empty();
+            }
+
+            const pbf_blob_info& operator[](std::size_t n) const noexcept {
+                return m_blobs[n];
+            }
+
+            const_iterator begin() const noexcept {
+                return m_blobs.cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_blobs.cend();
+            }
+
+            /// Add information about a blob to the end of the index.
+            void add(const pbf_blob_info& info) {
+                m_blobs.push_back(info);
+            }
+
+            /**
+             * Remove the first count blobs from the index. A reader using
+             * this index will then start reading at the blob that is now
+             * the first one in the index.
+             */
+            void remove_first(std::size_t count) {
+                if (count > m_blobs.size()) {
+                    count = m_blobs.size();
+                }
+                m_blobs.erase(m_blobs.begin(), m_blobs.begin() + static_cast<std::ptrdiff_t>(count));
+            }
+
+            /**
+             * Write the index to a file descriptor. The data is written in
+             * the byte order of the machine and can only be read on a
+             * machine with the same byte order.
+             *
+             * @throws std::system_error If the data could not be written.
+             */
+            void dump(int fd) const {
+                file_header header{};
+                std::memcpy(header.magic.data(), magic(), magic_size);
+                header.version = format_version;
+                header.record_size = sizeof(pbf_blob_info);
+                header.file_size = m_file_size;
+                header.count = m_blobs.size();
+
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_blobs.data()), sizeof(pbf_blob_info) * m_blobs.size());
+            }
+
+            /**
+             * Read an index from a file descriptor. The data must have
+             * been written with dump(). Files written by older versions
+             * of this class (without bounding boxes) can also be read.
+             *
+             * @throws osmium::pbf_error If the data is not a blob index.
+             * @throws std::system_error If the data could not be read.
+             */
+            void load(int fd) {
+                file_header header{};
+                if (!osmium::io::detail::read_exactly(fd, reinterpret_cast<char*>(&header), sizeof(header)) ||
+                    std::memcmp(header.magic.data(), magic(), magic_size) != 0) {
+                    throw osmium::pbf_error{"not a PBF blob index file"};
+                }
+                if (header.version == 1 && header.record_size == sizeof(pbf_blob_info_v1)) {
+                    std::vector<pbf_blob_info_v1> blobs_v1(header.count);
+                    const std::size_t bytes = sizeof(pbf_blob_info_v1) * blobs_v1.size();
+                    if (!osmium::io::detail::read_exactly(fd, reinterpret_cast<char*>(blobs_v1.data()), static_cast<unsigned int>(bytes))) {
+                        throw osmium::pbf_error{"truncated PBF blob index file"};
+                    }
+
+                    m_file_size = header.file_size;
+                    m_blobs.clear();
+                    m_blobs.reserve(blobs_v1.size());
+                    for (const auto& blob : blobs_v1) {
+                        m_blobs.emplace_back(blob.offset, blob.size, static_cast<osmium::osm_entity_bits::type>(blob.types));
+                    }
+                    return;
+                }
+
+                if (header.version != format_version || header.record_size != sizeof(pbf_blob_info)) {
+                    throw osmium::pbf_error{"unsupported PBF blob index format version"};
+                }
+
+                std::vector<pbf_blob_info> blobs(header.count);
+                const std::size_t bytes = sizeof(pbf_blob_info) * blobs.size();
+                if (!osmium::io::detail::read_exactly(fd, reinterpret_cast<char*>(blobs.data()), static_cast<unsigned int>(bytes))) {
+                    throw osmium::pbf_error{"truncated PBF blob index file"};
+                }
+
+                m_file_size = header.file_size;
+                m_blobs = std::move(blobs);
+            }
+
+        }; // class PBFBlobIndex
+
+        namespace detail {
+
+            inline void read_exactly_or_throw(int fd, char* buffer, std::size_t size) {
+                if (!osmium::io::detail::read_exactly(fd, buffer, static_cast<unsigned int>(size))) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Create an index of the OSMData blobs in a PBF file by scanning
+         * the BlobHeaders. The file descriptor must be positioned at the
+         * beginning of the file and it must be seekable.
+         *
+         * If detect_types is false only the BlobHeaders are read and the
+         * data in between is skipped which is fast. The types of all blobs
+         * are set to osmium::osm_entity_bits::all in this case unless they
+         * are stored in the BlobHeaders (see the "pbf_indexdata" output
+         * option). If
+         * detect_types is true every blob is read and decompressed to find
+         * out which types of entities it contains. This is slower, so you
+         * probably want to do this only once and store the result with
+         * PBFBlobIndex::dump(). The bounding boxes of node blobs are only
+         * known if they are stored in the BlobHeaders.
+         *
+         * @param fd File descriptor of the PBF file.
+         * @param detect_types Find out which entity types are in each blob.
+         * @returns The index.
+         * @throws osmium::pbf_error If there was a problem with the file.
+         * @throws std::system_error If the file could not be read.
+         */
+        inline PBFBlobIndex create_pbf_blob_index(int fd, bool detect_types = false) {
+            PBFBlobIndex index{osmium::file_size(fd)};
+
+            std::string buffer;
+            std::uint64_t offset = 0;
+            bool header_done = false;
+
+            while (true) {
+                std::array<char, sizeof(std::uint32_t)> size_in_network_byte_order{};
+                if (!osmium::io::detail::read_exactly(fd, size_in_network_byte_order.data(), static_cast<unsigned int>(size_in_network_byte_order.size()))) {
+                    break; // EOF
+                }
+
+                const auto header_size = osmium::io::detail::get_size_in_network_byte_order(size_in_network_byte_order.data());
+                if (header_size > static_cast<std::uint32_t>(osmium::io::detail::max_blob_header_size)) {
+                    throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                }
+
+                buffer.resize(header_size);
+                detail::read_exactly_or_throw(fd, &*buffer.begin(), header_size);
+                osmium::io::detail::pbf_blob_indexdata indexdata;
+                const auto blob_size = osmium::io::detail::decode_blob_header(protozero::data_view{buffer.data(), buffer.size()}, header_done ? "OSMData" : "OSMHeader", &indexdata);
+                if (blob_size > osmium::io::detail::max_uncompressed_blob_size) {
+                    throw osmium::pbf_error{std::string{"invalid blob size: "} + std::to_string(blob_size)};
+                }
+
+                offset += sizeof(std::uint32_t) + header_size;
+
+                if (!header_done) {
+                    header_done = true;
+                    osmium::file_seek(fd, offset + blob_size);
+                } else if (indexdata.types != osmium::osm_entity_bits::all) {
+                    // types and bounding box are known from the BlobHeader
+                    index.add(pbf_blob_info{offset, static_cast<std::uint32_t>(blob_size), indexdata.types, indexdata.bbox});
+                    osmium::file_seek(fd, offset + blob_size);
+                } else if (detect_types) {
+                    buffer.resize(blob_size);
+                    detail::read_exactly_or_throw(fd, &*buffer.begin(), blob_size);
+                    std::string output;
+                    const auto types = osmium::io::detail::decode_primitive_block_types(osmium::io::detail::decode_blob(buffer, output));
+                    index.add(pbf_blob_info{offset, static_cast<std::uint32_t>(blob_size), types});
+                } else {
+                    index.add(pbf_blob_info{offset, static_cast<std::uint32_t>(blob_size)});
+                    osmium::file_seek(fd, offset + blob_size);
+                }
+
+                offset += blob_size;
+            }
+
+            if (offset != index.file_size()) {
+                throw osmium::pbf_error{"truncated data (EOF encountered)"};
+            }
+
+            return index;
+        }
+
+        /**
+         * Create an index of the OSMData blobs in a PBF file by scanning
+         * the BlobHeaders.
+         *
+         * @param filename Name of the PBF file.
+         * @param detect_types Find out which entity types are in each blob.
+         * @returns The index.
+         * @throws osmium::pbf_error If there was a problem with the file.
+         * @throws std::system_error If the file could not be opened or read.
+         *
+         * @see create_pbf_blob_index(int, bool)
+         */
+        inline PBFBlobIndex create_pbf_blob_index(const std::string& filename, bool detect_types = false) {
+            const int fd = osmium::io::detail::open_for_reading(filename);
+            PBFBlobIndex index;
+            try {
+                index = create_pbf_blob_index(fd, detect_types);
+            } catch (...) {
+                osmium::io::detail::reliable_close(fd);
+                throw;
+            }
+            osmium::io::detail::reliable_close(fd);
+            return index;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
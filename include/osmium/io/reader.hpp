@@ -42,6 +42,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
@@ -69,6 +71,8 @@ namespace osmium {
 
     namespace io {
 
+        class PBFBlobIndex;
+
         namespace detail {
 
             inline std::size_t get_input_queue_size() noexcept {
@@ -117,6 +121,8 @@ namespace osmium {
 
             std::size_t m_file_size = 0;
 
+            bool m_use_mmap = false;
+
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
             osmium::io::detail::ReadThreadManager m_read_thread_manager;
@@ -133,6 +139,12 @@ namespace osmium {
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
             osmium::io::buffers_type m_buffers_kind = osmium::io::buffers_type::any;
 
+            const osmium::io::PBFBlobIndex* m_pbf_blob_index = nullptr;
+
+            osmium::Box m_filter_box;
+
+            osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
             }
@@ -154,6 +166,69 @@ namespace osmium {
                 m_buffers_kind = value;
             }
 
+            void set_option(const osmium::io::PBFBlobIndex& index) noexcept {
+                m_pbf_blob_index = &index;
+            }
+
+            // The index must outlive the reader, so don't allow temporaries.
+            void set_option(const osmium::io::PBFBlobIndex&& index) = delete;
+
+            void set_option(const osmium::Box& box) noexcept {
+                m_filter_box = box;
+            }
+
+            void set_option(osmium::memory::BufferPool& buffer_pool) noexcept {
+                m_buffer_pool = &buffer_pool;
+            }
+
+            void set_option(osmium::io::use_mmap /*value*/) noexcept {
+                // Already handled in the constructor by wants_mmap(), because
+                // it must be known before the decompressor is set up.
+            }
+
+            static bool is_mmap_option(osmium::io::use_mmap value) noexcept {
+                return value == osmium::io::use_mmap::yes;
+            }
+
+            template <typename T>
+            static bool is_mmap_option(const T& /*value*/) noexcept {
+                return false;
+            }
+
+            template <typename... TArgs>
+            static bool wants_mmap(const TArgs&... args) noexcept {
+                bool result = false;
+                (void)std::initializer_list<int>{(result = result || is_mmap_option(args), 0)...};
+                return result;
+            }
+
+            static osmium::thread::Pool* pool_option(osmium::thread::Pool& pool) noexcept {
+                return &pool;
+            }
+
+            template <typename T>
+            static osmium::thread::Pool* pool_option(const T& /*value*/) noexcept {
+                return nullptr;
+            }
+
+            // The pool is needed by the decompressor which is created
+            // before the options are set.
+            template <typename... TArgs>
+            static osmium::thread::Pool& wanted_pool(TArgs&... args) noexcept {
+                osmium::thread::Pool* pool = nullptr;
+                (void)std::initializer_list<int>{(pool = pool ? pool : pool_option(args), 0)...};
+                return pool ? *pool : osmium::thread::Pool::default_instance();
+            }
+
+            // Memory mapping is only possible for uncompressed PBF and OPL
+            // files on disk. In all other cases the normal read path is used.
+            static bool can_use_mmap(const osmium::io::File& file, std::size_t file_size) noexcept {
+                return file_size > 0 &&
+                       !file.buffer() &&
+                       file.compression() == osmium::io::file_compression::none &&
+                       (file.format() == file_format::pbf || file.format() == file_format::opl);
+            }
+
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       int fd,
@@ -165,7 +240,13 @@ namespace osmium {
                                       osmium::osm_entity_bits::type read_which_entities,
                                       osmium::io::read_meta read_metadata,
                                       osmium::io::buffers_type buffers_kind,
-                                      bool want_buffered_pages_removed) {
+                                      bool want_buffered_pages_removed,
+                                      const osmium::io::PBFBlobIndex* pbf_blob_index,
+                                      bool use_mmap,
+                                      bool parallel_parsing,
+                                      bool use_xml_scanner,
+                                      const osmium::Box& filter_box,
+                                      osmium::memory::BufferPool* buffer_pool) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -178,6 +259,12 @@ namespace osmium {
                     read_metadata,
                     buffers_kind,
                     want_buffered_pages_removed};
+                args.pbf_blob_index = pbf_blob_index;
+                args.use_mmap = use_mmap;
+                args.parallel_parsing = parallel_parsing;
+                args.use_xml_scanner = use_xml_scanner;
+                args.filter_box = filter_box;
+                args.buffer_pool = buffer_pool;
                 creator(args)->parse();
             }
 
@@ -257,14 +344,16 @@ namespace osmium {
                 return fd;
             }
 
-            static std::unique_ptr<Decompressor> make_decompressor(const osmium::io::File& file, int fd, std::atomic<std::size_t>* offset_ptr) {
+            static std::unique_ptr<Decompressor> make_decompressor(const osmium::io::File& file, int fd, std::atomic<std::size_t>* offset_ptr, bool use_mmap, osmium::thread::Pool& pool) {
                 const auto& factory = osmium::io::CompressionFactory::instance();
                 std::unique_ptr<Decompressor> decompressor;
 
                 if (file.buffer()) {
                     decompressor = factory.create_decompressor(file.compression(), file.buffer(), file.buffer_size());
-                } else if (file.format() == file_format::pbf) {
+                } else if (file.format() == file_format::pbf || use_mmap) {
                     decompressor = std::unique_ptr<Decompressor>{new DummyDecompressor{}};
+                } else if (file.is_true("parallel_decompression")) {
+                    decompressor = factory.create_block_decompressor(file.compression(), fd, pool);
                 } else {
                     decompressor = factory.create_decompressor(file.compression(), fd);
                 }
@@ -312,6 +401,58 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * * const osmium::io::PBFBlobIndex&: Reference to an index of
+             *      the blobs in a PBF file (see osmium/io/pbf_blob_index.hpp).
+             *      If this is set, the blobs are read in parallel from the
+             *      pool threads instead of sequentially from the parser
+             *      thread. Only used for PBF files read from disk, not from
+             *      stdin or URLs. The index must stay alive as long as the
+             *      Reader.
+             *
+             * * osmium::io::use_mmap: Memory map the input file instead of
+             *      reading it (osmium::io::use_mmap::yes). The parser then
+             *      works directly on the mapped data without copying it
+             *      around. This only works for uncompressed PBF and OPL
+             *      files on disk. For all other inputs this setting is
+             *      ignored. The default is osmium::io::use_mmap::no.
+             *
+             * * const osmium::Box&: Only the nodes inside this bounding box
+             *      are needed. PBF blobs which only contain nodes and
+             *      which are known to lie completely outside the box are
+             *      skipped without reading or decompressing them. This
+             *      only works if the bounding boxes of the blobs are known,
+             *      either from the BlobHeaders (see the "pbf_indexdata"
+             *      output option) or from a PBFBlobIndex. It is only an
+             *      optimization: Nodes outside the box can still be
+             *      returned, all ways, relations, and changesets are always
+             *      returned, and for other file formats it is ignored.
+             *
+             * * osmium::memory::BufferPool&: Pool from which the buffers
+             *      for decoded data are taken. Currently only used for PBF
+             *      files. Hand the buffers you get from read() back to the
+             *      pool with BufferPool::put() when you don't need them any
+             *      more so that their memory can be reused. The pool must
+             *      stay alive as long as the Reader.
+             *
+             * If the file option "parallel_decompression" is set, gzip and
+             * bzip2 files made up of several compressed streams (like the
+             * ones written by pbzip2 or by the Writer with the
+             * "parallel_compression" option) are decompressed in parallel
+             * on the thread pool.
+             *
+             * If the file option "parallel_parsing" is set, OPL files are
+             * cut into chunks at line boundaries, XML files are cut into
+             * chunks at the start tags of OSM objects, and o5m files are
+             * cut into chunks at reset datasets. The chunks are parsed in
+             * parallel on the thread pool. The buffers are still returned
+             * in the order of the input.
+             *
+             * If the file option "xml_parser" is set to "scanner", XML files
+             * are read with a faster built-in parser instead of Expat. It
+             * does not support DTDs and only works with UTF-8 encoded
+             * files. It is always used when XML files are read with the
+             * "parallel_parsing" option.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -322,7 +463,8 @@ namespace osmium {
                 m_input_queue(detail::get_input_queue_size(), "raw_input"),
                 m_fd(m_file.buffer() ? -1 : open_input_file_or_url(m_file.filename(), &m_childpid)),
                 m_file_size(m_fd > 2 ? osmium::file_size(m_fd) : 0),
-                m_decompressor(make_decompressor(m_file, m_fd, &m_offset)),
+                m_use_mmap(can_use_mmap(m_file, m_file_size) && wants_mmap(args...)),
+                m_decompressor(make_decompressor(m_file, m_fd, &m_offset, m_use_mmap, wanted_pool(args...))),
                 m_read_thread_manager(*m_decompressor, m_input_queue),
                 m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
                 m_osmdata_queue_wrapper(m_osmdata_queue) {
@@ -346,7 +488,11 @@ namespace osmium {
                                                           std::ref(m_input_queue), std::ref(m_osmdata_queue),
                                                           std::move(header_promise), &m_offset, m_read_which_entities,
                                                           m_read_metadata, m_buffers_kind,
-                                                          m_decompressor->want_buffered_pages_removed()};
+                                                          m_decompressor->want_buffered_pages_removed(),
+                                                          m_pbf_blob_index, m_use_mmap,
+                                                          m_file.is_true("parallel_parsing"),
+                                                          m_file.get("xml_parser") == "scanner",
+                                                          m_filter_box, m_buffer_pool};
             }
 
             template <typename... TArgs>
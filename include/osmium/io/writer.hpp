@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/block_compressor.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/read_write.hpp>
@@ -43,6 +44,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/header.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
@@ -115,6 +117,8 @@ namespace osmium {
 
             size_t m_buffer_size = default_buffer_size;
 
+            osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
             std::future<std::size_t> m_write_future;
 
             osmium::thread::thread_handler m_thread;
@@ -161,9 +165,18 @@ namespace osmium {
                 }
                 if (buffer && buffer.committed() > 0) {
                     m_output->write_buffer(std::move(buffer));
+                } else if (m_buffer_pool) {
+                    m_buffer_pool->put(std::move(buffer));
                 }
             }
 
+            osmium::memory::Buffer new_buffer() {
+                if (m_buffer_pool) {
+                    return m_buffer_pool->get(m_buffer_size, osmium::memory::Buffer::auto_grow::no);
+                }
+                return osmium::memory::Buffer{m_buffer_size, osmium::memory::Buffer::auto_grow::no};
+            }
+
             void do_flush() {
                 if (!m_header_written) {
                     write_header();
@@ -172,8 +185,7 @@ namespace osmium {
                     osmium::thread::check_for_exception(m_write_future);
                 }
                 if (m_buffer && m_buffer.committed() > 0) {
-                    osmium::memory::Buffer buffer{m_buffer_size,
-                                                  osmium::memory::Buffer::auto_grow::no};
+                    osmium::memory::Buffer buffer{new_buffer()};
                     using std::swap;
                     swap(m_buffer, buffer);
 
@@ -202,12 +214,17 @@ namespace osmium {
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
                 osmium::thread::Pool* pool = nullptr;
+                osmium::memory::BufferPool* buffer_pool = nullptr;
             };
 
             static void set_option(options_type& options, osmium::thread::Pool& pool) {
                 options.pool = &pool;
             }
 
+            static void set_option(options_type& options, osmium::memory::BufferPool& buffer_pool) {
+                options.buffer_pool = &buffer_pool;
+            }
+
             static void set_option(options_type& options, const osmium::io::Header& header) {
                 options.header = header;
             }
@@ -260,8 +277,22 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * * osmium::memory::BufferPool&: Pool from which the internal
+             *      buffers of the writer are taken. All buffers, including
+             *      the ones you write, are handed back to it after their
+             *      contents have been written. The pool must stay alive as
+             *      long as the Writer.
+             *
+             * If the file option "parallel_compression" is set, gzip and
+             * bzip2 compressed output is split into blocks which are
+             * compressed in parallel on the thread pool. The size of those
+             * blocks can be set with the "compression_block_size" option
+             * (in bytes, default 1 MByte).
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
+             * @throws std::invalid_argument If the compression_block_size
+             *         option is invalid.
              */
             template <typename... TArgs>
             explicit Writer(const osmium::io::File& file, TArgs&&... args) :
@@ -277,12 +308,17 @@ namespace osmium {
 
                 m_header = options.header;
 
+                m_buffer_pool = options.buffer_pool;
                 m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
+                m_output->set_buffer_pool(m_buffer_pool);
+
+                const bool parallel_compression = m_file.is_true("parallel_compression");
+                const std::size_t compression_block_size = parallel_compression ? detail::get_compression_block_size(m_file) : 0;
 
-                std::unique_ptr<osmium::io::Compressor> compressor =
-                    CompressionFactory::instance().create_compressor(file.compression(),
-                                                                     osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
-                                                                     options.sync);
+                const int fd = osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite);
+                std::unique_ptr<osmium::io::Compressor> compressor = parallel_compression ?
+                    CompressionFactory::instance().create_block_compressor(file.compression(), fd, options.sync, *options.pool, compression_block_size) :
+                    CompressionFactory::instance().create_compressor(file.compression(), fd, options.sync);
 
                 std::promise<std::size_t> write_promise;
                 m_write_future = write_promise.get_future();
@@ -376,8 +412,7 @@ namespace osmium {
             void operator()(const osmium::memory::Item& item) {
                 ensure_cleanup([&]() {
                     if (!m_buffer) {
-                        m_buffer = osmium::memory::Buffer{m_buffer_size,
-                                                          osmium::memory::Buffer::auto_grow::no};
+                        m_buffer = new_buffer();
                     }
                     try {
                         m_buffer.push_back(item);
@@ -0,0 +1,266 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Statistics about the use of a BufferPool.
+         */
+        struct buffer_pool_stats {
+
+            /// Number of buffers requested with BufferPool::get().
+            std::uint64_t gets = 0;
+
+            /// Number of requests served with memory from the pool.
+            std::uint64_t hits = 0;
+
+            /// Number of buffers handed back with BufferPool::put().
+            std::uint64_t puts = 0;
+
+            /**
+             * Number of buffers handed back which were not kept, because
+             * the pool was full or the buffer didn't manage its own memory.
+             */
+            std::uint64_t dropped = 0;
+
+            /// Bytes allocated for requests that could not be served.
+            std::uint64_t allocated_bytes = 0;
+
+            /// Number of buffers currently in the pool.
+            std::size_t pooled_buffers = 0;
+
+            /// Bytes currently held in the pool.
+            std::size_t pooled_bytes = 0;
+
+            /// Maximum number of bytes ever held in the pool.
+            std::size_t peak_pooled_bytes = 0;
+
+            /// Fraction of requests served from the pool (0 if none).
+            double hit_rate() const noexcept {
+                return gets == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(gets);
+            }
+
+        }; // struct buffer_pool_stats
+
+        /**
+         * A thread-safe pool of buffer memory. Instead of freeing the
+         * memory of a Buffer that isn't needed any more, hand the buffer
+         * back with put(). The next call to get() that asks for a buffer
+         * of the same or a slightly smaller size will reuse that memory
+         * instead of allocating (and page faulting in) a new block.
+         *
+         * Only buffers with internal memory management can be recycled.
+         * The contents of recycled memory are not cleared.
+         *
+         * The pool keeps at most max_bytes bytes. Buffers handed back
+         * when the pool is full are freed.
+         *
+         * A pool can be given to the osmium::io::Reader and
+         * osmium::io::Writer as an option. They will then get their
+         * buffers from the pool and, in the case of the Writer, give them
+         * back after the data has been written. Buffers returned by the
+         * Reader can be handed back with put() when you are done with
+         * them. The pool must outlive the Reader or Writer using it.
+         */
+        class BufferPool {
+
+            enum : std::size_t {
+                default_max_bytes = 256UL * 1024UL * 1024UL
+            };
+
+            // Pooled memory blocks ordered by capacity.
+            std::multimap<std::size_t, std::unique_ptr<unsigned char[]>> m_blocks;
+
+            std::size_t m_max_bytes;
+
+            buffer_pool_stats m_stats;
+
+            mutable std::mutex m_mutex;
+
+            void add_block(std::unique_ptr<unsigned char[]>&& memory, std::size_t capacity) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                ++m_stats.puts;
+                if (m_stats.pooled_bytes + capacity > m_max_bytes) {
+                    ++m_stats.dropped;
+                    return;
+                }
+                m_blocks.emplace(capacity, std::move(memory));
+                ++m_stats.pooled_buffers;
+                m_stats.pooled_bytes += capacity;
+                if (m_stats.pooled_bytes > m_stats.peak_pooled_bytes) {
+                    m_stats.peak_pooled_bytes = m_stats.pooled_bytes;
+                }
+            }
+
+        public:
+
+            /**
+             * Create a buffer pool.
+             *
+             * @param max_bytes Maximum number of bytes kept in the pool.
+             */
+            explicit BufferPool(std::size_t max_bytes = default_max_bytes) noexcept :
+                m_max_bytes(max_bytes) {
+            }
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            BufferPool(BufferPool&&) = delete;
+            BufferPool& operator=(BufferPool&&) = delete;
+
+            ~BufferPool() noexcept = default;
+
+            /**
+             * Get an empty buffer with internal memory management and at
+             * least the given capacity. Memory from the pool is used if
+             * there is a block which is at least as large as needed, but
+             * not more than twice as large. Otherwise new memory is
+             * allocated.
+             *
+             * @param capacity The minimum capacity of the buffer.
+             * @param auto_grow Should the buffer automatically grow when
+             *                  it becomes too small?
+             */
+            Buffer get(std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                capacity = Buffer::calculate_capacity(capacity);
+
+                std::unique_ptr<unsigned char[]> memory;
+                std::size_t pooled_capacity = 0;
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    ++m_stats.gets;
+                    const auto it = m_blocks.lower_bound(capacity);
+                    if (it != m_blocks.end() && it->first / 2 <= capacity) {
+                        pooled_capacity = it->first;
+                        memory = std::move(it->second);
+                        m_blocks.erase(it);
+                        ++m_stats.hits;
+                        --m_stats.pooled_buffers;
+                        m_stats.pooled_bytes -= pooled_capacity;
+                    } else {
+                        m_stats.allocated_bytes += capacity;
+                    }
+                }
+
+                if (!memory) {
+                    return Buffer{capacity, auto_grow};
+                }
+
+                Buffer buffer{std::move(memory), pooled_capacity, 0};
+                buffer.m_auto_grow = auto_grow;
+                return buffer;
+            }
+
+            /**
+             * Hand a buffer back to the pool. Its memory (and the memory
+             * of any nested buffers) is kept for later use. The data in
+             * the buffer is lost. Buffers with external memory management
+             * and invalid buffers are ignored.
+             */
+            void put(Buffer&& buffer) {
+                if (!buffer) {
+                    return;
+                }
+
+                while (buffer.has_nested_buffers()) {
+                    put(std::move(*buffer.get_last_nested()));
+                }
+
+                if (!buffer.m_memory) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    ++m_stats.puts;
+                    ++m_stats.dropped;
+                    return;
+                }
+
+                const auto capacity = buffer.capacity();
+                add_block(std::move(buffer.m_memory), capacity);
+                buffer = Buffer{};
+            }
+
+            /**
+             * Wrap a buffer into a shared_ptr which hands it back to this
+             * pool when the last reference is gone. The pool must outlive
+             * all copies of the shared_ptr.
+             */
+            std::shared_ptr<Buffer> share(Buffer&& buffer) {
+                return std::shared_ptr<Buffer>{new Buffer{std::move(buffer)}, [this](Buffer* ptr) {
+                    try {
+                        put(std::move(*ptr));
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // The memory is freed instead of being recycled.
+                    }
+                    delete ptr;
+                }};
+            }
+
+            /// Free all memory held by the pool.
+            void clear() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_blocks.clear();
+                m_stats.pooled_buffers = 0;
+                m_stats.pooled_bytes = 0;
+            }
+
+            /// The maximum number of bytes kept in the pool.
+            std::size_t max_bytes() const noexcept {
+                return m_max_bytes;
+            }
+
+            /// Get a snapshot of the statistics of this pool.
+            buffer_pool_stats stats() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_stats;
+            }
+
+        }; // class BufferPool
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
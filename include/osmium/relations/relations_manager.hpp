@@ -442,6 +442,17 @@ namespace osmium {
             void after_relation(const osmium::Relation& /*relation*/) const noexcept {
             }
 
+            /**
+             * This method is called before the output buffer is flushed
+             * with flush_output() or read with read().
+             *
+             * Overwrite this method in a derived class if it creates its
+             * output asynchronously. It must add all outstanding output
+             * to the output buffer.
+             */
+            void complete_pending() const noexcept {
+            }
+
             TManager& derived() noexcept {
                 return *static_cast<TManager*>(this);
             }
@@ -467,6 +478,24 @@ namespace osmium {
                 m_handler_pass2(*this) {
             }
 
+            /**
+             * Flush the output buffer. Any output the derived class is still
+             * working on is added first.
+             */
+            void flush_output() {
+                derived().complete_pending();
+                RelationsManagerBase::flush_output();
+            }
+
+            /**
+             * Return the contents of the output buffer. Any output the
+             * derived class is still working on is added first.
+             */
+            osmium::memory::Buffer read() {
+                derived().complete_pending();
+                return RelationsManagerBase::read();
+            }
+
             /**
              * Return reference to second pass handler.
              */
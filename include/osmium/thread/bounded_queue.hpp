@@ -0,0 +1,354 @@
+#ifndef OSMIUM_THREAD_BOUNDED_QUEUE_HPP
+#define OSMIUM_THREAD_BOUNDED_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2026 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility> // IWYU pragma: keep
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A thread-safe queue with a fixed maximum size. It has the same
+         * interface as osmium::thread::Queue, but pushing and popping
+         * don't need a lock as long as the queue is neither full nor
+         * empty. The elements are stored in a ring buffer. Each slot has
+         * a sequence number that tells producers and consumers whether it
+         * is free or holds data (see "Bounded MPMC queue" by Dmitry
+         * Vyukov). Any number of threads can push and pop at the same
+         * time.
+         *
+         * A mutex and condition variables are only used when a thread
+         * has to wait because the queue is full or empty.
+         *
+         * T must be default constructible and move assignable.
+         */
+        template <typename T>
+        class BoundedQueue {
+
+            enum : std::size_t {
+                min_max_size = 2,
+                default_max_size = 64
+            };
+
+            struct slot {
+                std::atomic<std::size_t> sequence{0};
+                T value{};
+            };
+
+            /// Maximum size of this queue. If the queue is full pushing to
+            /// the queue will block.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            std::unique_ptr<slot[]> m_slots;
+
+            /// Position where the next element will be pushed.
+            std::atomic<std::size_t> m_push_pos{0};
+
+            /// Position where the next element will be popped from.
+            std::atomic<std::size_t> m_pop_pos{0};
+
+            /// Number of threads waiting in push() because the queue is full.
+            std::atomic<int> m_waiting_producers{0};
+
+            /// Number of threads waiting in wait_and_pop() because the queue
+            /// is empty.
+            std::atomic<int> m_waiting_consumers{0};
+
+            mutable std::mutex m_mutex;
+
+            /// Used to signal consumers when data is available in the queue.
+            std::condition_variable m_data_available;
+
+            /// Used to signal producers when queue is not full.
+            std::condition_variable m_space_available;
+
+            std::atomic<bool> m_in_use{true};
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            /// The largest size the queue has been so far.
+            std::atomic<std::size_t> m_largest_size;
+
+            /// The number of times push() was called on the queue.
+            std::atomic<int> m_push_counter;
+
+            /// The number of times the queue was full and a thread pushing
+            /// to the queue was blocked.
+            std::atomic<int> m_full_counter;
+
+            /**
+             * The number of times wait_and_pop(with_timeout)() was called
+             * on the queue.
+             */
+            std::atomic<int> m_pop_counter;
+
+            /// The number of times the queue was empty and a thread popping
+            /// from the queue was blocked.
+            std::atomic<int> m_empty_counter;
+
+            void update_largest_size() noexcept {
+                const std::size_t current_size = size();
+                std::size_t largest = m_largest_size.load();
+                while (largest < current_size && !m_largest_size.compare_exchange_weak(largest, current_size)) {
+                }
+            }
+#endif
+
+            bool try_push_value(T& value) {
+                std::size_t pos = m_push_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    slot& s = m_slots[pos % m_max_size];
+                    const std::size_t sequence = s.sequence.load(std::memory_order_acquire);
+                    if (sequence == pos) {
+                        if (m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            s.value = std::move(value);
+                            s.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (sequence < pos) {
+                        return false; // full
+                    } else {
+                        pos = m_push_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool try_pop_value(T& value) {
+                std::size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    slot& s = m_slots[pos % m_max_size];
+                    const std::size_t sequence = s.sequence.load(std::memory_order_acquire);
+                    if (sequence == pos + 1) {
+                        if (m_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            value = std::move(s.value);
+                            s.value = T{};
+                            s.sequence.store(pos + m_max_size, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (sequence < pos + 1) {
+                        return false; // empty
+                    } else {
+                        pos = m_pop_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Wake up a thread waiting on the condition variable if there
+            // is one. Taking the lock makes sure the waiting thread is
+            // really waiting and doesn't miss the notification.
+            void wake_up(const std::atomic<int>& waiting, std::condition_variable& condition) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (waiting > 0) {
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                    }
+                    condition.notify_one();
+                }
+            }
+
+        public:
+
+            /**
+             * Construct a multithreaded queue.
+             *
+             * @param max_size Maximum number of elements in the queue. If
+             *                 this is 0, a default size is used. Values
+             *                 smaller than 2 are set to 2, because the
+             *                 ring buffer doesn't work with fewer slots.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit BoundedQueue(std::size_t max_size = 0, std::string name = "") :
+                m_max_size(max_size == 0 ? static_cast<std::size_t>(default_max_size) : std::max(max_size, static_cast<std::size_t>(min_max_size))),
+                m_name(std::move(name)),
+                m_slots(new slot[m_max_size])
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                ,
+                m_largest_size(0),
+                m_push_counter(0),
+                m_full_counter(0),
+                m_pop_counter(0),
+                m_empty_counter(0)
+#endif
+            {
+                for (std::size_t i = 0; i < m_max_size; ++i) {
+                    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            BoundedQueue(const BoundedQueue&) = delete;
+            BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+            BoundedQueue(BoundedQueue&&) = delete;
+            BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            ~BoundedQueue() {
+                std::cerr << "queue '" << m_name
+                          << "' with max_size=" << m_max_size
+                          << " had largest size " << m_largest_size
+                          << " and was full " << m_full_counter
+                          << " times in " << m_push_counter
+                          << " push() calls and was empty " << m_empty_counter
+                          << " times in " << m_pop_counter
+                          << " pop() calls\n";
+            }
+#else
+            ~BoundedQueue() = default;
+#endif
+
+            /**
+             * Push an element onto the queue. If the queue is full, this
+             * call will block until there is space or the queue is shut
+             * down.
+             */
+            void push(T value) {
+                if (!m_in_use) {
+                    return;
+                }
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                ++m_push_counter;
+#endif
+                if (!try_push_value(value)) {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                    ++m_full_counter;
+#endif
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_waiting_producers;
+                    bool pushed = false;
+                    m_space_available.wait(lock, [&] {
+                        if (!m_in_use) {
+                            return true;
+                        }
+                        pushed = try_push_value(value);
+                        return pushed;
+                    });
+                    --m_waiting_producers;
+                    if (!pushed) {
+                        return;
+                    }
+                }
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                update_largest_size();
+#endif
+                wake_up(m_waiting_consumers, m_data_available);
+            }
+
+            void wait_and_pop(T& value) {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                ++m_pop_counter;
+#endif
+                if (!try_pop_value(value)) {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                    ++m_empty_counter;
+#endif
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_waiting_consumers;
+                    bool popped = false;
+                    m_data_available.wait(lock, [&] {
+                        popped = try_pop_value(value);
+                        return popped || !m_in_use;
+                    });
+                    --m_waiting_consumers;
+                    if (!popped) {
+                        return;
+                    }
+                }
+                wake_up(m_waiting_producers, m_space_available);
+            }
+
+            bool try_pop(T& value) {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                ++m_pop_counter;
+#endif
+                if (!try_pop_value(value)) {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                    ++m_empty_counter;
+#endif
+                    return false;
+                }
+                wake_up(m_waiting_producers, m_space_available);
+                return true;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            std::size_t size() const {
+                const std::size_t pop_pos = m_pop_pos.load();
+                const std::size_t push_pos = m_push_pos.load();
+                return push_pos > pop_pos ? push_pos - pop_pos : 0;
+            }
+
+            bool in_use() const noexcept {
+                return m_in_use;
+            }
+
+            /**
+             * Shut down the queue. All elements still in the queue are
+             * removed, later calls to push() are ignored and all threads
+             * waiting on the queue are woken up.
+             */
+            void shutdown() {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_in_use = false;
+                T value;
+                while (try_pop_value(value)) {
+                    value = T{};
+                }
+                m_data_available.notify_all();
+                m_space_available.notify_all();
+            }
+
+        }; // class BoundedQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_BOUNDED_QUEUE_HPP
@@ -34,12 +34,17 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -55,7 +60,8 @@ namespace osmium {
         namespace detail {
 
             // Maximum number of allowed pool threads (just to keep the user
-            // from setting something silly).
+            // from setting something silly). More threads are allowed if
+            // the hardware has more cores.
             enum {
                 max_pool_threads = 32
             };
@@ -69,10 +75,12 @@ namespace osmium {
                     num_threads += static_cast<int>(hardware_concurrency);
                 }
 
+                const int max_threads = std::max(static_cast<int>(max_pool_threads), static_cast<int>(hardware_concurrency));
+
                 if (num_threads < 1) {
                     num_threads = 1;
-                } else if (num_threads > max_pool_threads) {
-                    num_threads = max_pool_threads;
+                } else if (num_threads > max_threads) {
+                    num_threads = max_threads;
                 }
 
                 return num_threads;
@@ -82,10 +90,86 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("WORK", 10);
             }
 
+            /**
+             * The queue of tasks for one worker thread. Every worker has its
+             * own queue with its own lock, so submitting threads and workers
+             * don't all fight over one lock.
+             *
+             * The pending counter shared by all queues of a pool is updated
+             * while the lock is held, so a task is only counted while it is
+             * actually in a queue.
+             */
+            class work_queue {
+
+                std::mutex m_mutex;
+                std::deque<function_wrapper> m_tasks;
+                std::atomic<std::size_t>& m_pending;
+
+            public:
+
+                explicit work_queue(std::atomic<std::size_t>& pending) :
+                    m_pending(pending) {
+                }
+
+                work_queue(const work_queue&) = delete;
+                work_queue& operator=(const work_queue&) = delete;
+
+                work_queue(work_queue&&) = delete;
+                work_queue& operator=(work_queue&&) = delete;
+
+                ~work_queue() noexcept = default;
+
+                /**
+                 * Add task to the queue.
+                 */
+                void push(function_wrapper&& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_tasks.push_back(std::move(task));
+                    ++m_pending;
+                }
+
+                /**
+                 * Take the oldest task from the queue.
+                 *
+                 * @returns true if there was a task.
+                 */
+                bool try_pop(function_wrapper& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_tasks.empty()) {
+                        return false;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                    --m_pending;
+                    return true;
+                }
+
+            }; // class work_queue
+
         } // namespace detail
 
         /**
-         *  Thread pool.
+         * Thread pool.
+         *
+         * Every worker thread has its own task queue. New tasks are
+         * distributed round-robin over those queues. A worker takes
+         * tasks from its own queue first. When that is empty, it steals
+         * tasks from the other queues. The oldest task is always taken
+         * first, because results are usually consumed in the order the
+         * tasks were submitted.
+         *
+         * The queues are not lock-free. Each one is a deque guarded by its
+         * own mutex which is only held for a push or pop, so there is
+         * hardly any contention as long as there are not many more
+         * submitting threads than workers. A lock-free queue would need
+         * either a fixed capacity per worker or hazard pointers for the
+         * task memory, which isn't worth it for tasks that usually run
+         * for milliseconds.
+         *
+         * The max_queue_size is a bound on the number of tasks in all
+         * queues together. If it is reached, submit() runs the task in the
+         * calling thread instead of waiting for space. The same happens
+         * for tasks submitted after shutdown_all_workers() was called.
          */
         class Pool {
 
@@ -119,21 +203,109 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            int m_num_threads;
+            std::size_t m_max_queue_size;
+            std::vector<std::unique_ptr<detail::work_queue>> m_queues;
+
+            // Index of the queue the next task is added to.
+            std::atomic<std::size_t> m_next_queue{0};
+
+            // Number of tasks in all queues together. Updated by the queues.
+            std::atomic<std::size_t> m_pending{0};
+
+            // Number of slots in the queues taken by submitters. This is
+            // at least m_pending and never more than m_max_queue_size.
+            std::atomic<std::size_t> m_reserved{0};
+
+            // Number of workers waiting for tasks.
+            std::atomic<int> m_sleeping{0};
+
+            std::atomic<bool> m_done{false};
+
+            std::mutex m_sleep_mutex;
+            std::condition_variable m_wakeup;
+
             std::vector<std::thread> m_threads;
             thread_joiner m_joiner;
-            int m_num_threads;
 
-            void worker_thread() {
+            bool pop_task(std::size_t index, function_wrapper& task) {
+                const std::size_t num_queues = m_queues.size();
+                for (std::size_t i = 0; i < num_queues; ++i) {
+                    if (m_queues[(index + i) % num_queues]->try_pop(task)) {
+                        --m_reserved;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool reserve_slot() noexcept {
+                std::size_t reserved = m_reserved.load(std::memory_order_relaxed);
+                do {
+                    if (reserved >= m_max_queue_size) {
+                        return false;
+                    }
+                } while (!m_reserved.compare_exchange_weak(reserved, reserved + 1));
+                return true;
+            }
+
+            bool push_task(function_wrapper& task) {
+                if (!reserve_slot()) {
+                    return false;
+                }
+
+                const std::size_t num_queues = m_queues.size();
+                const std::size_t index = m_next_queue.fetch_add(1, std::memory_order_relaxed) % num_queues;
+                m_queues[index]->push(std::move(task));
+
+                if (m_done) {
+                    // The workers might have seen no pending tasks after
+                    // shutdown and stopped already. Make sure nothing is
+                    // left behind by running what is left in this thread.
+                    function_wrapper left_over;
+                    while (pop_task(index, left_over)) {
+                        left_over();
+                    }
+                    return true;
+                }
+
+                if (m_sleeping > 0) {
+                    // Taking the lock makes sure the worker is actually
+                    // waiting before it is notified.
+                    const std::lock_guard<std::mutex> lock{m_sleep_mutex};
+                }
+                m_wakeup.notify_one();
+
+                return true;
+            }
+
+            // The pool the current thread is a worker of (if any).
+            static const Pool*& current_pool() noexcept {
+                static thread_local const Pool* pool = nullptr;
+                return pool;
+            }
+
+            void worker_thread(std::size_t index) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                current_pool() = this;
                 while (true) {
-                    function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
-                    if (task && task()) {
-                        // The called tasks returns true only when the
-                        // worker thread should shut down.
+                    {
+                        function_wrapper task;
+                        if (pop_task(index, task)) {
+                            task();
+                            continue;
+                        }
+                    }
+
+                    std::unique_lock<std::mutex> lock{m_sleep_mutex};
+                    if (m_done && m_pending == 0) {
                         return;
                     }
+                    ++m_sleeping;
+                    m_wakeup.wait(lock, [this] {
+                        return m_pending > 0 || m_done;
+                    });
+                    --m_sleeping;
                 }
             }
 
@@ -159,17 +331,23 @@ namespace osmium {
              *
              * In all cases the minimum number of threads in the pool is 1.
              *
-             * If max_queue_size is 0, the queue size is read from
-             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
+             * The max_queue_size is the maximum number of tasks waiting
+             * in all queues together. If it is 0, the queue size is read
+             * from the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
              */
             explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
-                m_joiner(m_threads),
-                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
+                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())),
+                m_max_queue_size(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size()),
+                m_joiner(m_threads) {
+
+                m_queues.reserve(static_cast<std::size_t>(m_num_threads));
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_queues.emplace_back(new detail::work_queue{m_pending});
+                }
 
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, static_cast<std::size_t>(i));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -188,11 +366,17 @@ namespace osmium {
                 return pool;
             }
 
+            /**
+             * Tell all worker threads to shut down after all tasks in
+             * the queues are done. Tasks submitted after this are run
+             * in the calling thread, they are never lost.
+             */
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
+                m_done = true;
+                {
+                    const std::lock_guard<std::mutex> lock{m_sleep_mutex};
                 }
+                m_wakeup.notify_all();
             }
 
             Pool(const Pool&) = delete;
@@ -210,11 +394,21 @@ namespace osmium {
             }
 
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_pending;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_pending == 0;
+            }
+
+            /**
+             * Is the calling thread one of the worker threads of this
+             * pool? Tasks running in the pool must not wait for other
+             * tasks of the same pool, because all workers might be busy
+             * waiting.
+             */
+            bool is_pool_thread() const noexcept {
+                return current_pool() == this;
             }
 
 #if defined(__cpp_lib_is_invocable) && __cpp_lib_is_invocable >= 201703
@@ -232,7 +426,13 @@ namespace osmium {
             std::future<submit_func_result_type<TFunction>> submit(TFunction&& func) {
                 std::packaged_task<submit_func_result_type<TFunction>()> task{std::forward<TFunction>(func)};
                 std::future<submit_func_result_type<TFunction>> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+
+                function_wrapper wrapped_task{std::move(task)};
+                if (m_done || !push_task(wrapped_task)) {
+                    // The queues are full (or the pool is shut down), so
+                    // do the work here instead of waiting for a worker.
+                    wrapped_task();
+                }
 
                 return future_result;
             }
@@ -80,6 +80,19 @@ namespace osmium {
             return true;
         }
 
+        inline bool use_io_uring() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_USE_IO_URING");
+            if (env) {
+                if (!strcasecmp(env, "off") ||
+                    !strcasecmp(env, "false") ||
+                    !strcasecmp(env, "no") ||
+                    !strcasecmp(env, "0")) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         inline std::size_t get_max_queue_size(const char* queue_name, const std::size_t default_value) noexcept {
             assert(queue_name);
             std::string name{"OSMIUM_MAX_"};
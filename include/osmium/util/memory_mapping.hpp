@@ -35,15 +35,25 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/util/file.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <stdexcept>
+#include <string>
 #include <system_error>
+#include <utility>
 
 #ifndef _WIN32
 # include <sys/mman.h>
 # include <sys/statvfs.h>
+# ifdef __linux__
+#  include <sys/syscall.h>
+#  include <unistd.h>
+# endif
 #else
 # include <fcntl.h>
 # include <io.h>
@@ -55,6 +65,52 @@ namespace osmium {
 
     inline namespace util {
 
+        /**
+         * Should huge pages be used for anonymous memory mappings?
+         */
+        enum class huge_pages {
+
+            /// Use normal pages (or whatever the system default is)
+            no          = 0,
+
+            /// Ask the kernel to use transparent huge pages if possible
+            transparent = 1,
+
+            /// Use explicit huge pages from the pool reserved by the
+            /// administrator (MAP_HUGETLB). Creating the mapping fails if
+            /// there are not enough huge pages available.
+            hugetlb     = 2
+
+        }; // enum class huge_pages
+
+        /**
+         * NUMA memory policy for anonymous memory mappings.
+         */
+        enum class numa_policy {
+
+            /// Use the policy of the process
+            none       = 0,
+
+            /// Interleave pages over all NUMA nodes the process can use
+            interleave = 1,
+
+            /// Allocate pages on the node of the CPU that touches them
+            /// first
+            local      = 2
+
+        }; // enum class numa_policy
+
+        /**
+         * Options for anonymous memory mappings. They are only used on
+         * Linux and ignored on other systems. Transparent huge pages and
+         * the NUMA policy are hints, if the system doesn't support them,
+         * they are silently ignored.
+         */
+        struct memory_mapping_options {
+            huge_pages pages = huge_pages::no;
+            numa_policy numa = numa_policy::none;
+        };
+
         /**
          * Class for wrapping memory mapping system calls.
          *
@@ -116,6 +172,9 @@ namespace osmium {
             /// Mapping mode
             mapping_mode m_mapping_mode;
 
+            /// Huge page and NUMA options (anonymous mappings only)
+            memory_mapping_options m_options{};
+
 #ifdef _WIN32
             HANDLE m_handle;
 #endif
@@ -144,6 +203,20 @@ namespace osmium {
                 return size;
             }
 
+            // Mappings with explicit huge pages must be a multiple of the
+            // huge page size.
+            static std::size_t check_size(std::size_t size, const memory_mapping_options& options) {
+                size = check_size(size);
+                if (options.pages == huge_pages::hugetlb) {
+                    const std::size_t huge_page_size = get_huge_page_size();
+                    size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+                }
+                return size;
+            }
+
+            // Apply the huge page and NUMA options to the mapped memory.
+            void apply_options() const noexcept;
+
 #ifdef _WIN32
             HANDLE get_handle() const noexcept;
             HANDLE create_file_mapping() const noexcept;
@@ -165,6 +238,24 @@ namespace osmium {
 #endif
             }
 
+            static std::size_t read_huge_page_size() {
+                std::size_t size = 2UL * 1024UL * 1024UL;
+#ifdef __linux__
+                std::ifstream meminfo{"/proc/meminfo"};
+                std::string line;
+                while (std::getline(meminfo, line)) {
+                    if (line.compare(0, 13, "Hugepagesize:") == 0) {
+                        const std::size_t kb = std::strtoul(line.c_str() + 13, nullptr, 10);
+                        if (kb > 0) {
+                            size = kb * 1024;
+                        }
+                        break;
+                    }
+                }
+#endif
+                return size;
+            }
+
             int resize_fd(int fd) const {
                 // Anonymous mapping doesn't need resizing.
                 if (fd == -1) {
@@ -204,6 +295,28 @@ namespace osmium {
              */
             MemoryMapping(std::size_t size, mapping_mode mode, int fd = -1, off_t offset = 0);
 
+            /**
+             * Create anonymous memory mapping of given size using the huge
+             * page and NUMA options given.
+             *
+             * @param size Size of the mapping in bytes. If explicit huge
+             *             pages are used, the size is rounded up to a
+             *             multiple of the huge page size.
+             * @param options Huge page and NUMA options.
+             * @throws std::system_error if the mapping fails
+             */
+            MemoryMapping(std::size_t size, const memory_mapping_options& options);
+
+            /**
+             * Get the size of huge pages on this system. On Linux this
+             * is read from /proc/meminfo, if that doesn't work or on other
+             * systems 2 MByte is returned.
+             */
+            static std::size_t get_huge_page_size() {
+                static const std::size_t size = read_huge_page_size();
+                return size;
+            }
+
             /// You can not copy construct a MemoryMapping.
             MemoryMapping(const MemoryMapping&) = delete;
 
@@ -317,6 +430,10 @@ namespace osmium {
                 MemoryMapping(size, mapping_mode::write_private) {
             }
 
+            AnonymousMemoryMapping(std::size_t size, const memory_mapping_options& options) :
+                MemoryMapping(size, options) {
+            }
+
 #ifndef __linux__
             /**
              * On systems other than Linux anonymous mappings can not be
@@ -353,6 +470,18 @@ namespace osmium {
                 m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private) {
             }
 
+            /**
+             * Create anonymous typed memory mapping of given size using the
+             * huge page and NUMA options given.
+             *
+             * @param size Number of objects of type T to be mapped
+             * @param options Huge page and NUMA options.
+             * @throws std::system_error if the mapping fails
+             */
+            TypedMemoryMapping(std::size_t size, const memory_mapping_options& options) :
+                m_mapping(sizeof(T) * size, options) {
+            }
+
             /**
              * Create file-backed memory mapping of given size. The file must
              * contain at least `sizeof(T) * size` bytes!
@@ -513,6 +642,10 @@ namespace osmium {
                 TypedMemoryMapping<T>(size) {
             }
 
+            AnonymousTypedMemoryMapping(std::size_t size, const memory_mapping_options& options) :
+                TypedMemoryMapping<T>(size, options) {
+            }
+
 #ifndef __linux__
             /**
              * On systems other than Linux anonymous mappings can not be
@@ -559,6 +692,11 @@ inline int osmium::util::MemoryMapping::get_protection() const noexcept {
 
 inline int osmium::util::MemoryMapping::get_flags() const noexcept {
     if (m_fd == -1) {
+#ifdef MAP_HUGETLB
+        if (m_options.pages == huge_pages::hugetlb) {
+            return MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB; // NOLINT(hicpp-signed-bitwise)
+        }
+#endif
         return MAP_PRIVATE | MAP_ANONYMOUS; // NOLINT(hicpp-signed-bitwise)
     }
     if (m_mapping_mode == mapping_mode::write_shared) {
@@ -579,11 +717,59 @@ inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode
     }
 }
 
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, const memory_mapping_options& options) :
+    m_size(check_size(size, options)),
+    m_offset(0),
+    m_fd(-1),
+    m_mapping_mode(mapping_mode::write_private),
+    m_options(options),
+    m_addr(::mmap(nullptr, m_size, get_protection(), get_flags(), m_fd, m_offset)) {
+    if (!is_valid()) {
+        throw std::system_error{errno, std::system_category(), "mmap failed"};
+    }
+    apply_options();
+}
+
+#ifdef __linux__
+inline void osmium::util::MemoryMapping::apply_options() const noexcept {
+#ifdef MADV_HUGEPAGE
+    if (m_options.pages == huge_pages::transparent) {
+        ::madvise(m_addr, m_size, MADV_HUGEPAGE);
+    }
+#endif
+
+    // Constants from linux/mempolicy.h. The system calls are used
+    // directly so that we don't need libnuma.
+    enum : int {
+        mpol_interleave     = 3,
+        mpol_local          = 4,
+        mpol_f_mems_allowed = 1 << 2
+    };
+    enum : unsigned long { // NOLINT(google-runtime-int)
+        max_nodes = 1024
+    };
+
+    if (m_options.numa == numa_policy::interleave) {
+        unsigned long nodemask[max_nodes / (8 * sizeof(unsigned long))] = {}; // NOLINT(google-runtime-int)
+        if (::syscall(SYS_get_mempolicy, nullptr, nodemask, max_nodes, nullptr, mpol_f_mems_allowed) == 0) {
+            ::syscall(SYS_mbind, m_addr, m_size, mpol_interleave, nodemask, max_nodes, 0);
+        }
+    } else if (m_options.numa == numa_policy::local) {
+        ::syscall(SYS_mbind, m_addr, m_size, mpol_local, nullptr, 0, 0);
+    }
+}
+#else
+inline void osmium::util::MemoryMapping::apply_options() const noexcept {
+    // huge page and NUMA options are only supported on Linux
+}
+#endif
+
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
     m_size(other.m_size),
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_addr(other.m_addr) {
     other.make_invalid();
 }
@@ -599,6 +785,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_addr         = other.m_addr;
     other.make_invalid();
     return *this;
@@ -617,11 +804,22 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
     assert(new_size > 0 && "can not resize to zero size");
     if (m_fd == -1) { // anonymous mapping
 #ifdef __linux__
-        m_addr = ::mremap(m_addr, m_size, new_size, MREMAP_MAYMOVE);
-        if (!is_valid()) {
+        new_size = check_size(new_size, m_options);
+        void* const new_addr = ::mremap(m_addr, m_size, new_size, MREMAP_MAYMOVE);
+        if (new_addr != MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+            m_addr = new_addr;
+        } else if (m_options.pages == huge_pages::hugetlb && errno == EINVAL) {
+            // Older kernels can't mremap() huge page mappings, so we
+            // create a new mapping and copy the data over.
+            MemoryMapping new_mapping{new_size, m_options};
+            std::memcpy(new_mapping.m_addr, m_addr, std::min(m_size, new_size));
+            *this = std::move(new_mapping);
+            return;
+        } else {
             throw std::system_error{errno, std::system_category(), "mremap failed"};
         }
         m_size = new_size;
+        apply_options();
 #else
         assert(false && "can't resize anonymous mappings on non-linux systems");
 #endif
@@ -747,6 +945,14 @@ inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMappin
     }
 }
 
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, const memory_mapping_options& /*options*/) :
+    MemoryMapping(size, mapping_mode::write_private) {
+}
+
+inline void osmium::util::MemoryMapping::apply_options() const noexcept {
+    // huge page and NUMA options are not supported on Windows
+}
+
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
     m_size(other.m_size),
     m_offset(other.m_offset),
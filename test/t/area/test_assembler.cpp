@@ -2,11 +2,17 @@
 
 #include <osmium/area/assembler.hpp>
 #include <osmium/area/assembler_config.hpp>
+#include <osmium/area/reusable_assembler.hpp>
 #include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Build area from way") {
@@ -143,3 +149,193 @@ TEST_CASE("Build area from way with ignored invalid location") {
     REQUIRE(s.invalid_locations == 1);
 }
 
+
+namespace {
+
+    std::vector<osmium::object_id_type> ring_node_ids(const osmium::Area& area) {
+        std::vector<osmium::object_id_type> ids;
+        for (const auto& outer : area.outer_rings()) {
+            for (const auto& nr : outer) {
+                ids.push_back(nr.ref());
+            }
+            for (const auto& inner : area.inner_rings(outer)) {
+                ids.push_back(0);
+                for (const auto& nr : inner) {
+                    ids.push_back(nr.ref());
+                }
+            }
+        }
+        return ids;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Reusable assembler builds the same areas as new assemblers") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    const auto square = osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.0, 2.0}},
+            {4, {2.0, 1.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+
+    const auto invalid = osmium::builder::add_way(buffer,
+        _id(2),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3},
+            {4, {2.0, 1.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+
+    const auto outer = osmium::builder::add_way(buffer,
+        _id(3),
+        _nodes({
+            {10, {0.0, 0.0}},
+            {11, {0.0, 3.0}},
+            {12, {3.0, 3.0}},
+            {13, {3.0, 0.0}},
+            {10, {0.0, 0.0}}
+        })
+    );
+
+    const auto relation = osmium::builder::add_relation(buffer,
+        _id(1),
+        _tag("type", "multipolygon"),
+        _member(osmium::item_type::way, 3, "outer"),
+        _member(osmium::item_type::way, 1, "inner")
+    );
+
+    const std::vector<const osmium::Way*> members = {&buffer.get<osmium::Way>(outer), &buffer.get<osmium::Way>(square)};
+    const auto& rel = buffer.get<osmium::Relation>(relation);
+
+    const osmium::area::AssemblerConfig config;
+    osmium::area::ReusableAssembler reusable{config};
+
+    for (int round = 0; round < 2; ++round) {
+        for (const auto pos : {square, invalid, outer}) {
+            const auto& way = buffer.get<osmium::Way>(pos);
+
+            osmium::area::Assembler assembler{config};
+            osmium::memory::Buffer expected{10240};
+            const bool expected_okay = assembler(way, expected);
+
+            osmium::memory::Buffer area_buffer{10240};
+            REQUIRE(reusable(way, area_buffer) == expected_okay);
+            REQUIRE(area_buffer.committed() == expected.committed());
+            REQUIRE(reusable.stats().from_ways == 1);
+            REQUIRE(reusable.stats().nodes == assembler.stats().nodes);
+            REQUIRE(reusable.stats().invalid_locations == assembler.stats().invalid_locations);
+            if (expected_okay) {
+                REQUIRE(ring_node_ids(area_buffer.get<osmium::Area>(0)) == ring_node_ids(expected.get<osmium::Area>(0)));
+            }
+        }
+
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer expected{10240};
+        REQUIRE(assembler(rel, members, expected));
+
+        osmium::memory::Buffer area_buffer{10240};
+        REQUIRE(reusable(rel, members, area_buffer));
+        REQUIRE(reusable.stats().from_relations == 1);
+        REQUIRE(reusable.stats().outer_rings == 1);
+        REQUIRE(reusable.stats().inner_rings == 1);
+
+        const auto& area = area_buffer.get<osmium::Area>(0);
+        REQUIRE(area.id() == 3);
+        REQUIRE(ring_node_ids(area) == ring_node_ids(expected.get<osmium::Area>(0)));
+    }
+}
+
+namespace {
+
+    // Assemble the way directly and as the only member of a relation. The
+    // relation is always assembled the long way, so the rings must match.
+    void check_way_against_relation(const std::vector<osmium::Location>& locations) {
+        osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+        {
+            osmium::builder::WayBuilder builder{buffer};
+            builder.set_id(1);
+            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+            osmium::object_id_type id = 1;
+            for (const auto& location : locations) {
+                wnl_builder.add_node_ref(osmium::NodeRef{id++, location});
+            }
+            wnl_builder.add_node_ref(osmium::NodeRef{1, locations.front()});
+        }
+        const auto& way = buffer.get<osmium::Way>(buffer.commit());
+        const auto& relation = buffer.get<osmium::Relation>(osmium::builder::add_relation(buffer,
+            _id(1),
+            _tag("type", "multipolygon"),
+            _member(osmium::item_type::way, 1, "outer")
+        ));
+
+        const osmium::area::AssemblerConfig config;
+
+        osmium::area::Assembler way_assembler{config};
+        osmium::memory::Buffer way_buffer{10240};
+        const bool way_okay = way_assembler(way, way_buffer);
+
+        osmium::area::Assembler relation_assembler{config};
+        osmium::memory::Buffer relation_buffer{10240};
+        const bool relation_okay = relation_assembler(relation, {&way}, relation_buffer);
+
+        REQUIRE(way_okay == relation_okay);
+        REQUIRE(way_assembler.stats().nodes == relation_assembler.stats().nodes);
+        REQUIRE(way_assembler.stats().intersections == relation_assembler.stats().intersections);
+        REQUIRE(way_assembler.stats().area_simple_case == relation_assembler.stats().area_simple_case);
+        REQUIRE(way_assembler.stats().outer_rings == relation_assembler.stats().outer_rings);
+        if (way_okay) {
+            const auto& area = way_buffer.get<osmium::Area>(0);
+            REQUIRE(area.id() == 2);
+            REQUIRE(ring_node_ids(area) == ring_node_ids(relation_buffer.get<osmium::Area>(0)));
+        }
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Areas from simple closed ways are the same as from full assembly") {
+    SECTION("square counter-clockwise") {
+        check_way_against_relation({{1.0, 1.0}, {2.0, 1.0}, {2.0, 2.0}, {1.0, 2.0}});
+    }
+    SECTION("square clockwise starting at top") {
+        check_way_against_relation({{2.0, 2.0}, {2.0, 1.0}, {1.0, 1.0}, {1.0, 2.0}});
+    }
+    SECTION("concave ring") {
+        check_way_against_relation({{3.0, 3.0}, {0.0, 3.0}, {0.0, 0.0}, {3.0, 0.0}, {3.0, 1.0}, {1.0, 1.0}, {1.0, 2.0}, {3.0, 2.0}});
+    }
+    SECTION("self-intersecting ring") {
+        check_way_against_relation({{0.0, 0.0}, {1.0, 1.0}, {1.0, 0.0}, {0.0, 1.0}});
+    }
+    SECTION("ring with duplicate location") {
+        check_way_against_relation({{0.0, 0.0}, {1.0, 0.0}, {1.0, 0.0}, {1.0, 1.0}, {0.0, 1.0}});
+    }
+    SECTION("ring touching itself") {
+        check_way_against_relation({{0.0, 0.0}, {2.0, 0.0}, {1.0, 1.0}, {2.0, 2.0}, {0.0, 2.0}, {1.0, 1.0}});
+    }
+    SECTION("star shaped rings") {
+        uint32_t state = 42;
+        const auto next = [&state]() {
+            state = state * 1103515245U + 12345U;
+            return (state >> 8U) % 1000U;
+        };
+        for (int n = 0; n < 200; ++n) {
+            const int num_nodes = 3 + static_cast<int>(next() % 80);
+            const bool clockwise = next() % 2;
+            std::vector<osmium::Location> locations;
+            for (int i = 0; i < num_nodes; ++i) {
+                const double angle = 6.283 * (clockwise ? num_nodes - i : i) / num_nodes;
+                const double radius = 0.1 + static_cast<double>(next()) / 1000.0;
+                locations.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+            }
+            check_way_against_relation(locations);
+        }
+    }
+}
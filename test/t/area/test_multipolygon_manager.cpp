@@ -0,0 +1,216 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/area/reusable_assembler.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // A closed way tagged as building for each i < num_ways and a
+    // multipolygon relation made up of two open ways for each i < num_rels.
+    osmium::memory::Buffer create_input(int num_ways, int num_rels) {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+        for (int i = 0; i < num_ways; ++i) {
+            const osmium::object_id_type n = 4 * i + 1;
+            const double x = (i % 100) * 0.01;
+            const double y = (i / 100) * 0.01;
+            osmium::builder::add_way(buffer,
+                _id(i + 1),
+                _tag("building", "yes"),
+                _nodes({
+                    {n,     {x,         y}},
+                    {n + 1, {x + 0.005, y}},
+                    {n + 2, {x + 0.005, y + 0.005}},
+                    {n + 3, {x,         y + 0.005}},
+                    {n,     {x,         y}}
+                })
+            );
+        }
+
+        for (int i = 0; i < num_rels; ++i) {
+            const osmium::object_id_type n = 1000000 + 4 * i;
+            const osmium::object_id_type w = 1000000 + 2 * i;
+            const double x = 10.0 + (i % 100) * 0.01;
+            const double y = (i / 100) * 0.01;
+            osmium::builder::add_way(buffer,
+                _id(w),
+                _nodes({
+                    {n,     {x,         y}},
+                    {n + 1, {x + 0.005, y}},
+                    {n + 2, {x + 0.005, y + 0.005}}
+                })
+            );
+            osmium::builder::add_way(buffer,
+                _id(w + 1),
+                _nodes({
+                    {n + 2, {x + 0.005, y + 0.005}},
+                    {n + 3, {x,         y + 0.005}},
+                    {n,     {x,         y}}
+                })
+            );
+        }
+
+        for (int i = 0; i < num_rels; ++i) {
+            const osmium::object_id_type w = 1000000 + 2 * i;
+            osmium::builder::add_relation(buffer,
+                _id(i + 1),
+                _tag("type", "multipolygon"),
+                _tag("landuse", "forest"),
+                _member(osmium::item_type::way, w, "outer"),
+                _member(osmium::item_type::way, w + 1, "outer")
+            );
+        }
+
+        return buffer;
+    }
+
+    struct result_type {
+        std::vector<osmium::object_id_type> ids;
+        osmium::area::area_stats stats;
+    };
+
+    template <typename TAssembler = osmium::area::Assembler>
+    result_type assemble(const osmium::memory::Buffer& input, osmium::thread::Pool* pool) {
+        const osmium::area::AssemblerConfig config;
+        osmium::area::MultipolygonManager<TAssembler> mp_manager{config};
+        if (pool) {
+            mp_manager.enable_parallel_assembly(*pool);
+            REQUIRE(mp_manager.parallel_assembly());
+        }
+
+        for (const auto& relation : input.select<osmium::Relation>()) {
+            mp_manager.relation(relation);
+        }
+        mp_manager.prepare_for_lookup();
+
+        result_type result;
+        osmium::apply(input, mp_manager.handler([&result](osmium::memory::Buffer&& buffer) {
+            for (const auto& area : buffer.select<osmium::Area>()) {
+                result.ids.push_back(area.id());
+            }
+        }));
+
+        result.stats = mp_manager.stats();
+        return result;
+    }
+
+    // Move the manager after the given number of closed ways was
+    // assembled, destroy the original and assemble the rest.
+    template <typename TAssembler>
+    void check_moved_manager(int ways_before_move) {
+        const auto input = create_input(10, 0);
+
+        std::unique_ptr<osmium::area::MultipolygonManager<TAssembler>> original{new osmium::area::MultipolygonManager<TAssembler>{osmium::area::AssemblerConfig{}}};
+        original->prepare_for_lookup();
+
+        int n = 0;
+        for (const auto& way : input.select<osmium::Way>()) {
+            if (n++ < ways_before_move) {
+                original->handle_way(way);
+            }
+        }
+
+        osmium::area::MultipolygonManager<TAssembler> mp_manager{std::move(*original)};
+        original.reset();
+
+        n = 0;
+        for (const auto& way : input.select<osmium::Way>()) {
+            if (n++ >= ways_before_move) {
+                mp_manager.handle_way(way);
+            }
+        }
+
+        const osmium::memory::Buffer buffer = mp_manager.read();
+        std::vector<osmium::object_id_type> ids;
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            ids.push_back(area.id());
+        }
+        REQUIRE(ids.size() == 10);
+        REQUIRE(mp_manager.stats().from_ways == 10);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Parallel assembly creates the same areas in the same order") {
+    const auto input = create_input(5000, 2000);
+
+    const auto sequential = assemble(input, nullptr);
+    REQUIRE(sequential.ids.size() == 7000);
+    REQUIRE(sequential.stats.from_ways == 5000);
+    REQUIRE(sequential.stats.from_relations == 2000);
+
+    osmium::thread::Pool pool{2};
+    const auto parallel = assemble(input, &pool);
+    REQUIRE(parallel.ids == sequential.ids);
+    REQUIRE(parallel.stats.from_ways == sequential.stats.from_ways);
+    REQUIRE(parallel.stats.from_relations == sequential.stats.from_relations);
+    REQUIRE(parallel.stats.member_ways == sequential.stats.member_ways);
+    REQUIRE(parallel.stats.nodes == sequential.stats.nodes);
+    REQUIRE(parallel.stats.outer_rings == sequential.stats.outer_rings);
+    REQUIRE(parallel.stats.area_simple_case == sequential.stats.area_simple_case);
+}
+
+static_assert(!osmium::area::detail::is_reusable_assembler<osmium::area::Assembler>::value, "Assembler is not reusable");
+static_assert(osmium::area::detail::is_reusable_assembler<osmium::area::ReusableAssembler>::value, "ReusableAssembler is reusable");
+
+TEST_CASE("Multipolygon manager with reusable assembler") {
+    const auto input = create_input(5000, 2000);
+
+    const auto expected = assemble(input, nullptr);
+
+    const auto sequential = assemble<osmium::area::ReusableAssembler>(input, nullptr);
+    REQUIRE(sequential.ids == expected.ids);
+    REQUIRE(sequential.stats.from_ways == expected.stats.from_ways);
+    REQUIRE(sequential.stats.from_relations == expected.stats.from_relations);
+    REQUIRE(sequential.stats.nodes == expected.stats.nodes);
+
+    osmium::thread::Pool pool{2};
+    const auto parallel = assemble<osmium::area::ReusableAssembler>(input, &pool);
+    REQUIRE(parallel.ids == expected.ids);
+    REQUIRE(parallel.stats.nodes == expected.stats.nodes);
+}
+
+TEST_CASE("Parallel assembly can not be enabled with a problem reporter") {
+    struct DummyReporter : public osmium::area::ProblemReporter {
+    };
+    DummyReporter reporter;
+    osmium::area::AssemblerConfig config;
+    config.problem_reporter = &reporter;
+
+    osmium::area::MultipolygonManager<osmium::area::Assembler> mp_manager{config};
+    osmium::thread::Pool pool{1};
+    REQUIRE_THROWS_AS(mp_manager.enable_parallel_assembly(pool), std::invalid_argument);
+    REQUIRE_FALSE(mp_manager.parallel_assembly());
+}
+
+TEST_CASE("Multipolygon manager can be moved") {
+    SECTION("before assembling anything") {
+        check_moved_manager<osmium::area::Assembler>(0);
+    }
+    SECTION("after assembling some areas") {
+        check_moved_manager<osmium::area::Assembler>(5);
+    }
+}
+
+TEST_CASE("Multipolygon manager with reusable assembler can be moved") {
+    SECTION("before assembling anything") {
+        check_moved_manager<osmium::area::ReusableAssembler>(0);
+    }
+    SECTION("after assembling some areas") {
+        check_moved_manager<osmium::area::ReusableAssembler>(5);
+    }
+}
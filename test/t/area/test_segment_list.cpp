@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <osmium/area/detail/node_ref_segment.hpp>
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+    class IntersectionRecorder : public osmium::area::ProblemReporter {
+
+    public:
+
+        std::vector<osmium::Location> intersections;
+
+        void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location /*way1_seg_start*/, osmium::Location /*way1_seg_end*/,
+                                 osmium::object_id_type /*way2_id*/, osmium::Location /*way2_seg_start*/, osmium::Location /*way2_seg_end*/, osmium::Location intersection) override {
+            intersections.push_back(intersection);
+        }
+
+    }; // class IntersectionRecorder
+
+    // Way with pseudo-random nodes in a box of the given size, so that
+    // there are many intersections between the segments.
+    const osmium::Way& create_way(osmium::memory::Buffer& buffer, int num_nodes, int32_t size) {
+        {
+            osmium::builder::WayBuilder builder{buffer};
+            builder.set_id(1);
+            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+            uint32_t state = 12345;
+            const auto next = [&state, size]() {
+                state = state * 1103515245U + 12345U;
+                return static_cast<int32_t>((state >> 8U) % static_cast<uint32_t>(size));
+            };
+            for (int i = 0; i < num_nodes; ++i) {
+                wnl_builder.add_node_ref(osmium::NodeRef{i + 1, osmium::Location{next(), next()}});
+            }
+        }
+        return buffer.get<osmium::Way>(buffer.commit());
+    }
+
+    void check_intersections(int num_nodes, int32_t size) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        const auto& way = create_way(buffer, num_nodes, size);
+
+        osmium::area::detail::SegmentList segments{false};
+        uint64_t duplicate_nodes = 0;
+        segments.extract_segments_from_way(nullptr, duplicate_nodes, way);
+        segments.sort();
+        uint64_t duplicate_segments = 0;
+        uint64_t overlapping_segments = 0;
+        segments.erase_duplicate_segments(nullptr, duplicate_segments, overlapping_segments);
+
+        // Check all pairs of segments.
+        std::vector<osmium::Location> expected;
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            for (std::size_t j = i + 1; j < segments.size(); ++j) {
+                const auto intersection = osmium::area::detail::calculate_intersection(segments[i], segments[j]);
+                if (intersection) {
+                    expected.push_back(intersection);
+                }
+            }
+        }
+
+        IntersectionRecorder recorder;
+        REQUIRE(segments.find_intersections(&recorder) == expected.size());
+        REQUIRE(recorder.intersections == expected);
+        REQUIRE(segments.find_intersections(nullptr) == expected.size());
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Find intersections in small segment list") {
+    check_intersections(10, 1000);
+    check_intersections(500, 10000000);
+}
+
+TEST_CASE("Find intersections in large segment list") {
+    check_intersections(2000, 1000);
+    check_intersections(2000, 10000000);
+}
+
+TEST_CASE("Find intersections in large segment list without intersections") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // A long thin zigzag line along the x axis.
+    {
+        osmium::builder::WayBuilder builder{buffer};
+        builder.set_id(1);
+        osmium::builder::WayNodeListBuilder wnl_builder{builder};
+        for (int i = 0; i < 5000; ++i) {
+            wnl_builder.add_node_ref(osmium::NodeRef{i + 1, osmium::Location{i * 10, (i % 2) * 10}});
+        }
+    }
+    const auto& way = buffer.get<osmium::Way>(buffer.commit());
+
+    osmium::area::detail::SegmentList segments{false};
+    uint64_t duplicate_nodes = 0;
+    segments.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    segments.sort();
+
+    REQUIRE(segments.size() == 4999);
+    REQUIRE(segments.find_intersections(nullptr) == 0);
+}
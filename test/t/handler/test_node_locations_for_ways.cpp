@@ -0,0 +1,200 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+osmium::Location location_for(osmium::object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id) * 10, static_cast<int32_t>(id) * 20};
+}
+
+osmium::memory::Buffer create_ways(int num_ways, int nodes_per_way) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 0; i < num_ways; ++i) {
+        std::vector<osmium::NodeRef> nodes;
+        for (int j = 0; j < nodes_per_way; ++j) {
+            nodes.emplace_back(1 + ((i * 7 + j * 13) % 1000));
+        }
+        osmium::builder::add_way(buffer,
+            osmium::builder::attr::_id(i + 1),
+            osmium::builder::attr::_nodes(nodes)
+        );
+    }
+    return buffer;
+}
+
+template <typename THandler>
+void add_nodes(THandler& handler, osmium::object_id_type first, osmium::object_id_type last) {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = last; id >= first; --id) {
+        osmium::builder::add_node(buffer,
+            osmium::builder::attr::_id(id),
+            osmium::builder::attr::_location(location_for(id))
+        );
+    }
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        handler.node(node);
+    }
+}
+
+bool all_locations_set(const osmium::memory::Buffer& buffer) {
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            if (node_ref.location() != location_for(node_ref.ref())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Index which records how it was sorted.
+class SortRecordingIndex : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> m_index;
+
+public:
+
+    int serial_sorts = 0;
+    const osmium::thread::Pool* sorted_with_pool = nullptr;
+
+    void set(const osmium::unsigned_object_id_type id, const osmium::Location value) final {
+        m_index.set(id, value);
+    }
+
+    osmium::Location get(const osmium::unsigned_object_id_type id) const final {
+        return m_index.get(id);
+    }
+
+    osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept final {
+        return m_index.get_noexcept(id);
+    }
+
+    std::size_t size() const final {
+        return m_index.size();
+    }
+
+    std::size_t used_memory() const final {
+        return m_index.used_memory();
+    }
+
+    void clear() final {
+        m_index.clear();
+    }
+
+    void sort() final {
+        ++serial_sorts;
+        m_index.sort();
+    }
+
+    void sort_parallel(osmium::thread::Pool& pool) final {
+        sorted_with_pool = &pool;
+        m_index.sort_parallel(pool);
+    }
+
+}; // class SortRecordingIndex
+
+} // anonymous namespace
+
+TEST_CASE("Add locations to ways in buffer using thread pool") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+    index_type index;
+    location_handler_type location_handler{index};
+    add_nodes(location_handler, 1, 1000);
+
+    auto buffer = create_ways(2000, 50);
+    osmium::thread::Pool pool{3};
+    location_handler.add_locations_to_ways(buffer, pool);
+
+    REQUIRE(all_locations_set(buffer));
+}
+
+TEST_CASE("Add locations to ways in buffer sorts unsorted index first") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+    index_type index;
+    location_handler_type location_handler{index};
+    add_nodes(location_handler, 1, 1000); // added in reverse order
+
+    auto buffer = create_ways(100, 10);
+    location_handler.add_locations_to_ways(buffer);
+
+    REQUIRE(all_locations_set(buffer));
+}
+
+TEST_CASE("Add locations to ways in buffer sorts unsorted index using the pool") {
+    using location_handler_type = osmium::handler::NodeLocationsForWays<SortRecordingIndex>;
+
+    SortRecordingIndex index;
+    location_handler_type location_handler{index};
+    add_nodes(location_handler, 1, 1000); // added in reverse order
+
+    auto buffer = create_ways(100, 10);
+    osmium::thread::Pool pool{2};
+    location_handler.add_locations_to_ways(buffer, pool);
+
+    REQUIRE(index.sorted_with_pool == &pool);
+    REQUIRE(index.serial_sorts == 0);
+    REQUIRE(all_locations_set(buffer));
+}
+
+TEST_CASE("Adding locations to single ways sorts unsorted index in the calling thread") {
+    using location_handler_type = osmium::handler::NodeLocationsForWays<SortRecordingIndex>;
+
+    SortRecordingIndex index;
+    location_handler_type location_handler{index};
+    add_nodes(location_handler, 1, 1000); // added in reverse order
+
+    auto buffer = create_ways(100, 10);
+    for (auto& way : buffer.select<osmium::Way>()) {
+        location_handler.way(way);
+    }
+
+    REQUIRE(index.sorted_with_pool == nullptr);
+    REQUIRE(index.serial_sorts == 1);
+    REQUIRE(all_locations_set(buffer));
+}
+
+TEST_CASE("Add locations to ways in buffer with missing nodes") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+    index_type index;
+    location_handler_type location_handler{index};
+    add_nodes(location_handler, 1, 500);
+
+    auto buffer = create_ways(2000, 50);
+    osmium::thread::Pool pool{2};
+
+    SECTION("throws by default") {
+        REQUIRE_THROWS_AS(location_handler.add_locations_to_ways(buffer, pool), osmium::not_found);
+    }
+
+    SECTION("ignore errors") {
+        location_handler.ignore_errors();
+        location_handler.add_locations_to_ways(buffer, pool);
+    }
+
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            if (node_ref.ref() <= 500) {
+                REQUIRE(node_ref.location() == location_for(node_ref.ref()));
+            } else {
+                REQUIRE_FALSE(node_ref.location());
+            }
+        }
+    }
+}
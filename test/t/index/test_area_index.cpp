@@ -0,0 +1,276 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/area_index.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // A grid of 40x40 squares of size 0.01 (area ids 2..3200) and one
+    // large area with a hole in it (id 10000).
+    osmium::memory::Buffer create_areas() {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+        for (int y = 0; y < 40; ++y) {
+            for (int x = 0; x < 40; ++x) {
+                const double x0 = x * 0.01;
+                const double y0 = y * 0.01;
+                osmium::builder::add_area(buffer,
+                    _id(2 * (y * 40 + x + 1)),
+                    _outer_ring({
+                        {1, {x0,        y0}},
+                        {2, {x0 + 0.01, y0}},
+                        {3, {x0 + 0.01, y0 + 0.01}},
+                        {4, {x0,        y0 + 0.01}},
+                        {1, {x0,        y0}}
+                    })
+                );
+            }
+        }
+
+        osmium::builder::add_area(buffer,
+            _id(10000),
+            _outer_ring({
+                {1, {1.0, 1.0}},
+                {2, {2.0, 1.0}},
+                {3, {2.0, 2.0}},
+                {4, {1.0, 2.0}},
+                {1, {1.0, 1.0}}
+            }),
+            _inner_ring({
+                {5, {1.2, 1.2}},
+                {6, {1.2, 1.8}},
+                {7, {1.8, 1.8}},
+                {8, {1.8, 1.2}},
+                {5, {1.2, 1.2}}
+            })
+        );
+
+        return buffer;
+    }
+
+    const osmium::Area& area_with_hole(const osmium::memory::Buffer& buffer) {
+        const osmium::Area* result = nullptr;
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            result = &area;
+        }
+        REQUIRE(result);
+        REQUIRE(result->id() == 10000);
+        return *result;
+    }
+
+    std::vector<osmium::object_id_type> containing(const osmium::index::AreaIndex& index, const osmium::memory::Buffer& buffer, const osmium::Location location) {
+        std::vector<osmium::object_id_type> ids;
+        index.find_containing(buffer, location, [&ids](const osmium::Area& area) {
+            ids.push_back(area.id());
+        });
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    std::vector<osmium::object_id_type> intersecting(const osmium::index::AreaIndex& index, const osmium::memory::Buffer& buffer, const osmium::Box& box) {
+        std::vector<osmium::object_id_type> ids;
+        index.find_intersecting(buffer, box, [&ids](const osmium::Area& area) {
+            ids.push_back(area.id());
+        });
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    std::vector<osmium::Location> test_locations() {
+        std::vector<osmium::Location> locations;
+        uint32_t state = 1;
+        for (int i = 0; i < 500; ++i) {
+            state = state * 1103515245U + 12345U;
+            const double x = static_cast<double>((state >> 8U) % 25000U) / 10000.0;
+            state = state * 1103515245U + 12345U;
+            const double y = static_cast<double>((state >> 8U) % 25000U) / 10000.0;
+            locations.emplace_back(x + 0.00001, y + 0.00001);
+        }
+        return locations;
+    }
+
+    void check_index(const osmium::index::AreaIndex& index, const osmium::memory::Buffer& buffer) {
+        REQUIRE(index.size() == 1601);
+        REQUIRE(index.bbox() == osmium::Box(0.0, 0.0, 2.0, 2.0));
+
+        REQUIRE(containing(index, buffer, osmium::Location{0.005, 0.005}) == std::vector<osmium::object_id_type>{2});
+        REQUIRE(containing(index, buffer, osmium::Location{0.395, 0.015}) == std::vector<osmium::object_id_type>{2 * 80});
+        REQUIRE(containing(index, buffer, osmium::Location{1.1, 1.1}) == std::vector<osmium::object_id_type>{10000});
+        REQUIRE(containing(index, buffer, osmium::Location{1.5, 1.5}).empty()); // in the hole
+        REQUIRE(containing(index, buffer, osmium::Location{0.5, 0.5}).empty());
+        REQUIRE(containing(index, buffer, osmium::Location{}).empty());
+
+        REQUIRE(intersecting(index, buffer, osmium::Box{1.3, 1.3, 1.7, 1.7}).empty()); // in the hole
+        REQUIRE(intersecting(index, buffer, osmium::Box{1.3, 1.3, 1.9, 1.7}) == std::vector<osmium::object_id_type>{10000});
+        REQUIRE(intersecting(index, buffer, osmium::Box{0.0, 0.0, 3.0, 3.0}).size() == 1601);
+        REQUIRE(intersecting(index, buffer, osmium::Box{}).empty());
+
+        // Compare with checking all areas.
+        for (const auto& location : test_locations()) {
+            std::vector<osmium::object_id_type> expected;
+            for (const auto& area : buffer.select<osmium::Area>()) {
+                if (osmium::index::area_contains(area, location)) {
+                    expected.push_back(area.id());
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            REQUIRE(containing(index, buffer, location) == expected);
+        }
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Location in area") {
+    const auto buffer = create_areas();
+    const auto& area = area_with_hole(buffer);
+
+    REQUIRE(osmium::index::area_contains(area, osmium::Location{1.1, 1.1}));
+    REQUIRE(osmium::index::area_contains(area, osmium::Location{1.9, 1.5}));
+    REQUIRE_FALSE(osmium::index::area_contains(area, osmium::Location{1.5, 1.5}));
+    REQUIRE_FALSE(osmium::index::area_contains(area, osmium::Location{0.5, 1.5}));
+    REQUIRE_FALSE(osmium::index::area_contains(area, osmium::Location{2.5, 1.5}));
+}
+
+TEST_CASE("Box intersecting area") {
+    const auto buffer = create_areas();
+    const auto& area = area_with_hole(buffer);
+
+    REQUIRE(osmium::index::area_intersects(area, osmium::Box{0.0, 0.0, 3.0, 3.0})); // area inside box
+    REQUIRE(osmium::index::area_intersects(area, osmium::Box{1.05, 1.05, 1.1, 1.1})); // box inside area
+    REQUIRE(osmium::index::area_intersects(area, osmium::Box{0.5, 1.5, 1.5, 1.6})); // crossing outer ring
+    REQUIRE(osmium::index::area_intersects(area, osmium::Box{1.5, 1.5, 1.9, 1.6})); // crossing inner ring
+    REQUIRE(osmium::index::area_intersects(area, osmium::Box{0.5, 1.5, 2.5, 1.6})); // crossing without corner inside
+    REQUIRE_FALSE(osmium::index::area_intersects(area, osmium::Box{1.3, 1.3, 1.7, 1.7})); // in hole
+    REQUIRE_FALSE(osmium::index::area_intersects(area, osmium::Box{2.5, 2.5, 3.0, 3.0}));
+}
+
+TEST_CASE("Empty area index") {
+    const osmium::memory::Buffer buffer{1024};
+    const osmium::index::AreaIndex index{buffer};
+
+    REQUIRE(index.empty());
+    REQUIRE(index.size() == 0);
+    REQUIRE_FALSE(index.bbox().valid());
+    REQUIRE(containing(index, buffer, osmium::Location{1.0, 1.0}).empty());
+    REQUIRE(intersecting(index, buffer, osmium::Box{0.0, 0.0, 3.0, 3.0}).empty());
+}
+
+TEST_CASE("Area index with single area") {
+    osmium::memory::Buffer buffer{1024};
+    osmium::builder::add_area(buffer,
+        _id(4),
+        _outer_ring({
+            {1, {1.0, 1.0}},
+            {2, {2.0, 1.0}},
+            {3, {2.0, 2.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+
+    const osmium::index::AreaIndex index{buffer};
+    REQUIRE(index.size() == 1);
+    REQUIRE(index.levels() == 1);
+    REQUIRE(containing(index, buffer, osmium::Location{1.9, 1.1}) == std::vector<osmium::object_id_type>{4});
+    REQUIRE(containing(index, buffer, osmium::Location{1.1, 1.9}).empty());
+}
+
+TEST_CASE("Area index queries") {
+    const auto buffer = create_areas();
+    const osmium::index::AreaIndex index{buffer};
+    REQUIRE(index.levels() == 4);
+
+    check_index(index, buffer);
+
+    std::size_t count = 0;
+    index.query(osmium::Box{0.0, 0.0, 0.015, 0.015}, [&](uint64_t offset) {
+        REQUIRE(buffer.get<osmium::Area>(static_cast<std::size_t>(offset)).id() <= 2 * 42);
+        ++count;
+    });
+    REQUIRE(count == 4);
+}
+
+TEST_CASE("Batched area index queries") {
+    const auto buffer = create_areas();
+    const osmium::index::AreaIndex index{buffer};
+
+    const auto locations = test_locations();
+    std::vector<std::vector<osmium::object_id_type>> results(locations.size());
+    index.find_containing(buffer, locations, [&](std::size_t n, const osmium::Area& area) {
+        results[n].push_back(area.id());
+    });
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        std::sort(results[n].begin(), results[n].end());
+        REQUIRE(results[n] == containing(index, buffer, locations[n]));
+    }
+
+    const std::vector<osmium::Box> boxes = {
+        osmium::Box{1.3, 1.3, 1.7, 1.7},
+        osmium::Box{0.0, 0.0, 0.015, 0.015},
+        osmium::Box{1.3, 1.3, 1.9, 1.7}
+    };
+    std::vector<std::vector<osmium::object_id_type>> box_results(boxes.size());
+    index.find_intersecting(buffer, boxes, [&](std::size_t n, const osmium::Area& area) {
+        box_results[n].push_back(area.id());
+    });
+    for (std::size_t n = 0; n < boxes.size(); ++n) {
+        std::sort(box_results[n].begin(), box_results[n].end());
+        REQUIRE(box_results[n] == intersecting(index, buffer, boxes[n]));
+    }
+    REQUIRE(box_results[0].empty());
+    REQUIRE(box_results[1].size() == 4);
+    REQUIRE(box_results[2].size() == 1);
+}
+
+TEST_CASE("Dump area index and load or map it") {
+    const auto buffer = create_areas();
+    const osmium::index::AreaIndex index{buffer};
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.dump(fd);
+    REQUIRE(osmium::file_size(fd) > 1601 * sizeof(osmium::index::AreaIndex::entry_type));
+
+    SECTION("load") {
+        osmium::file_seek(fd, 0);
+        osmium::index::AreaIndex loaded;
+        loaded.load(fd);
+        REQUIRE(loaded.levels() == index.levels());
+        check_index(loaded, buffer);
+    }
+
+    SECTION("map") {
+        osmium::index::AreaIndex mapped;
+        mapped.map(fd);
+        REQUIRE(mapped.levels() == index.levels());
+        check_index(mapped, buffer);
+
+        // still works after move
+        osmium::index::AreaIndex moved{std::move(mapped)};
+        check_index(moved, buffer);
+    }
+}
+
+TEST_CASE("Loading something that isn't an area index fails") {
+    const int fd = osmium::detail::create_tmp_file();
+    const char data[] = "this is not an area index file at all, really";
+    osmium::io::detail::reliable_write(fd, data, sizeof(data));
+
+    osmium::index::AreaIndex index;
+    REQUIRE_THROWS_AS(index.map(fd), std::runtime_error);
+    osmium::file_seek(fd, 0);
+    REQUIRE_THROWS_AS(index.load(fd), std::runtime_error);
+}
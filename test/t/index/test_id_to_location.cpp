@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include <osmium/index/map/compressed_mem.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
@@ -132,6 +133,20 @@ TEST_CASE("Map Id to location: DenseMmapArray") {
     index_type index2;
     test_func_real<index_type>(index2);
 }
+
+TEST_CASE("Map Id to location: DenseMmapArray with huge pages and NUMA options") {
+    using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    std::unique_ptr<map_type> index1 = map_factory.create_map("dense_mmap_array,hugepages,numa_interleave");
+    test_func_all<map_type>(*index1);
+
+    std::unique_ptr<map_type> index2 = map_factory.create_map("dense_mmap_array,hugepages,numa_local");
+    test_func_real<map_type>(*index2);
+
+    REQUIRE_THROWS_AS(map_factory.create_map("dense_mmap_array,foo"), osmium::map_factory_error);
+    REQUIRE_THROWS_WITH(map_factory.create_map("dense_mmap_array,foo"), "Unknown option 'foo' for map type 'dense_mmap_array'");
+}
 #else
 # pragma message("not running 'DenseMmapArray' test case on this machine")
 #endif
@@ -238,6 +253,64 @@ TEST_CASE("Map Id to location: FlexMem switch") {
     REQUIRE(index.get_noexcept(2000000000) == osmium::Location{});
 }
 
+TEST_CASE("Map Id to location: CompressedMem") {
+    using index_type = osmium::index::map::CompressedMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: CompressedMem with many locations") {
+    using index_type = osmium::index::map::CompressedMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const auto location = [](osmium::unsigned_object_id_type id) {
+        return osmium::Location{static_cast<int32_t>(id % 1000) * 10 - 1800000000,
+                                static_cast<int32_t>(id) * 17 - 900000000};
+    };
+
+    index_type index;
+
+    SECTION("sorted") {
+        for (osmium::unsigned_object_id_type id = 1; id < 100000; ++id) {
+            if (id % 10 != 0) {
+                index.set(id, location(id));
+            }
+        }
+    }
+
+    SECTION("unsorted") {
+        for (osmium::unsigned_object_id_type id = 99999; id > 0; --id) {
+            if (id % 10 != 0) {
+                index.set(id, location(id));
+            }
+        }
+        index.set(4, osmium::Location{1, 2});
+        index.set(4, location(4));
+        index.sort();
+    }
+
+    REQUIRE(index.size() == 90000);
+    REQUIRE(index.used_memory() < 90000 * sizeof(osmium::Location) / 2);
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    for (osmium::unsigned_object_id_type id = 1; id < 100000; ++id) {
+        if (id % 10 != 0) {
+            REQUIRE(index.get(id) == location(id));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+    REQUIRE(index.get_noexcept(100000000) == osmium::Location{});
+
+    const osmium::Location invalid{};
+    index.set(200000, invalid);
+    index.set(200001, osmium::Location{-1800000000, 900000000});
+    REQUIRE_THROWS_AS(index.get(200000), osmium::not_found);
+    REQUIRE(index.get(200001) == osmium::Location(-1800000000, 900000000));
+}
+
 TEST_CASE("Map Id to location: Dynamic map choice") {
     using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
     const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
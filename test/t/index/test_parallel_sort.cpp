@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::vector<std::pair<uint64_t, uint64_t>> create_test_data(std::size_t size) {
+    std::mt19937_64 generator{42}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::vector<std::pair<uint64_t, uint64_t>> data;
+    data.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data.emplace_back(generator() % 1000000, i);
+    }
+    return data;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Parallel sort of small range") {
+    auto data = create_test_data(1000);
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+
+    osmium::thread::Pool pool{4};
+    osmium::index::detail::parallel_sort(pool, data.begin(), data.end(), std::less<>{});
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Parallel sort of large range") {
+    auto data = create_test_data(3 * osmium::index::detail::min_parallel_sort_size + 17);
+    auto expected = data;
+
+    SECTION("with default comparison") {
+        std::sort(expected.begin(), expected.end());
+        osmium::thread::Pool pool{3};
+        osmium::index::detail::parallel_sort(pool, data.begin(), data.end(), std::less<>{});
+    }
+
+    SECTION("with own comparison") {
+        std::sort(expected.begin(), expected.end(), std::greater<>{});
+        osmium::thread::Pool pool{4};
+        osmium::index::detail::parallel_sort(pool, data.begin(), data.end(), std::greater<>{});
+    }
+
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Sorting large sparse index") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const osmium::unsigned_object_id_type size = 2 * osmium::index::detail::min_parallel_sort_size;
+
+    index_type index;
+    for (osmium::unsigned_object_id_type id = size; id > 0; --id) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), 1});
+    }
+    osmium::thread::Pool pool{4};
+    index.sort_parallel(pool);
+
+    REQUIRE(std::is_sorted(index.cbegin(), index.cend()));
+    REQUIRE(index.get(1) == osmium::Location(1, 1));
+    REQUIRE(index.get(size) == osmium::Location(static_cast<int32_t>(size), 1));
+}
+
+TEST_CASE("Sorting large flex mem index through the map interface") {
+    using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const osmium::unsigned_object_id_type size = 2 * osmium::index::detail::min_parallel_sort_size;
+
+    // Sparse ids so the index stays in sparse mode.
+    osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> flex_index;
+    map_type& index = flex_index;
+    for (osmium::unsigned_object_id_type id = size; id > 0; --id) {
+        index.set(id * 1000, osmium::Location{static_cast<int32_t>(id), 1});
+    }
+    REQUIRE_FALSE(flex_index.is_dense());
+
+    osmium::thread::Pool pool{4};
+    index.sort_parallel(pool);
+
+    for (osmium::unsigned_object_id_type id = 1; id <= size; id += 997) {
+        REQUIRE(index.get(id * 1000) == osmium::Location(static_cast<int32_t>(id), 1));
+    }
+    REQUIRE(index.get(size * 1000) == osmium::Location(static_cast<int32_t>(size), 1));
+}
+
+TEST_CASE("Parallel sort called from a task in the same pool") {
+    auto data = create_test_data(2 * osmium::index::detail::min_parallel_sort_size);
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+
+    osmium::thread::Pool pool{2};
+    REQUIRE_FALSE(pool.is_pool_thread());
+    std::vector<std::future<bool>> futures;
+    for (int i = 0; i < 2; ++i) {
+        futures.push_back(pool.submit([&pool]() {
+            return pool.is_pool_thread();
+        }));
+    }
+    for (auto& future : futures) {
+        REQUIRE(future.get());
+    }
+
+    // This would deadlock if the sort waited for other tasks.
+    auto future = pool.submit([&pool, &data]() {
+        osmium::index::detail::parallel_sort(pool, data.begin(), data.end());
+    });
+    future.get();
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Parallel sort of range with many equal elements") {
+    std::vector<uint64_t> data(3 * osmium::index::detail::min_parallel_sort_size + 5);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = (data.size() - i) % 7;
+    }
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+
+    osmium::thread::Pool pool{5};
+    osmium::index::detail::parallel_sort(pool, data.begin(), data.end());
+    REQUIRE(data == expected);
+}
@@ -4,6 +4,7 @@
 
 #include <osmium/io/bzip2_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <string>
 
@@ -150,3 +151,99 @@ TEST_CASE("Write bzip2-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+TEST_CASE("Write bzip2-compressed file in parallel blocks") {
+    const int count = count_fds();
+
+    std::string input;
+    for (int i = 0; i < 100000; ++i) {
+        input += std::to_string(i);
+        input += '\n';
+    }
+
+    const std::string output_file = "test_bzip2_block_out.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    osmium::thread::Pool pool{2};
+    const auto compressor = osmium::io::CompressionFactory::instance().create_block_compressor(
+        osmium::io::file_compression::bzip2, fd, osmium::io::fsync::no, pool, 10000);
+    compressor->write(input.substr(0, 12345));
+    compressor->write(input.substr(12345));
+    compressor->close();
+    REQUIRE(compressor->file_size() == osmium::file_size(output_file));
+
+    REQUIRE(count == count_fds());
+
+    const int fd_in = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::Bzip2Decompressor decomp{fd_in};
+    std::string result;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        result += data;
+    }
+    decomp.close();
+
+    REQUIRE(result == input);
+}
+
+TEST_CASE("Write empty bzip2-compressed file in parallel blocks") {
+    const std::string output_file = "test_bzip2_block_out.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    osmium::thread::Pool pool{2};
+    const auto compressor = osmium::io::CompressionFactory::instance().create_block_compressor(
+        osmium::io::file_compression::bzip2, fd, osmium::io::fsync::no, pool, 10000);
+    compressor->close();
+    REQUIRE(osmium::file_size(output_file) > 0);
+
+    const int fd_in = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::Bzip2Decompressor decomp{fd_in};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+}
+
+TEST_CASE("Read multi-stream bzip2 file in parallel") {
+    const int count = count_fds();
+
+    std::string input;
+    for (int i = 0; i < 300000; ++i) {
+        input += std::to_string(i * 7 % 100003);
+        input += '\n';
+    }
+
+    const std::string filename = "test_bzip2_multi_stream.bz2";
+    osmium::thread::Pool pool{3};
+    {
+        const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        osmium::io::detail::BlockCompressor compressor{fd, osmium::io::fsync::no, pool, 100000, [](const std::string& block) {
+            return osmium::io::detail::bzip2_compress_stream(block);
+        }};
+        compressor.write(input);
+        compressor.close();
+    }
+
+    std::size_t min_job_size = 0;
+    std::size_t max_job_size = 0;
+
+    SECTION("small jobs") {
+        min_job_size = 1000;
+        max_job_size = 1000000;
+    }
+
+    SECTION("fall back to serial decompression") {
+        min_job_size = 1000;
+        max_job_size = 1000;
+    }
+
+    osmium::io::detail::BlockDecompressor<osmium::io::detail::bzip2_stream_inflater> decomp{
+        osmium::io::detail::open_for_reading(filename), pool, min_job_size, max_job_size};
+    std::string result;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        result += data;
+    }
+    decomp.close();
+
+    REQUIRE(result == input);
+    REQUIRE(count == count_fds());
+}
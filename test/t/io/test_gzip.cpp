@@ -3,6 +3,7 @@
 #include "utils.hpp"
 
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/io/gzip_compression.hpp>
 
 #include <string>
@@ -136,3 +137,157 @@ TEST_CASE("Write gzip-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+TEST_CASE("Write gzip-compressed file in parallel blocks") {
+    const int count = count_fds();
+
+    std::string input;
+    for (int i = 0; i < 100000; ++i) {
+        input += std::to_string(i);
+        input += '\n';
+    }
+
+    const std::string output_file = "test_gzip_block_out.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    osmium::thread::Pool pool{2};
+    const auto compressor = osmium::io::CompressionFactory::instance().create_block_compressor(
+        osmium::io::file_compression::gzip, fd, osmium::io::fsync::no, pool, 10000);
+    compressor->write(input.substr(0, 12345));
+    compressor->write(input.substr(12345));
+    compressor->close();
+    REQUIRE(compressor->file_size() == osmium::file_size(output_file));
+
+    REQUIRE(count == count_fds());
+
+    const int fd_in = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::GzipDecompressor decomp{fd_in};
+    std::string result;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        result += data;
+    }
+    decomp.close();
+
+    REQUIRE(result == input);
+}
+
+TEST_CASE("Write empty gzip-compressed file in parallel blocks") {
+    const std::string output_file = "test_gzip_block_out.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    osmium::thread::Pool pool{2};
+    const auto compressor = osmium::io::CompressionFactory::instance().create_block_compressor(
+        osmium::io::file_compression::gzip, fd, osmium::io::fsync::no, pool, 10000);
+    compressor->close();
+    REQUIRE(osmium::file_size(output_file) > 0);
+
+    const int fd_in = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::GzipDecompressor decomp{fd_in};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+}
+
+namespace {
+
+// Incompressible data with something that looks like a gzip header every
+// few kilobytes. Zlib stores this data verbatim in the compressed stream,
+// so the block decompressor will find the fake headers.
+std::string create_data_with_fake_headers(std::size_t size) {
+    std::string data;
+    data.reserve(size);
+    uint32_t state = 12345;
+    while (data.size() < size) {
+        state = state * 1103515245U + 12345U;
+        data += static_cast<char>(state >> 24U);
+        if (data.size() % 5000 == 0) {
+            data.append("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\x03", 10);
+        }
+    }
+    return data;
+}
+
+std::string write_gzip_blocks(const std::string& filename, const std::string& data, std::size_t block_size) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::thread::Pool pool{2};
+    osmium::io::detail::BlockCompressor compressor{fd, osmium::io::fsync::no, pool, block_size, [](const std::string& block) {
+        return osmium::io::detail::gzip_compress_member(block);
+    }};
+    compressor.write(data);
+    compressor.close();
+    return filename;
+}
+
+std::string read_all(osmium::io::Decompressor& decomp) {
+    std::string result;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        result += data;
+    }
+    decomp.close();
+    return result;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Read multi-member gzip file in parallel") {
+    const int count = count_fds();
+
+    const std::string input = create_data_with_fake_headers(3UL * 1024UL * 1024UL);
+    const auto filename = write_gzip_blocks("test_gzip_multi_member.gz", input, 100000);
+
+    osmium::thread::Pool pool{3};
+
+    SECTION("default job sizes") {
+        const auto decomp = osmium::io::CompressionFactory::instance().create_block_decompressor(
+            osmium::io::file_compression::gzip, osmium::io::detail::open_for_reading(filename), pool);
+        REQUIRE(read_all(*decomp) == input);
+    }
+
+    SECTION("small jobs") {
+        osmium::io::detail::BlockDecompressor<osmium::io::detail::gzip_stream_inflater> decomp{
+            osmium::io::detail::open_for_reading(filename), pool, 1000, 1000000};
+        REQUIRE(read_all(decomp) == input);
+    }
+
+    SECTION("fall back to serial decompression") {
+        osmium::io::detail::BlockDecompressor<osmium::io::detail::gzip_stream_inflater> decomp{
+            osmium::io::detail::open_for_reading(filename), pool, 200000, 200000};
+        REQUIRE(read_all(decomp) == input);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read single-member gzip file with block decompressor") {
+    const std::string input = create_data_with_fake_headers(100000);
+    const auto filename = write_gzip_blocks("test_gzip_single_member.gz", input, 1000000);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::detail::BlockDecompressor<osmium::io::detail::gzip_stream_inflater> decomp{
+        osmium::io::detail::open_for_reading(filename), pool, 1000, 1000000};
+    REQUIRE(read_all(decomp) == input);
+}
+
+TEST_CASE("Read truncated multi-member gzip file in parallel") {
+    const std::string input = create_data_with_fake_headers(1000000);
+    const auto filename = write_gzip_blocks("test_gzip_truncated.gz", input, 100000);
+
+    std::string compressed;
+    {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        compressed.resize(osmium::file_size(filename));
+        REQUIRE(osmium::io::detail::read_exactly(fd, &compressed[0], static_cast<unsigned int>(compressed.size())));
+        osmium::io::detail::reliable_close(fd);
+    }
+    compressed.resize(compressed.size() - 100);
+
+    const int fd_out = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd_out, compressed.data(), compressed.size());
+    osmium::io::detail::reliable_close(fd_out);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::detail::BlockDecompressor<osmium::io::detail::gzip_stream_inflater> decomp{
+        osmium::io::detail::open_for_reading(filename), pool, 1000, 1000000};
+    REQUIRE_THROWS_AS(read_all(decomp), osmium::gzip_error);
+}
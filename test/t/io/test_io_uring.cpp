@@ -0,0 +1,151 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/io_uring.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <atomic>
+#include <string>
+
+#ifdef OSMIUM_WITH_IO_URING
+
+#include <unistd.h>
+
+namespace {
+
+// Some data which is not a multiple of the block size.
+std::string test_data() {
+    std::string data;
+    for (int i = 0; data.size() < 5 * 1024 * 1024 + 123; ++i) {
+        data += std::to_string(i);
+        data += '\n';
+    }
+    return data;
+}
+
+void write_test_file(const std::string& filename, const std::string& data) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+}
+
+} // anonymous namespace
+
+TEST_CASE("io_uring can not be used on pipes") {
+    int pipefd[2];
+    REQUIRE(::pipe(pipefd) == 0);
+    REQUIRE_FALSE(osmium::io::detail::make_uring_io<osmium::io::detail::UringReader>(pipefd[0]));
+    REQUIRE_FALSE(osmium::io::detail::make_uring_io<osmium::io::detail::UringWriter>(pipefd[1]));
+    ::close(pipefd[0]);
+    ::close(pipefd[1]);
+}
+
+TEST_CASE("Read file with UringReader") {
+    const std::string filename = "test-io-uring-read.txt";
+    const std::string data = test_data();
+    write_test_file(filename, data);
+
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    auto reader = osmium::io::detail::make_uring_io<osmium::io::detail::UringReader>(fd);
+    if (!reader) {
+        WARN("io_uring not available");
+        ::close(fd);
+        return;
+    }
+
+    SECTION("in blocks") {
+        std::string all;
+        for (std::string block = reader->read(); !block.empty(); block = reader->read()) {
+            REQUIRE(block.size() <= 1024 * 1024);
+            all += block;
+        }
+        REQUIRE(all == data);
+        REQUIRE(reader->read().empty());
+    }
+
+    SECTION("in small pieces") {
+        std::string all;
+        std::string piece(1000, ' ');
+        while (reader->read_exactly(&piece[0], piece.size())) {
+            all += piece;
+        }
+        REQUIRE(all.size() == data.size() - data.size() % piece.size());
+        REQUIRE(all == data.substr(0, all.size()));
+    }
+
+    SECTION("file position is set to end of consumed data") {
+        std::string piece(1234, ' ');
+        REQUIRE(reader->read_exactly(&piece[0], piece.size()));
+        reader.reset();
+        REQUIRE(::lseek(fd, 0, SEEK_CUR) == 1234);
+    }
+
+    reader.reset();
+    ::close(fd);
+}
+
+TEST_CASE("Write file with UringWriter") {
+    const std::string filename = "test-io-uring-write.txt";
+    const std::string data = test_data();
+
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    auto writer = osmium::io::detail::make_uring_io<osmium::io::detail::UringWriter>(fd);
+    if (!writer) {
+        WARN("io_uring not available");
+        ::close(fd);
+        return;
+    }
+
+    for (std::size_t pos = 0; pos < data.size(); pos += 100000) {
+        writer->write(data.substr(pos, 100000));
+    }
+    writer->flush();
+    REQUIRE(::lseek(fd, 0, SEEK_CUR) == static_cast<off_t>(data.size()));
+    writer.reset();
+    osmium::io::detail::reliable_close(fd);
+
+    const int rfd = osmium::io::detail::open_for_reading(filename);
+    std::string result(data.size() + 1, ' ');
+    REQUIRE(osmium::io::detail::read_exactly(rfd, &result[0], static_cast<unsigned int>(data.size())));
+    REQUIRE(::read(rfd, &result[data.size()], 1) == 0);
+    result.resize(data.size());
+    REQUIRE(result == data);
+    ::close(rfd);
+}
+
+TEST_CASE("Write and read uncompressed file with io_uring") {
+    const int count = count_fds();
+
+    const std::string filename = "test-io-uring-compression.txt";
+    const std::string data = test_data();
+
+    {
+        const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        osmium::io::NoCompressor comp{fd, osmium::io::fsync::no};
+        comp.write(data.substr(0, 1000));
+        comp.write_owned(data.substr(1000, 5000));
+        comp.write(data.substr(6000));
+        comp.close();
+        REQUIRE(comp.file_size() == data.size());
+    }
+
+    {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::NoDecompressor decomp{fd};
+        std::atomic<std::size_t> offset{0};
+        decomp.set_offset_ptr(&offset);
+        std::string all;
+        for (std::string block = decomp.read(); !block.empty(); block = decomp.read()) {
+            all += block;
+        }
+        decomp.close();
+        REQUIRE(all == data);
+        REQUIRE(offset == data.size());
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+#endif
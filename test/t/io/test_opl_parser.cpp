@@ -3,11 +3,14 @@
 #include "utils.hpp"
 
 #include <osmium/io/detail/opl_input_format.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/opl_input.hpp>
 #include <osmium/opl.hpp>
+#include <osmium/osm/object.hpp>
 
 #include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <initializer_list>
 #include <string>
 #include <utility>
@@ -1160,6 +1163,172 @@ TEST_CASE("Parse OPL with missing newline using Reader") {
     REQUIRE(node.id() == 1);
 }
 
+TEST_CASE("Count OPL lines") {
+    const std::string data{"n1\n\nn2\r\nw3\rr4"};
+    REQUIRE(oid::count_opl_lines(data.data(), 0) == 0);
+    REQUIRE(oid::count_opl_lines(data.data(), 2) == 1);
+    REQUIRE(oid::count_opl_lines(data.data(), data.size()) == 4);
+    REQUIRE(oid::count_opl_lines("\n\r\n", 3) == 0);
+}
+
+namespace {
+
+// Write an OPL file big enough to be split into several chunks
+// when parsed in parallel.
+void write_big_opl_file(const std::string& filename, bool with_error = false, char eol = '\n') {
+    std::ofstream out{filename, std::ios::binary};
+    for (int i = 1; i <= 40000; ++i) {
+        out << 'n' << i << " v1 dV c1 t2020-01-01T00:00:00Z i1 uuser Tname=node%20%" << i << " x1.5 y2.5" << eol;
+        if (i % 1000 == 0) {
+            out << eol << "# comment\r" << eol;
+        }
+    }
+    if (with_error) {
+        out << "n40001 v1 Q" << eol;
+    }
+    for (int i = 1; i <= 20000; ++i) {
+        out << 'w' << i << " v1 dV c1 t2020-01-01T00:00:00Z i1 uuser Thighway=residential Nn" << i << ",n" << (i + 1) << eol;
+    }
+    for (int i = 1; i <= 10; ++i) {
+        out << 'r' << i << " v1 dV c1 t2020-01-01T00:00:00Z i1 uuser T Mw" << i << "@outer" << eol;
+    }
+}
+
+struct opl_read_result {
+    std::vector<osmium::object_id_type> ids;
+    std::size_t num_buffers = 0;
+    bool buffers_have_single_type = true;
+};
+
+template <typename... TArgs>
+opl_read_result read_opl_file(const osmium::io::File& file, TArgs&&... args) {
+    opl_read_result result;
+    osmium::io::Reader reader{file, std::forward<TArgs>(args)...};
+    while (const auto buffer = reader.read()) {
+        ++result.num_buffers;
+        auto type = osmium::item_type::undefined;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (type != osmium::item_type::undefined && type != object.type()) {
+                result.buffers_have_single_type = false;
+            }
+            type = object.type();
+            result.ids.push_back(type == osmium::item_type::node ? object.id() : -object.id());
+        }
+    }
+    reader.close();
+    return result;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Parse OPL in parallel gives same result as sequential parse") {
+    const std::string filename = "test-opl-parallel.opl";
+    write_big_opl_file(filename);
+
+    const auto serial = read_opl_file(osmium::io::File{filename});
+    REQUIRE(serial.ids.size() == 60010);
+
+    osmium::io::File file{filename};
+    file.set("parallel_parsing");
+
+    SECTION("from input queue") {
+        const auto parallel = read_opl_file(file);
+        REQUIRE(parallel.ids == serial.ids);
+        REQUIRE(parallel.num_buffers > 1);
+    }
+
+    SECTION("from memory mapping") {
+        const int count = count_fds();
+        osmium::io::Reader reader{file, osmium::io::use_mmap::yes};
+        std::size_t num = 0;
+        while (const auto buffer = reader.read()) {
+            num += buffer.select<osmium::OSMObject>().size();
+        }
+        REQUIRE(num == serial.ids.size());
+        REQUIRE(reader.offset() == reader.file_size());
+        reader.close();
+        REQUIRE(count == count_fds());
+    }
+
+    SECTION("with own pool") {
+        osmium::thread::Pool pool{3};
+        REQUIRE(read_opl_file(file, pool).ids == serial.ids);
+    }
+
+    SECTION("with only some entity types") {
+        const auto parallel = read_opl_file(file, osmium::osm_entity_bits::way);
+        REQUIRE(parallel.ids.size() == 20000);
+        REQUIRE(parallel.ids.front() == -1);
+        REQUIRE(parallel.ids.back() == -20000);
+    }
+
+    SECTION("with single type buffers") {
+        const auto parallel = read_opl_file(file, osmium::io::buffers_type::single);
+        REQUIRE(parallel.ids == serial.ids);
+        REQUIRE(parallel.buffers_have_single_type);
+    }
+}
+
+TEST_CASE("Parse OPL file with CR line endings in parallel") {
+    const std::string filename = "test-opl-parallel-cr.opl";
+    write_big_opl_file(filename, false, '\r');
+
+    const auto serial = read_opl_file(osmium::io::File{filename});
+    REQUIRE(serial.ids.size() == 60010);
+
+    osmium::io::File file{filename};
+    file.set("parallel_parsing");
+
+    SECTION("from input queue") {
+        REQUIRE(read_opl_file(file).ids == serial.ids);
+    }
+
+    SECTION("from memory mapping") {
+        const auto parallel = read_opl_file(file, osmium::io::use_mmap::yes);
+        REQUIRE(parallel.ids == serial.ids);
+        REQUIRE(parallel.num_buffers > 1);
+    }
+}
+
+TEST_CASE("Parse small OPL files in parallel") {
+    for (const auto* filename : {"t/io/data.opl",
+                                 "t/io/data-cr.opl",
+                                 "t/io/data-nonl.opl",
+                                 "t/io/data-n5w1r3.osm.opl"}) {
+        const auto serial = read_opl_file(osmium::io::File{with_data_dir(filename)});
+        osmium::io::File file{with_data_dir(filename)};
+        file.set("parallel_parsing");
+        REQUIRE(read_opl_file(file).ids == serial.ids);
+    }
+}
+
+TEST_CASE("Parse OPL in parallel reports error with correct line number") {
+    const std::string filename = "test-opl-parallel-error.opl";
+    write_big_opl_file(filename, true);
+
+    uint64_t line = 0;
+    uint64_t column = 0;
+    try {
+        read_opl_file(osmium::io::File{filename});
+        REQUIRE(false);
+    } catch (const osmium::opl_error& e) {
+        line = e.line;
+        column = e.column;
+    }
+    REQUIRE(line == 40040);
+
+    osmium::io::File file{filename};
+    file.set("parallel_parsing");
+
+    try {
+        read_opl_file(file);
+        REQUIRE(false);
+    } catch (const osmium::opl_error& e) {
+        REQUIRE(e.line == line);
+        REQUIRE(e.column == column);
+    }
+}
+
 class lbl_tester {
 
     std::vector<std::string> m_inputs;
@@ -1204,6 +1373,15 @@ void check_lbl(const std::initializer_list<std::string>& in,
     lbl_tester tester{in, out};
     osmium::io::detail::line_by_line(tester);
     tester.check();
+
+    // same data all in one block of memory
+    std::string data;
+    for (const auto& chunk : in) {
+        data += chunk;
+    }
+    lbl_tester memory_tester{{}, out};
+    osmium::io::detail::line_by_line(data.data(), data.size(), memory_tester);
+    memory_tester.check();
 }
 
 } // anonymous namespace
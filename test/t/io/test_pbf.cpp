@@ -2,9 +2,31 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/util/file.hpp>
+
+#include <protozero/pbf_builder.hpp>
+#include <protozero/pbf_reader.hpp>
+#include <protozero/pbf_writer.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef OSMIUM_WITH_LZMA
+# include <lzma.h>
+#endif
 
 TEST_CASE("Get supported PBF compression types") {
     const auto types = osmium::io::supported_pbf_compression_types();
@@ -50,3 +72,307 @@ TEST_CASE("Read PBF file with version=-1 and changeset=-1 and DenseNodes (writte
     REQUIRE(object.version() == 0);
     REQUIRE(object.changeset() == 0);
 }
+
+TEST_CASE("Decode packed varint column") {
+    std::string data;
+    {
+        protozero::pbf_writer pbf{data};
+        std::vector<int64_t> values;
+        for (int64_t i = -20; i < 20; ++i) {
+            values.push_back(i);
+        }
+        values.push_back(1000000);
+        values.push_back(-1);
+        values.push_back(std::numeric_limits<int64_t>::max());
+        values.push_back(std::numeric_limits<int64_t>::min());
+        for (int64_t i = 0; i < 10; ++i) {
+            values.push_back(i);
+        }
+        pbf.add_packed_sint64(1, values.cbegin(), values.cend());
+    }
+
+    protozero::pbf_reader reader{data};
+    REQUIRE(reader.next());
+    osmium::io::detail::values_access_sint64 access{reader.get_view()};
+
+    std::vector<int64_t> column;
+    access.decode_sint64_column(column);
+    REQUIRE(access.empty());
+    REQUIRE(column.size() == 54);
+    REQUIRE(column[0] == -20);
+    REQUIRE(column[39] == 19);
+    REQUIRE(column[40] == 1000000);
+    REQUIRE(column[41] == -1);
+    REQUIRE(column[42] == std::numeric_limits<int64_t>::max());
+    REQUIRE(column[43] == std::numeric_limits<int64_t>::min());
+    REQUIRE(column[53] == 9);
+
+    osmium::io::detail::values_access_sint64 single{int64_t{-7}};
+    single.decode_sint64_column(column);
+    REQUIRE(column.size() == 1);
+    REQUIRE(column[0] == -7);
+
+    osmium::io::detail::values_access_sint64 none;
+    none.decode_sint64_column(column);
+    REQUIRE(column.empty());
+}
+
+TEST_CASE("Delta decode column") {
+    std::vector<int64_t> column{5, 1, -3, 0, 10};
+    osmium::io::detail::delta_decode_column(column);
+    REQUIRE(column == std::vector<int64_t>({5, 6, 3, 3, 13}));
+}
+
+TEST_CASE("Write and read DenseNodes with metadata") {
+    const std::string filename{"test-pbf-dense-nodes.osh.pbf"};
+
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 0; i < 1000; ++i) {
+        const osmium::object_id_type id = (i % 3 == 0) ? i * 100000 : i;
+        osmium::builder::add_node(buffer,
+            osmium::builder::attr::_id(id),
+            osmium::builder::attr::_version(static_cast<osmium::object_version_type>(i % 7 + 1)),
+            osmium::builder::attr::_cid(static_cast<osmium::changeset_id_type>(1000000 - i * 13)),
+            osmium::builder::attr::_timestamp(osmium::Timestamp{static_cast<uint32_t>(1500000000 + i * (i % 2 ? 1 : 17))}),
+            osmium::builder::attr::_uid(static_cast<osmium::user_id_type>(i % 5)),
+            osmium::builder::attr::_user(i % 2 ? "foo" : "bar"),
+            osmium::builder::attr::_visible(i % 11 != 0),
+            osmium::builder::attr::_location((i % 2 ? -1 : 1) * i * 0.1, i * -0.05),
+            osmium::builder::attr::_tag("n", std::to_string(i))
+        );
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(osmium::memory::Buffer{buffer.data(), buffer.committed()});
+    writer.close();
+
+    const osmium::memory::Buffer result = osmium::io::read_file(filename);
+
+    auto it = result.select<osmium::Node>().cbegin();
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        REQUIRE(it != result.select<osmium::Node>().cend());
+        REQUIRE(it->id() == node.id());
+        REQUIRE(it->version() == node.version());
+        REQUIRE(it->changeset() == node.changeset());
+        REQUIRE(it->timestamp() == node.timestamp());
+        REQUIRE(it->uid() == node.uid());
+        REQUIRE(std::string{it->user()} == node.user());
+        REQUIRE(it->visible() == node.visible());
+        if (node.visible()) {
+            REQUIRE(it->location() == node.location());
+        }
+        REQUIRE(std::string{it->tags()["n"]} == node.tags()["n"]);
+        ++it;
+    }
+    REQUIRE(it == result.select<osmium::Node>().cend());
+}
+
+namespace {
+
+osmium::memory::Buffer create_parallel_encoding_test_data() {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int i = 1; i <= 20001; ++i) {
+        osmium::builder::add_node(buffer,
+            osmium::builder::attr::_id(i),
+            osmium::builder::attr::_location(i * 0.0001, 1.0),
+            osmium::builder::attr::_tag("i", std::to_string(i % 100))
+        );
+    }
+
+    for (int i = 1; i <= 10000; ++i) {
+        osmium::builder::add_way(buffer,
+            osmium::builder::attr::_id(i),
+            osmium::builder::attr::_nodes({i, i + 1}),
+            osmium::builder::attr::_tag("highway", "road")
+        );
+    }
+
+    for (int i = 1; i <= 100; ++i) {
+        osmium::builder::add_relation(buffer,
+            osmium::builder::attr::_id(i),
+            osmium::builder::attr::_member(osmium::item_type::way, i, "outer")
+        );
+    }
+
+    return buffer;
+}
+
+void write_in_chunks(const std::string& filename, const char* format) {
+    const auto data = create_parallel_encoding_test_data();
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    int n = 0;
+    for (const auto& object : data.select<osmium::OSMObject>()) {
+        buffer.add_item(object);
+        buffer.commit();
+        if (++n % 3000 == 0) {
+            writer(std::move(buffer));
+            buffer = osmium::memory::Buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        }
+    }
+    writer(std::move(buffer));
+    writer.close();
+}
+
+std::vector<std::string> read_objects_as_strings(const std::string& filename) {
+    std::vector<std::string> objects;
+    const auto buffer = osmium::io::read_file(filename);
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        std::string str{osmium::item_type_to_char(object.type())};
+        str += std::to_string(object.id());
+        for (const auto& tag : object.tags()) {
+            str += ' ';
+            str += tag.key();
+            str += '=';
+            str += tag.value();
+        }
+        objects.push_back(std::move(str));
+    }
+    return objects;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Write PBF file with parallel encoding") {
+    write_in_chunks("test-pbf-sequential.osm.pbf", "pbf");
+    const auto expected = read_objects_as_strings("test-pbf-sequential.osm.pbf");
+    REQUIRE(expected.size() == 30101);
+
+    SECTION("with dense nodes") {
+        write_in_chunks("test-pbf-parallel-1.osm.pbf", "pbf,pbf_parallel_encoding=true");
+        write_in_chunks("test-pbf-parallel-2.osm.pbf", "pbf,pbf_parallel_encoding=true");
+        REQUIRE(read_objects_as_strings("test-pbf-parallel-1.osm.pbf") == expected);
+
+        // output must not depend on scheduling of the encoding tasks
+        const auto size = osmium::file_size("test-pbf-parallel-1.osm.pbf");
+        REQUIRE(size == osmium::file_size("test-pbf-parallel-2.osm.pbf"));
+        std::ifstream in1{"test-pbf-parallel-1.osm.pbf", std::ios::binary};
+        std::ifstream in2{"test-pbf-parallel-2.osm.pbf", std::ios::binary};
+        const std::string content1{std::istreambuf_iterator<char>{in1}, std::istreambuf_iterator<char>{}};
+        const std::string content2{std::istreambuf_iterator<char>{in2}, std::istreambuf_iterator<char>{}};
+        REQUIRE(content1 == content2);
+    }
+
+    SECTION("without dense nodes") {
+        write_in_chunks("test-pbf-parallel-1.osm.pbf", "pbf,pbf_parallel_encoding=true,pbf_dense_nodes=false");
+        REQUIRE(read_objects_as_strings("test-pbf-parallel-1.osm.pbf") == expected);
+    }
+}
+
+TEST_CASE("Read and write PBF file using a buffer pool") {
+    write_in_chunks("test-pbf-sequential.osm.pbf", "pbf");
+    const auto expected = read_objects_as_strings("test-pbf-sequential.osm.pbf");
+
+    osmium::memory::BufferPool pool;
+
+    const auto read_with_pool = [&pool]() {
+        std::vector<std::string> objects;
+        osmium::io::Reader reader{"test-pbf-sequential.osm.pbf", pool};
+        while (auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                objects.push_back(std::string{osmium::item_type_to_char(object.type())} + std::to_string(object.id()));
+            }
+            pool.put(std::move(buffer));
+        }
+        reader.close();
+        return objects;
+    };
+
+    auto objects = read_with_pool();
+    REQUIRE(objects.size() == expected.size());
+    const auto puts = pool.stats().puts;
+    REQUIRE(puts > 0);
+
+    // The second time all buffers come from the pool.
+    REQUIRE(read_with_pool() == objects);
+    const auto stats = pool.stats();
+    REQUIRE(stats.hits >= puts);
+    REQUIRE(stats.hit_rate() >= 0.5);
+    REQUIRE(stats.peak_pooled_bytes > 0);
+
+    // The writer hands all buffers back to the pool.
+    SECTION("sequential encoding") {
+        osmium::io::Writer writer{osmium::io::File{"test-pbf-pool.osm.pbf", "pbf"}, pool, osmium::io::overwrite::allow};
+        osmium::io::Reader reader{"test-pbf-sequential.osm.pbf", pool};
+        while (auto buffer = reader.read()) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+        reader.close();
+    }
+
+    SECTION("parallel encoding") {
+        osmium::io::Writer writer{osmium::io::File{"test-pbf-pool.osm.pbf", "pbf,pbf_parallel_encoding=true"}, pool, osmium::io::overwrite::allow};
+        osmium::io::Reader reader{"test-pbf-sequential.osm.pbf", pool};
+        while (auto buffer = reader.read()) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+        reader.close();
+    }
+
+    REQUIRE(pool.stats().puts - stats.puts == stats.puts - puts);
+    REQUIRE(read_objects_as_strings("test-pbf-pool.osm.pbf") == expected);
+}
+
+TEST_CASE("Writing lzma compressed PBF files is not supported") {
+    const osmium::io::File file{"test-pbf-lzma.osm.pbf", "pbf,pbf_compression=lzma"};
+    REQUIRE_THROWS_AS(osmium::io::Writer(file, osmium::io::overwrite::allow), std::invalid_argument);
+}
+
+#ifdef OSMIUM_WITH_ZSTD
+TEST_CASE("Write and read zstd compressed PBF file") {
+    const std::string filename{"test-pbf-zstd.osm.pbf"};
+    const osmium::io::File file{filename, "pbf,pbf_compression=zstd,pbf_compression_level=9"};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, osmium::builder::attr::_id(17), osmium::builder::attr::_location(1.2, 3.4));
+
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    osmium::io::Reader reader{filename};
+    const osmium::memory::Buffer result = reader.read();
+    reader.close();
+
+    const auto& node = *result.cbegin<osmium::Node>();
+    REQUIRE(node.id() == 17);
+    REQUIRE(node.location() == osmium::Location(1.2, 3.4));
+}
+
+TEST_CASE("Illegal zstd compression level") {
+    const osmium::io::File file{"test-pbf-zstd.osm.pbf", "pbf,pbf_compression=zstd,pbf_compression_level=0"};
+    REQUIRE_THROWS_AS(osmium::io::Writer(file, osmium::io::overwrite::allow), std::invalid_argument);
+}
+#endif
+
+#ifdef OSMIUM_WITH_LZMA
+TEST_CASE("Decode lzma compressed blob") {
+    const std::string data(10000, 'x');
+
+    std::string compressed(lzma_stream_buffer_bound(data.size()), '\0');
+    std::size_t compressed_size = 0;
+    REQUIRE(lzma_easy_buffer_encode(LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64, nullptr,
+                                    reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+                                    reinterpret_cast<uint8_t*>(&*compressed.begin()), &compressed_size, compressed.size()) == LZMA_OK);
+    compressed.resize(compressed_size);
+
+    std::string blob;
+    protozero::pbf_builder<osmium::io::detail::FileFormat::Blob> pbf_blob{blob};
+    pbf_blob.add_int32(osmium::io::detail::FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(data.size()));
+    pbf_blob.add_bytes(osmium::io::detail::FileFormat::Blob::optional_bytes_lzma_data, compressed);
+
+    std::string output;
+    const auto view = osmium::io::detail::decode_blob(blob, output);
+    REQUIRE(std::string(view.data(), view.size()) == data);
+
+    std::string wrong_size_blob;
+    protozero::pbf_builder<osmium::io::detail::FileFormat::Blob> pbf_wrong_size_blob{wrong_size_blob};
+    pbf_wrong_size_blob.add_int32(osmium::io::detail::FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(data.size() + 1));
+    pbf_wrong_size_blob.add_bytes(osmium::io::detail::FileFormat::Blob::optional_bytes_lzma_data, compressed);
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_blob(wrong_size_blob, output), osmium::io_error);
+}
+#endif
@@ -0,0 +1,377 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/stat.h>
+#endif
+
+namespace {
+
+// Write a PBF file which has several blobs with nodes and one with ways.
+void write_test_file(const std::string& filename, const char* format = "pbf") {
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int i = 1; i <= 20001; ++i) {
+        osmium::builder::add_node(buffer,
+            osmium::builder::attr::_id(i),
+            osmium::builder::attr::_location(i * 0.0001, 1.0)
+        );
+    }
+
+    for (int i = 1; i <= 10; ++i) {
+        osmium::builder::add_way(buffer,
+            osmium::builder::attr::_id(i),
+            osmium::builder::attr::_nodes({i, i + 1})
+        );
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+std::vector<osmium::object_id_type> read_ids(osmium::io::Reader& reader) {
+    std::vector<osmium::object_id_type> ids;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.type() == osmium::item_type::node ? object.id() : -object.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Create PBF blob index without types") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    REQUIRE(index.size() == 4);
+    REQUIRE(index.file_size() == osmium::file_size(filename));
+
+    std::uint64_t last_offset = 0;
+    for (const auto& blob : index) {
+        REQUIRE(blob.offset > last_offset);
+        REQUIRE(blob.size > 0);
+        REQUIRE(blob.entity_bits() == osmium::osm_entity_bits::all);
+        last_offset = blob.offset;
+    }
+    REQUIRE(index[3].offset + index[3].size == index.file_size());
+}
+
+TEST_CASE("Create PBF blob index with types") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename, true);
+    REQUIRE(index.size() == 4);
+    REQUIRE(index[0].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[1].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[2].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[3].entity_bits() == osmium::osm_entity_bits::way);
+}
+
+TEST_CASE("Dump and load PBF blob index") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename, true);
+
+    const std::string index_filename = "test-pbf-blob-index.idx";
+    const int fd = osmium::io::detail::open_for_writing(index_filename, osmium::io::overwrite::allow);
+    index.dump(fd);
+    osmium::io::detail::reliable_close(fd);
+
+    osmium::io::PBFBlobIndex loaded_index;
+    const int fd_in = osmium::io::detail::open_for_reading(index_filename);
+    loaded_index.load(fd_in);
+    osmium::io::detail::reliable_close(fd_in);
+
+    REQUIRE(loaded_index.file_size() == index.file_size());
+    REQUIRE(loaded_index.size() == index.size());
+    for (std::size_t i = 0; i < index.size(); ++i) {
+        REQUIRE(loaded_index[i].offset == index[i].offset);
+        REQUIRE(loaded_index[i].size == index[i].size);
+        REQUIRE(loaded_index[i].types == index[i].types);
+        REQUIRE(loaded_index[i].bbox == index[i].bbox);
+    }
+}
+
+TEST_CASE("Load PBF blob index in old format without bounding boxes") {
+    std::string data{"OSMPBFBI"};
+    const std::uint32_t version = 1;
+    const std::uint32_t record_size = 16;
+    const std::uint64_t file_size = 1000;
+    const std::uint64_t count = 1;
+    const std::uint64_t offset = 100;
+    const std::uint32_t size = 900;
+    const std::uint32_t types = osmium::osm_entity_bits::way;
+    data.append(reinterpret_cast<const char*>(&version), sizeof(version));
+    data.append(reinterpret_cast<const char*>(&record_size), sizeof(record_size));
+    data.append(reinterpret_cast<const char*>(&file_size), sizeof(file_size));
+    data.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    data.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    data.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    data.append(reinterpret_cast<const char*>(&types), sizeof(types));
+
+    const std::string index_filename = "test-pbf-blob-index-v1.idx";
+    const int fd = osmium::io::detail::open_for_writing(index_filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+
+    osmium::io::PBFBlobIndex index;
+    const int fd_in = osmium::io::detail::open_for_reading(index_filename);
+    index.load(fd_in);
+    osmium::io::detail::reliable_close(fd_in);
+
+    REQUIRE(index.file_size() == 1000);
+    REQUIRE(index.size() == 1);
+    REQUIRE(index[0].offset == 100);
+    REQUIRE(index[0].size == 900);
+    REQUIRE(index[0].entity_bits() == osmium::osm_entity_bits::way);
+    REQUIRE_FALSE(index[0].bbox.valid());
+}
+
+TEST_CASE("Loading something that is not a PBF blob index fails") {
+    osmium::io::PBFBlobIndex index;
+    const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/data.osm"));
+    REQUIRE_THROWS_AS(index.load(fd), osmium::pbf_error);
+    osmium::io::detail::reliable_close(fd);
+}
+
+#ifndef _WIN32
+TEST_CASE("Read PBF file using blob index gives same result as sequential read") {
+    const int count = count_fds();
+
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+
+    osmium::io::Reader reader_seq{filename};
+    const auto ids_seq = read_ids(reader_seq);
+    REQUIRE(ids_seq.size() == 20011);
+
+    SECTION("with default pool") {
+        osmium::io::Reader reader_idx{filename, index};
+        REQUIRE(read_ids(reader_idx) == ids_seq);
+    }
+
+    SECTION("with own pool") {
+        osmium::thread::Pool pool{4};
+        osmium::io::Reader reader_idx{filename, index, pool};
+        REQUIRE(read_ids(reader_idx) == ids_seq);
+    }
+
+    SECTION("with memory mapping") {
+        osmium::io::Reader reader_idx{filename, index, osmium::io::use_mmap::yes};
+        REQUIRE(read_ids(reader_idx) == ids_seq);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Restart reading PBF file in the middle using blob index") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    auto index = osmium::io::create_pbf_blob_index(filename);
+    index.remove_first(3);
+    REQUIRE(index.size() == 1);
+
+    osmium::io::Reader reader{filename, index};
+    REQUIRE(reader.header().get("generator").substr(0, 7) == "libosmi");
+    const auto ids = read_ids(reader);
+    REQUIRE(ids.size() == 10);
+    REQUIRE(ids.front() == -1);
+}
+
+TEST_CASE("Blob index is not used when reading PBF file from a pipe") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+
+    osmium::io::Reader reader_seq{filename};
+    const auto ids_seq = read_ids(reader_seq);
+
+    const std::string fifo_name = "test-pbf-blob-index-fifo.osm.pbf";
+    std::remove(fifo_name.c_str());
+    REQUIRE(::mkfifo(fifo_name.c_str(), 0600) == 0);
+
+    std::thread writer{[&]() {
+        std::ifstream in{filename, std::ios::binary};
+        std::ofstream out{fifo_name, std::ios::binary};
+        out << in.rdbuf();
+    }};
+
+    osmium::io::Reader reader{fifo_name, index};
+    const auto ids = read_ids(reader);
+    writer.join();
+    std::remove(fifo_name.c_str());
+
+    REQUIRE(ids == ids_seq);
+}
+
+TEST_CASE("Reading PBF file with blob index for different file fails") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename);
+
+    osmium::io::PBFBlobIndex index{12345};
+    osmium::io::Reader reader{filename, index};
+    REQUIRE_THROWS_AS(reader.read(), osmium::pbf_error);
+}
+#endif
+
+TEST_CASE("Create PBF blob index using types from indexdata") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename, "pbf,pbf_indexdata=true");
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    REQUIRE(index.size() == 4);
+    REQUIRE(index[0].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[1].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[2].entity_bits() == osmium::osm_entity_bits::node);
+    REQUIRE(index[3].entity_bits() == osmium::osm_entity_bits::way);
+
+    REQUIRE(index[0].bbox == osmium::Box(0.0001, 1.0, 0.8, 1.0));
+    REQUIRE(index[1].bbox == osmium::Box(0.8001, 1.0, 1.6, 1.0));
+    REQUIRE(index[2].bbox == osmium::Box(1.6001, 1.0, 2.0001, 1.0));
+    REQUIRE_FALSE(index[3].bbox.valid());
+}
+
+TEST_CASE("Blobs without wanted entity types are skipped") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename, "pbf,pbf_indexdata=true");
+
+    // Destroy the data in all node blobs. Reading only ways must still
+    // work, because those blobs are never decoded.
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    {
+        std::fstream file{filename, std::ios::binary | std::ios::in | std::ios::out};
+        for (std::size_t i = 0; i < 3; ++i) {
+            file.seekp(static_cast<std::streamoff>(index[i].offset));
+            const std::string garbage(index[i].size, '\xff');
+            file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+    }
+
+    SECTION("reading sequentially") {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way};
+        REQUIRE(read_ids(reader).size() == 10);
+    }
+
+    SECTION("reading from memory mapping") {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way, osmium::io::use_mmap::yes};
+        REQUIRE(read_ids(reader).size() == 10);
+    }
+
+    SECTION("reading from buffer") {
+        std::ifstream in{filename, std::ios::binary};
+        const std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        osmium::io::Reader reader{osmium::io::File{data.data(), data.size(), "pbf"}, osmium::osm_entity_bits::way};
+        REQUIRE(read_ids(reader).size() == 10);
+    }
+
+#ifndef _WIN32
+    SECTION("reading with blob index") {
+        osmium::io::Reader reader{filename, index, osmium::osm_entity_bits::way};
+        REQUIRE(read_ids(reader).size() == 10);
+    }
+#endif
+
+    SECTION("nodes can not be read") {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::node};
+        REQUIRE_THROWS(read_ids(reader));
+    }
+}
+
+TEST_CASE("Node blobs outside the bounding box are skipped") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename, "pbf,pbf_indexdata=true");
+
+    // Destroy the data in the first and last node blob. They are outside
+    // the bounding box and must never be decoded.
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    {
+        std::fstream file{filename, std::ios::binary | std::ios::in | std::ios::out};
+        for (std::size_t i : {0U, 2U}) {
+            file.seekp(static_cast<std::streamoff>(index[i].offset));
+            const std::string garbage(index[i].size, '\xff');
+            file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+        }
+    }
+
+    const osmium::Box box{0.9, 0.5, 1.5, 1.5};
+
+    std::vector<osmium::object_id_type> expected;
+    for (int i = 8001; i <= 16000; ++i) {
+        expected.push_back(i);
+    }
+    for (int i = 1; i <= 10; ++i) {
+        expected.push_back(-i);
+    }
+
+    SECTION("reading sequentially") {
+        osmium::io::Reader reader{filename, box};
+        REQUIRE(read_ids(reader) == expected);
+    }
+
+    SECTION("reading from memory mapping") {
+        osmium::io::Reader reader{filename, box, osmium::io::use_mmap::yes};
+        REQUIRE(read_ids(reader) == expected);
+    }
+
+#ifndef _WIN32
+    SECTION("reading with blob index") {
+        osmium::io::Reader reader{filename, index, box};
+        REQUIRE(read_ids(reader) == expected);
+    }
+#endif
+
+    SECTION("without bounding box the broken blobs are read") {
+        osmium::io::Reader reader{filename};
+        REQUIRE_THROWS(read_ids(reader));
+    }
+}
+
+#ifndef _WIN32
+TEST_CASE("Offset is updated for skipped blobs when reading with blob index") {
+    const std::string filename = "test-pbf-blob-index.osm.pbf";
+    write_test_file(filename, "pbf,pbf_indexdata=true");
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    REQUIRE(index.size() == 4);
+
+    // The last blob contains the ways, it is skipped.
+    osmium::io::Reader reader{filename, index, osmium::osm_entity_bits::node};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        count += buffer.select<osmium::OSMObject>().size();
+    }
+    REQUIRE(count == 20001);
+    REQUIRE(reader.offset() == reader.file_size());
+    reader.close();
+}
+#endif
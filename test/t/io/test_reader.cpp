@@ -5,12 +5,19 @@
 #include <osmium/handler.hpp>
 #include <osmium/io/any_compression.hpp>
 #include <osmium/io/any_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/writer.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/visitor.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <fstream>
 #include <iterator>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 struct CountHandler : public osmium::handler::Handler {
@@ -235,6 +242,50 @@ TEST_CASE("Reader should decode zero node positions in history (PBF)") {
     REQUIRE(count == count_fds());
 }
 
+namespace {
+
+int count_nodes(const std::string& filename, osmium::io::use_mmap mmap) {
+    osmium::io::Reader reader{with_data_dir(filename.c_str()), mmap};
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+    return handler.count;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Reader with memory mapping gives same results as without") {
+    const int count = count_fds();
+
+    for (const auto* filename : {"t/io/deleted_nodes.osh.pbf",
+                                 "t/io/data_pbf_version-1.osm.pbf",
+                                 "t/io/data_pbf_version-1-densenodes.osm.pbf",
+                                 "t/io/data.opl",
+                                 "t/io/data-cr.opl",
+                                 "t/io/data-nonl.opl",
+                                 "t/io/data-n5w1r3.osm.opl"}) {
+        const int nodes = count_nodes(filename, osmium::io::use_mmap::no);
+        REQUIRE(nodes > 0);
+        REQUIRE(count_nodes(filename, osmium::io::use_mmap::yes) == nodes);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Reader with memory mapping sets offset") {
+    osmium::io::Reader reader{with_data_dir("t/io/data.opl"), osmium::io::use_mmap::yes};
+    while (reader.read()) {
+    }
+    REQUIRE(reader.offset() == reader.file_size());
+}
+
+TEST_CASE("Reader ignores memory mapping for compressed files") {
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm.gz"), osmium::io::use_mmap::yes};
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
 TEST_CASE("Reader should fail with nonexistent file") {
     const int count = count_fds();
 
@@ -385,3 +436,149 @@ TEST_CASE("Reader with single object type per buffer") {
     check_buffer_counts("t/io/data-n5w1r0", {{5, 0, 0}, {0, 1, 0}}, osmium::io::buffers_type::single);
 }
 
+namespace {
+
+void add_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80U) {
+        out += static_cast<char>((value & 0x7fU) | 0x80U);
+        value >>= 7U;
+    }
+    out += static_cast<char>(value);
+}
+
+void add_zvarint(std::string& out, int64_t value) {
+    add_varint(out, (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void add_dataset(std::string& out, char type, const std::string& dataset) {
+    out += type;
+    add_varint(out, dataset.size());
+    out += dataset;
+}
+
+// Write an o5m file with the given number of nodes and ways. Like most
+// real o5m files, it only has resets before the node, way, and relation
+// sections. The tags use the string table, so they can only be decoded
+// correctly with all the data since the last reset.
+void write_big_o5m_file(const std::string& filename, int num_nodes, int num_ways) {
+    std::string data{"\xff\xe0\x04o5m2"};
+
+    data += '\xff';
+    for (int i = 1; i <= num_nodes; ++i) {
+        std::string node;
+        add_zvarint(node, 1); // id delta
+        node += '\0'; // no metadata
+        add_zvarint(node, (i % 2) ? 1000 : -999); // lon delta
+        add_zvarint(node, 10); // lat delta
+        if (i % 10 == 1 && i > 1) {
+            add_varint(node, 1); // repeat last string pair
+        } else {
+            node += '\0';
+            node += "name";
+            node += '\0';
+            node += "node number ";
+            node += std::to_string(i);
+            node += '\0';
+        }
+        add_dataset(data, '\x10', node);
+    }
+
+    data += '\xff';
+    for (int i = 1; i <= num_ways; ++i) {
+        std::string way;
+        add_zvarint(way, 1);
+        way += '\0';
+        std::string refs;
+        add_zvarint(refs, i == 1 ? 1 : -1);
+        add_zvarint(refs, 1);
+        add_zvarint(refs, 1);
+        add_varint(way, refs.size());
+        way += refs;
+        way += '\0';
+        way += "highway";
+        way += '\0';
+        way += "residential";
+        way += '\0';
+        add_dataset(data, '\x11', way);
+    }
+
+    data += '\xfe';
+
+    std::ofstream out{filename, std::ios::binary};
+    out << data;
+}
+
+// Read all objects and return them in OPL format. (The raw buffer
+// contents can not be compared, because padding bytes are not
+// initialized.)
+std::string read_all_objects(const osmium::io::File& file, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) {
+    const std::string out_filename = "test-o5m-parallel-out.opl";
+    osmium::io::Reader reader{file, entities};
+    osmium::io::Writer writer{out_filename, osmium::io::overwrite::allow};
+    while (auto buffer = reader.read()) {
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+
+    std::ifstream in{out_filename};
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+} // anonymous namespace
+
+TEST_CASE("Decode o5m in parallel gives same result as sequential decode") {
+    const std::string filename = "test-o5m-parallel.o5m";
+
+    // The node section is larger than the largest chunk, so most of it
+    // is decoded in the parser thread. The way section is small enough
+    // to be decoded on the pool.
+    write_big_o5m_file(filename, 300000, 30000);
+
+    const auto serial = read_all_objects(osmium::io::File{filename});
+    REQUIRE(std::count(serial.cbegin(), serial.cend(), '\n') == 330000);
+
+    osmium::io::File file{filename};
+    file.set("parallel_parsing");
+
+    SECTION("all objects") {
+        REQUIRE(read_all_objects(file) == serial);
+    }
+
+    SECTION("with only some entity types") {
+        REQUIRE(read_all_objects(file, osmium::osm_entity_bits::way) ==
+                read_all_objects(osmium::io::File{filename}, osmium::osm_entity_bits::way));
+    }
+
+    SECTION("header only") {
+        osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+        REQUIRE_FALSE(reader.header().has_multiple_object_versions());
+        REQUIRE_FALSE(reader.read());
+        reader.close();
+    }
+
+    SECTION("single object type per buffer") {
+        osmium::io::Reader reader{file, osmium::io::buffers_type::single};
+        std::size_t count = 0;
+        while (const auto buffer = reader.read()) {
+            auto type = osmium::item_type::undefined;
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                REQUIRE((type == osmium::item_type::undefined || type == object.type()));
+                type = object.type();
+                ++count;
+            }
+        }
+        reader.close();
+        REQUIRE(count == 330000);
+    }
+}
+
+TEST_CASE("Decode small o5m file in parallel") {
+    for (const auto* name : {"t/io/data-n5w1r3.osm.o5m", "t/io/data-n0w1r3.osm.o5m"}) {
+        osmium::io::File file{with_data_dir(name)};
+        file.set("parallel_parsing");
+        REQUIRE(read_all_objects(file) == read_all_objects(osmium::io::File{with_data_dir(name)}));
+    }
+}
@@ -7,6 +7,7 @@
 #include <osmium/io/xml_input.hpp>
 #include <osmium/io/xml_output.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 
 #include <algorithm>
 #include <iterator>
@@ -91,6 +92,63 @@ TEST_CASE("Writer: Successful writes writing buffer") {
     REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
 }
 
+TEST_CASE("Writer: Successful writes with parallel compression") {
+    const int count = count_fds();
+
+    auto buffer = get_and_check_buffer();
+    const auto num = buffer.select<osmium::OSMObject>().size();
+
+    std::string filename;
+    bool parallel_decompression = false;
+
+    SECTION("gzip") {
+        filename = "test-writer-out-parallel.osm.gz";
+    }
+
+    SECTION("bzip2") {
+        filename = "test-writer-out-parallel.osm.bz2";
+    }
+
+    SECTION("gzip with parallel decompression") {
+        filename = "test-writer-out-parallel-both.osm.gz";
+        parallel_decompression = true;
+    }
+
+    SECTION("bzip2 with parallel decompression") {
+        filename = "test-writer-out-parallel-both.osm.bz2";
+        parallel_decompression = true;
+    }
+
+    osmium::io::File file{filename};
+    file.set("parallel_compression", true);
+    file.set("compression_block_size", "1024");
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(count == count_fds());
+
+    osmium::io::File input_file{filename};
+    if (parallel_decompression) {
+        input_file.set("parallel_decompression", true);
+    }
+    osmium::io::Reader reader_check{input_file};
+    const osmium::memory::Buffer buffer_check = reader_check.read();
+    REQUIRE(buffer_check);
+    REQUIRE(buffer_check.select<osmium::OSMObject>().size() == num);
+    REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
+    reader_check.close();
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Writer: Invalid compression block size") {
+    osmium::io::File file{"test-writer-out-invalid-block-size.osm.gz"};
+    file.set("parallel_compression", true);
+    file.set("compression_block_size", "10");
+    REQUIRE_THROWS_AS(osmium::io::Writer(file, osmium::io::overwrite::allow), std::invalid_argument);
+}
+
 TEST_CASE("Writer: Successful writes writing items") {
     const int count = count_fds();
 
@@ -117,6 +175,31 @@ TEST_CASE("Writer: Successful writes writing items") {
     REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
 }
 
+TEST_CASE("Writer: Successful writes with buffer pool") {
+    osmium::memory::BufferPool pool;
+
+    auto buffer = get_buffer();
+    const auto num = buffer.select<osmium::OSMObject>().size();
+
+    const std::string filename = "test-writer-out-pool.osm";
+    osmium::io::Writer writer{filename, pool, osmium::io::overwrite::allow};
+    writer.set_buffer_size(1000);
+    for (const auto& item : buffer) {
+        writer(item);
+    }
+    writer(std::move(buffer));
+    writer.close();
+
+    // all internal buffers and the buffer written come back to the pool
+    const auto stats = pool.stats();
+    REQUIRE(stats.gets > 1);
+    REQUIRE(stats.puts == stats.gets + 1);
+
+    osmium::io::Reader reader_check{filename};
+    const osmium::memory::Buffer buffer_check = reader_check.read();
+    REQUIRE(buffer_check.select<osmium::OSMObject>().size() == 2 * num);
+}
+
 TEST_CASE("Writer: Successful writes using output iterator") {
     const int count = count_fds();
 
@@ -0,0 +1,383 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/xml_input_format.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace oid = osmium::io::detail;
+
+namespace {
+
+// Records all calls from the scanner as text.
+class recording_handler {
+
+public:
+
+    std::string events;
+
+    void start_element(const char* element, const char** attrs) {
+        events += '<';
+        events += element;
+        while (*attrs) {
+            events += ' ';
+            events += attrs[0];
+            events += '=';
+            events += attrs[1];
+            attrs += 2;
+        }
+        events += '>';
+    }
+
+    void end_element(const char* element) {
+        events += "</";
+        events += element;
+        events += '>';
+    }
+
+    void characters(const char* text, int len) {
+        events += '[';
+        events.append(text, static_cast<std::size_t>(len));
+        events += ']';
+    }
+
+}; // class recording_handler
+
+std::string scan(const std::string& input) {
+    recording_handler handler;
+    oid::XMLScanner<recording_handler> scanner{handler};
+    scanner(input, true);
+    return handler.events;
+}
+
+// Scan input given in pieces of the specified size.
+std::string scan_pieces(const std::string& input, std::size_t size) {
+    recording_handler handler;
+    oid::XMLScanner<recording_handler> scanner{handler};
+    for (std::size_t pos = 0; pos < input.size(); pos += size) {
+        scanner(input.substr(pos, size), false);
+    }
+    scanner(std::string{}, true);
+    return handler.events;
+}
+
+uint64_t error_line(const std::string& input) {
+    try {
+        scan(input);
+    } catch (const osmium::xml_error& e) {
+        return e.line;
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+TEST_CASE("XML scanner: elements and attributes") {
+    REQUIRE(scan("<osm/>") == "<osm></osm>");
+    REQUIRE(scan("<osm a=\"1\" b='2'></osm>") == "<osm a=1 b=2></osm>");
+    REQUIRE(scan("<osm a = \"x y\" ><nd ref=\"3\"/></osm >") == "<osm a=x y><nd ref=3></nd></osm>");
+    REQUIRE(scan("<osm a=\"x>y\" b='\"'/>") == "<osm a=x>y b=\"></osm>");
+}
+
+TEST_CASE("XML scanner: references in attributes are decoded") {
+    REQUIRE(scan("<osm a=\"&lt;&gt;&amp;&quot;&apos;\"/>") == "<osm a=<>&\"'></osm>");
+    REQUIRE(scan("<osm a=\"&#65;&#x42;&#xe4;&#x20AC;&#x1F600;\"/>") == "<osm a=AB\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80></osm>");
+    REQUIRE(scan("<osm a=\"x\ny\tz\r\nw\"/>") == "<osm a=x y z w></osm>");
+    REQUIRE(scan("<osm a=\"&#10;\"/>") == "<osm a=\n></osm>");
+}
+
+TEST_CASE("XML scanner: text, comments, CDATA, and processing instructions") {
+    const std::string input{"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                            "<!-- comment <node> -->\n"
+                            "<osm>a&amp;b<!-- x --><![CDATA[<c>]]>\r\nd</osm>\n"};
+    REQUIRE(scan(input) == "<osm>[a&b][<c>][\nd]</osm>");
+    REQUIRE(scan("<!DOCTYPE osm><osm/>") == "<osm></osm>");
+}
+
+TEST_CASE("XML scanner: input in pieces") {
+    const std::string input{"<?xml version='1.0'?>\n<osm version=\"0.6\">\n"
+                            "  <node id=\"1\" user=\"&lt;foo&gt;\"><tag k=\"a\" v=\"b\"/></node>\n"
+                            "  <!-- comment -->\n"
+                            "  <changeset id=\"2\"><discussion><comment><text>x &amp; y</text></comment></discussion></changeset>\n"
+                            "</osm>\n"};
+    const std::string expected = scan(input);
+    for (std::size_t size = 1; size <= input.size(); ++size) {
+        REQUIRE(scan_pieces(input, size) == expected);
+    }
+}
+
+TEST_CASE("XML scanner: errors") {
+    REQUIRE_THROWS_AS(scan(""), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm></node>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm/><osm/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("foo<osm/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a=\"&foo;\"/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a=\"&#0;\"/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a=\"&#xd800;\"/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a=\"1\"b=\"2\"/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a=1/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm a=\"<\"/>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<osm><!-- x </osm>"), osmium::xml_error);
+    REQUIRE_THROWS_AS(scan("<!DOCTYPE osm [<!ENTITY x \"y\">]><osm/>"), osmium::xml_error);
+}
+
+TEST_CASE("XML scanner: errors have line numbers") {
+    REQUIRE(error_line("<osm>\n<node>\n</way>\n</osm>") == 3);
+    REQUIRE(error_line("<osm>\n<!--\n\n-->\n<node a=\"&x;\"/>") == 5);
+    REQUIRE(error_line("<osm>\n<node\na=\"1\"\nb=\"&x;\"/>") == 2);
+}
+
+TEST_CASE("XML chunk finder") {
+    const std::string data{"<?xml version='1.0'?>\n"
+                           "<osmChange version=\"0.6\">\n"
+                           "<!-- <node id=\"9\"/> -->\n"
+                           "<create><node id=\"1\"/><way id=\"2\"/></create>\n"
+                           "<delete><relation id=\"3\"/></delete>\n"
+                           "</osmChange>\n"};
+
+    oid::XMLChunkFinder finder;
+    const auto first = finder.find(data, 0, true);
+    REQUIRE(data.compare(first, 13, "<node id=\"1\"/") == 0);
+    REQUIRE(finder.prefix() == "<osmChange version=\"0.6\"><create>");
+
+    const auto second = finder.find(data, first + 1, true);
+    REQUIRE(data.compare(second, 12, "<way id=\"2\"/") == 0);
+    REQUIRE(finder.prefix() == "<osmChange version=\"0.6\"><create>");
+
+    const auto third = finder.find(data, second + 1, true);
+    REQUIRE(data.compare(third, 17, "<relation id=\"3\"/") == 0);
+    REQUIRE(finder.prefix() == "<osmChange version=\"0.6\"><delete>");
+
+    REQUIRE(finder.find(data, third + 1, true) == std::string::npos);
+}
+
+TEST_CASE("XML chunk finder needs more data") {
+    const std::string data{"<osm version=\"0.6\">\n<no"};
+
+    oid::XMLChunkFinder finder;
+    REQUIRE(finder.find(data, 0, false) == std::string::npos);
+
+    const std::string more = data + "de id=\"1\"/>\n</osm>\n";
+    REQUIRE(finder.find(more, 0, false) == 20);
+}
+
+namespace {
+
+std::string read_file(const std::string& filename) {
+    std::ifstream in{filename};
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// Read an XML file and write everything into an OPL file for comparison.
+std::string xml_to_opl(const osmium::io::File& file, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) {
+    const std::string out_name{"test-xml-scanner-out.opl"};
+    osmium::io::Reader reader{file, entities};
+    osmium::io::Writer writer{out_name, osmium::io::overwrite::allow};
+    while (auto buffer = reader.read()) {
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+    return read_file(out_name);
+}
+
+void write_big_xml_file(const std::string& filename) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 20000; ++i) {
+        osmium::builder::add_node(buffer,
+            _id(i),
+            _version(i % 3 + 1),
+            _visible(i % 7 != 0),
+            _user("user <&> \"'"),
+            _location(i * 0.001, 2.5),
+            _tag("name", "node & \xc3\xa4")
+        );
+    }
+    for (int i = 1; i <= 5000; ++i) {
+        osmium::builder::add_way(buffer,
+            _id(i),
+            _version(1),
+            _nodes({i, i + 1, i + 2}),
+            _tag("highway", "residential")
+        );
+    }
+    for (int i = 1; i <= 100; ++i) {
+        osmium::builder::add_relation(buffer,
+            _id(i),
+            _member(osmium::item_type::way, i, "outer"),
+            _member(osmium::item_type::node, i, "")
+        );
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+} // anonymous namespace
+
+TEST_CASE("Reading XML files with scanner gives same result as with Expat") {
+    for (const auto* name : {"t/io/data.osm",
+                             "t/io/data-n0w1r3.osm",
+                             "t/io/data-n5w1r3.osm",
+                             "t/io/data_pbf_version-1.osm"}) {
+        const std::string filename{with_data_dir(name)};
+        const auto expected = xml_to_opl(osmium::io::File{filename});
+        REQUIRE_FALSE(expected.empty());
+
+        osmium::io::File file{filename};
+        file.set("xml_parser", "scanner");
+        REQUIRE(xml_to_opl(file) == expected);
+
+        osmium::io::File parallel_file{filename};
+        parallel_file.set("parallel_parsing");
+        REQUIRE(xml_to_opl(parallel_file) == expected);
+    }
+}
+
+TEST_CASE("Reading big XML files in parallel gives same result as with Expat") {
+    for (const std::string filename : {"test-xml-scanner.osm", "test-xml-scanner.osc"}) {
+        write_big_xml_file(filename);
+
+        const auto expected = xml_to_opl(osmium::io::File{filename});
+        REQUIRE(std::count(expected.cbegin(), expected.cend(), '\n') == 25100);
+
+        osmium::io::File file{filename};
+        file.set("parallel_parsing");
+        REQUIRE(xml_to_opl(file) == expected);
+
+        SECTION("with only some entity types") {
+            REQUIRE(xml_to_opl(file, osmium::osm_entity_bits::way) ==
+                    xml_to_opl(osmium::io::File{filename}, osmium::osm_entity_bits::way));
+        }
+
+        SECTION("with own pool and single type buffers") {
+            osmium::thread::Pool pool{3};
+            osmium::io::Reader reader{file, pool, osmium::io::buffers_type::single};
+            std::size_t count = 0;
+            while (const auto buffer = reader.read()) {
+                const auto objects = buffer.select<osmium::OSMObject>();
+                REQUIRE(objects.size() > 0);
+                const auto type = objects.cbegin()->type();
+                for (const auto& object : objects) {
+                    REQUIRE(object.type() == type);
+                    ++count;
+                }
+            }
+            reader.close();
+            REQUIRE(count == 25100);
+        }
+    }
+}
+
+TEST_CASE("Reading header of XML file in parallel mode") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    file.set("parallel_parsing");
+    osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+    REQUIRE(reader.header().get("generator") == "testdata");
+    REQUIRE_FALSE(reader.read());
+}
+
+TEST_CASE("Errors in XML file read in parallel have the right line number") {
+    const std::string filename{"test-xml-scanner-error.osm"};
+    write_big_xml_file(filename);
+
+    auto data = read_file(filename);
+    const auto pos = data.find("<way id=\"4000\"");
+    REQUIRE(pos != std::string::npos);
+    data.insert(pos + 9, "&x;");
+    {
+        std::ofstream out{filename};
+        out << data;
+    }
+    const auto line = 1 + static_cast<uint64_t>(std::count(data.cbegin(), data.cbegin() + static_cast<std::ptrdiff_t>(pos), '\n'));
+
+    for (const auto* option : {"xml_parser", "parallel_parsing"}) {
+        osmium::io::File file{filename};
+        if (std::string{option} == "xml_parser") {
+            file.set(option, "scanner");
+        } else {
+            file.set(option);
+        }
+        try {
+            xml_to_opl(file);
+            REQUIRE(false);
+        } catch (const osmium::xml_error& e) {
+            REQUIRE(e.line == line);
+        }
+    }
+}
+
+TEST_CASE("XML scanner: end of chunk") {
+    recording_handler handler;
+
+    SECTION("complete objects") {
+        oid::XMLScanner<recording_handler> scanner{handler};
+        scanner("<osm><node id=\"1\"></node>\n  ", false);
+        scanner.end_of_chunk(1);
+    }
+
+    SECTION("incomplete object") {
+        oid::XMLScanner<recording_handler> scanner{handler};
+        scanner("<osm><node id=\"1\"><tag k=\"a\" v=\"b\"/>\n  ", false);
+        REQUIRE_THROWS_AS(scanner.end_of_chunk(1), osmium::xml_error);
+    }
+
+    SECTION("incomplete tag") {
+        oid::XMLScanner<recording_handler> scanner{handler};
+        scanner("<osm><node id=\"1\"/><tag k=\"a\"", false);
+        REQUIRE_THROWS_AS(scanner.end_of_chunk(1), osmium::xml_error);
+    }
+}
+
+TEST_CASE("Truncated object in XML file read in parallel is an error") {
+    const std::string filename{"test-xml-scanner-truncated.osm"};
+    write_big_xml_file(filename);
+
+    // Remove the end tag of the last object before the place where
+    // the parallel parser cuts the first chunk (after 1 MByte).
+    auto data = read_file(filename);
+    oid::XMLChunkFinder finder;
+    const auto first_object = finder.find(data, 0, true);
+    REQUIRE(first_object != std::string::npos);
+    const auto cut = finder.find(data, first_object + 1024UL * 1024UL, true);
+    REQUIRE(cut != std::string::npos);
+    const auto end_tag = data.rfind("</", cut);
+    REQUIRE(data.compare(end_tag, 7, "</node>") == 0);
+    data.erase(end_tag, 7);
+    {
+        std::ofstream out{filename};
+        out << data;
+    }
+
+    for (const auto* option : {"xml_parser", "parallel_parsing"}) {
+        osmium::io::File file{filename};
+        if (std::string{option} == "xml_parser") {
+            file.set(option, "scanner");
+        } else {
+            file.set(option);
+        }
+        REQUIRE_THROWS_AS(xml_to_opl(file), osmium::xml_error);
+    }
+}
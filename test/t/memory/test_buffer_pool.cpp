@@ -0,0 +1,157 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Buffer pool allocates new buffers if empty") {
+    osmium::memory::BufferPool pool;
+
+    const auto buffer = pool.get(1000);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() >= 1000);
+    REQUIRE(buffer.committed() == 0);
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.gets == 1);
+    REQUIRE(stats.hits == 0);
+    REQUIRE(stats.allocated_bytes == buffer.capacity());
+    REQUIRE(stats.hit_rate() == Approx(0.0));
+}
+
+TEST_CASE("Buffer pool reuses memory of returned buffers") {
+    osmium::memory::BufferPool pool;
+
+    auto buffer = pool.get(4096, osmium::memory::Buffer::auto_grow::no);
+    osmium::builder::add_node(buffer, _id(1));
+    const auto* data = buffer.data();
+    pool.put(std::move(buffer));
+    REQUIRE_FALSE(buffer); // NOLINT(bugprone-use-after-move,hicpp-invalid-access-moved)
+
+    auto stats = pool.stats();
+    REQUIRE(stats.puts == 1);
+    REQUIRE(stats.pooled_buffers == 1);
+    REQUIRE(stats.pooled_bytes == 4096);
+    REQUIRE(stats.peak_pooled_bytes == 4096);
+
+    auto buffer2 = pool.get(3000, osmium::memory::Buffer::auto_grow::no);
+    REQUIRE(buffer2.data() == data);
+    REQUIRE(buffer2.capacity() == 4096);
+    REQUIRE(buffer2.committed() == 0);
+    REQUIRE(buffer2.begin() == buffer2.end());
+
+    stats = pool.stats();
+    REQUIRE(stats.gets == 2);
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.pooled_buffers == 0);
+    REQUIRE(stats.pooled_bytes == 0);
+    REQUIRE(stats.peak_pooled_bytes == 4096);
+    REQUIRE(stats.hit_rate() == Approx(0.5));
+
+    // auto_grow setting is honored for recycled buffers
+    osmium::builder::add_node(buffer2, _id(1));
+    pool.put(std::move(buffer2));
+    auto buffer3 = pool.get(4096, osmium::memory::Buffer::auto_grow::yes);
+    for (int i = 0; i < 1000; ++i) {
+        osmium::builder::add_node(buffer3, _id(i));
+    }
+    REQUIRE(buffer3.capacity() > 4096);
+}
+
+TEST_CASE("Buffer pool doesn't use much larger buffers") {
+    osmium::memory::BufferPool pool;
+
+    pool.put(pool.get(100000));
+
+    const auto buffer = pool.get(1000);
+    REQUIRE(buffer.capacity() < 100000);
+    REQUIRE(pool.stats().hits == 0);
+    REQUIRE(pool.stats().pooled_buffers == 1);
+}
+
+TEST_CASE("Buffer pool recycles nested buffers") {
+    osmium::memory::BufferPool pool;
+
+    auto buffer = pool.get(1000, osmium::memory::Buffer::auto_grow::internal);
+    for (int i = 0; i < 100; ++i) {
+        osmium::builder::add_node(buffer, _id(i));
+    }
+    REQUIRE(buffer.has_nested_buffers());
+
+    pool.put(std::move(buffer));
+    REQUIRE(pool.stats().pooled_buffers > 1);
+}
+
+TEST_CASE("Buffer pool ignores buffers with external memory") {
+    osmium::memory::BufferPool pool;
+
+    alignas(8) unsigned char data[64];
+    osmium::memory::Buffer buffer{data, sizeof(data), 0};
+    pool.put(std::move(buffer));
+    pool.put(osmium::memory::Buffer{});
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.puts == 1);
+    REQUIRE(stats.dropped == 1);
+    REQUIRE(stats.pooled_buffers == 0);
+}
+
+TEST_CASE("Buffer pool drops buffers when full") {
+    osmium::memory::BufferPool pool{10000};
+    REQUIRE(pool.max_bytes() == 10000);
+
+    auto b1 = pool.get(8000);
+    auto b2 = pool.get(8000);
+    pool.put(std::move(b1));
+    pool.put(std::move(b2));
+
+    auto stats = pool.stats();
+    REQUIRE(stats.puts == 2);
+    REQUIRE(stats.dropped == 1);
+    REQUIRE(stats.pooled_buffers == 1);
+
+    pool.clear();
+    stats = pool.stats();
+    REQUIRE(stats.pooled_buffers == 0);
+    REQUIRE(stats.pooled_bytes == 0);
+}
+
+TEST_CASE("Shared buffers from pool are returned when last reference is gone") {
+    osmium::memory::BufferPool pool;
+
+    auto shared = pool.share(pool.get(1000));
+    auto copy = shared;
+    shared.reset();
+    REQUIRE(pool.stats().pooled_buffers == 0);
+    copy.reset();
+    REQUIRE(pool.stats().pooled_buffers == 1);
+}
+
+TEST_CASE("Buffer pool can be used from several threads") {
+    osmium::memory::BufferPool pool;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool]() {
+            for (int i = 0; i < 100; ++i) {
+                auto buffer = pool.get(10000);
+                osmium::builder::add_node(buffer, _id(i));
+                pool.put(std::move(buffer));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.gets == 400);
+    REQUIRE(stats.puts == 400);
+    REQUIRE(stats.hits + stats.allocated_bytes / 10000 == 400);
+    REQUIRE(stats.pooled_buffers <= 4);
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include <osmium/thread/bounded_queue.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Basic use of bounded queue") {
+    osmium::thread::BoundedQueue<int> queue;
+    REQUIRE(queue.empty());
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 22);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Bounded queue wraps around") {
+    osmium::thread::BoundedQueue<int> queue{3, "Queue of max size 3"};
+    int value = 0;
+    for (int i = 0; i < 10; ++i) {
+        queue.push(i);
+        queue.push(i + 100);
+        REQUIRE(queue.size() == 2);
+        REQUIRE(queue.try_pop(value));
+        REQUIRE(value == i);
+        queue.wait_and_pop(value);
+        REQUIRE(value == i + 100);
+        REQUIRE(queue.empty());
+        REQUIRE_FALSE(queue.try_pop(value));
+    }
+}
+
+TEST_CASE("When bounded queue is shut down, nothing goes in or out") {
+    osmium::thread::BoundedQueue<std::string> queue{10};
+    REQUIRE(queue.in_use());
+    REQUIRE(queue.empty());
+    queue.push("foo");
+    queue.push("bar");
+    queue.push("baz");
+    REQUIRE(queue.size() == 3);
+
+    std::string value;
+
+    queue.wait_and_pop(value);
+    REQUIRE(value == "foo");
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.in_use());
+    queue.shutdown();
+    REQUIRE_FALSE(queue.in_use());
+    REQUIRE(queue.empty());
+    queue.push("lost");
+    REQUIRE(queue.empty());
+
+    value.clear();
+    REQUIRE_FALSE(queue.try_pop(value));
+    REQUIRE(value.empty());
+    queue.wait_and_pop(value);
+    REQUIRE(value.empty());
+}
+
+TEST_CASE("Bounded queue has at least two slots") {
+    osmium::thread::BoundedQueue<int> queue{1};
+    queue.push(1);
+    queue.push(2);
+    REQUIRE(queue.size() == 2);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 2);
+}
+
+TEST_CASE("Full bounded queue blocks producer until consumer pops") {
+    osmium::thread::BoundedQueue<int> queue{2};
+    const int num = 10000;
+
+    std::thread producer{[&queue] {
+        for (int i = 1; i <= num; ++i) {
+            queue.push(i);
+            REQUIRE(queue.size() <= 2);
+        }
+        queue.push(0);
+    }};
+
+    std::vector<int> values;
+    int value = -1;
+    while (true) {
+        queue.wait_and_pop(value);
+        if (value == 0) {
+            break;
+        }
+        values.push_back(value);
+    }
+    producer.join();
+
+    REQUIRE(values.size() == num);
+    for (int i = 0; i < num; ++i) {
+        REQUIRE(values[i] == i + 1);
+    }
+}
+
+TEST_CASE("Shutting down bounded queue wakes up blocked threads") {
+    osmium::thread::BoundedQueue<int> full_queue{2};
+    osmium::thread::BoundedQueue<int> empty_queue{2};
+    full_queue.push(1);
+    full_queue.push(2);
+
+    std::thread producer{[&full_queue] {
+        full_queue.push(3);
+    }};
+
+    int value = 0;
+    std::thread consumer{[&empty_queue, &value] {
+        empty_queue.wait_and_pop(value);
+    }};
+
+    full_queue.shutdown();
+    empty_queue.shutdown();
+    producer.join();
+    consumer.join();
+
+    REQUIRE(full_queue.empty());
+    REQUIRE(empty_queue.empty());
+    REQUIRE(value == 0);
+}
@@ -2,7 +2,12 @@
 
 #include <osmium/thread/pool.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -43,6 +48,11 @@ TEST_CASE("number of threads in pool") {
     REQUIRE(osmium::thread::detail::get_pool_size(-100, 0, 16) ==  1);
     REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 16) == 32);
 
+    // more threads allowed on machines with many cores
+    REQUIRE(osmium::thread::detail::get_pool_size(  64, 0, 96) == 64);
+    REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 96) == 96);
+    REQUIRE(osmium::thread::detail::get_pool_size(  -2, 0, 96) == 94);
+
 }
 
 TEST_CASE("if zero number of threads requested, threads configured") {
@@ -104,3 +114,86 @@ TEST_CASE("can throw from job in user provided thread pool") {
     REQUIRE_THROWS_AS(future.get(), std::runtime_error);
 }
 
+TEST_CASE("all jobs are done even if the queues are full") {
+    osmium::thread::Pool pool{2, 1};
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([i]() { return i; }));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(futures[i].get() == i);
+    }
+}
+
+TEST_CASE("jobs can submit jobs to the same pool") {
+    osmium::thread::Pool pool{2, 1};
+    auto future = pool.submit([&pool]() {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i) {
+            futures.push_back(pool.submit(test_job_with_result{}));
+        }
+        int sum = 0;
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+        return sum;
+    });
+    REQUIRE(future.get() == 4200);
+}
+
+TEST_CASE("jobs submitted before the pool is destroyed are done") {
+    std::vector<std::future<int>> futures;
+    {
+        osmium::thread::Pool pool{3};
+        for (int i = 0; i < 100; ++i) {
+            futures.push_back(pool.submit(test_job_with_result{}));
+        }
+    }
+    for (auto& future : futures) {
+        REQUIRE(future.get() == 42);
+    }
+}
+
+TEST_CASE("max queue size is the limit for all queues together") {
+    osmium::thread::Pool pool{2, 3};
+
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::atomic<int> started{0};
+    std::vector<std::future<void>> blockers;
+    for (int i = 0; i < 2; ++i) {
+        blockers.push_back(pool.submit([&started, released]() {
+            ++started;
+            released.wait();
+        }));
+    }
+    while (started < 2) {
+        std::this_thread::yield();
+    }
+    REQUIRE(pool.queue_empty());
+
+    std::vector<std::future<std::thread::id>> futures;
+    for (int i = 0; i < 4; ++i) {
+        futures.push_back(pool.submit([]() {
+            return std::this_thread::get_id();
+        }));
+    }
+    REQUIRE(pool.queue_size() == 3);
+
+    // The fourth task didn't fit and was run in this thread.
+    REQUIRE(futures[3].wait_for(std::chrono::seconds{0}) == std::future_status::ready);
+    REQUIRE(futures[3].get() == std::this_thread::get_id());
+
+    release.set_value();
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(futures[i].get() != std::this_thread::get_id());
+    }
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("jobs submitted after shutdown are done") {
+    osmium::thread::Pool pool{2};
+    pool.shutdown_all_workers();
+    auto future = pool.submit(test_job_with_result{});
+    REQUIRE(future.get() == 42);
+}
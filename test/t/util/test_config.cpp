@@ -67,6 +67,24 @@ TEST_CASE("use_pool_threads_for_pbf_parsing") {
     REQUIRE(osmium::config::use_pool_threads_for_pbf_parsing());
 }
 
+TEST_CASE("use_io_uring") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::use_io_uring());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_IO_URING");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::use_io_uring());
+
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_io_uring());
+    osmium::detail::env = "OFF";
+    REQUIRE_FALSE(osmium::config::use_io_uring());
+    osmium::detail::env = "0";
+    REQUIRE_FALSE(osmium::config::use_io_uring());
+
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_io_uring());
+}
+
 TEST_CASE("get_max_queue_size") {
     osmium::detail::env = nullptr;
     REQUIRE(osmium::config::get_max_queue_size("NAME", 0) == 2);
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <system_error>
 #include <utility>
 
 #if defined(_MSC_VER) || (defined(__GNUC__) && defined(_WIN32))
@@ -412,3 +413,42 @@ TEST_CASE("Anonymous memory mapping class: remapping to smaller size should work
 }
 #endif
 
+
+TEST_CASE("Anonymous memory mapping class: mapping with transparent huge pages and NUMA policy should work") {
+    osmium::memory_mapping_options options;
+    options.pages = osmium::huge_pages::transparent;
+
+    SECTION("interleave") {
+        options.numa = osmium::numa_policy::interleave;
+    }
+
+    SECTION("local") {
+        options.numa = osmium::numa_policy::local;
+    }
+
+    osmium::AnonymousMemoryMapping mapping{4UL * 1024UL * 1024UL, options};
+    REQUIRE(mapping.size() == 4UL * 1024UL * 1024UL);
+
+    auto* addr1 = mapping.get_addr<int>();
+    *addr1 = 42;
+
+#ifdef __linux__
+    mapping.resize(8UL * 1024UL * 1024UL);
+#endif
+
+    const auto* addr2 = mapping.get_addr<int>();
+    REQUIRE(*addr2 == 42);
+}
+
+TEST_CASE("Anonymous memory mapping class: mapping with explicit huge pages") {
+    osmium::memory_mapping_options options;
+    options.pages = osmium::huge_pages::hugetlb;
+
+    // This only works if the system has huge pages reserved
+    try {
+        osmium::AnonymousMemoryMapping mapping{1000, options};
+        REQUIRE(mapping.size() == osmium::MemoryMapping::get_huge_page_size());
+    } catch (const std::system_error&) {
+        WARN("no huge pages available");
+    }
+}